@@ -1,4 +1,4 @@
-#include "RTUSlave.h"
+#include "RtuSlave.h"
 #include <stdio.h>
 
 /* ============================================================
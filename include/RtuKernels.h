@@ -0,0 +1,69 @@
+/**
+ * @file RtuKernels.h
+ * @author xfp23
+ * @brief Vectorised encode / decode kernels for Modbus register and coil data
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ */
+
+#ifndef RTUKERNELS_H
+#define RTUKERNELS_H
+
+#include "Rtu_conf.h"
+#include "stddef.h"
+#include "stdint.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Encode registers for the wire: dst_be[2k] = src[k] >> 8, dst_be[2k + 1] = src[k] & 0xFF.
+ *
+ * @param dst_be Big-endian output, 2 * n bytes
+ * @param src    Registers in host order
+ * @param n      Number of registers
+ */
+extern void RTUKernel_BswapStore16(uint8_t *dst_be, const uint16_t *src, size_t n);
+
+/**
+ * @brief Decode registers from the wire, the inverse of RTUKernel_BswapStore16().
+ *
+ * @param dst    Registers in host order
+ * @param src_be Big-endian input, 2 * n bytes
+ * @param n      Number of registers
+ */
+extern void RTUKernel_BswapLoad16(uint16_t *dst, const uint8_t *src_be, size_t n);
+
+/**
+ * @brief Pack one byte per coil into Modbus bit order (LSB first); any non-zero byte is ON.
+ *
+ * @param dst Receives (n + 7) / 8 bytes, bits past n in the last byte are 0
+ * @param src n coil bytes
+ * @param n   Number of coils
+ */
+extern void RTUKernel_PackBits(uint8_t *dst, const uint8_t *src, size_t n);
+
+/**
+ * @brief Unpack Modbus bits (LSB first) into one byte per coil, 0 or 1.
+ *
+ * @param dst n coil bytes
+ * @param src (n + 7) / 8 packed bytes
+ * @param n   Number of coils
+ */
+extern void RTUKernel_UnpackBits(uint8_t *dst, const uint8_t *src, size_t n);
+
+/**
+ * @brief Instruction set the kernels run with on this CPU.
+ *
+ * @return "avx2", "sse2", "neon" or "scalar" (RTU_SIMD_ENABLE disabled or no vector unit)
+ */
+extern const char *RTUKernel_Name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * @file RtuMaster.h
+ * @author xfp23
+ * @brief Modbus RTU Master Interface (User API)
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ */
+
+#ifndef RTUMASTER_H
+#define RTUMASTER_H
+
+#include "RtuMaster_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialize a timer wheel.
+ *
+ * @param wheel  Wheel to initialize
+ * @param now_us Current time in microseconds (any free-running counter)
+ */
+extern void RTUMaster_WheelInit(RTU_TimerWheel_t *wheel, uint32_t now_us);
+
+/**
+ * @brief Advance a timer wheel and run everything that became due.
+ *
+ * Drives every line sharing the wheel: inter-frame gaps, response
+ * timeouts and end-of-frame detection all expire from here, and the next
+ * queued request of a line goes out as soon as its gap has passed.
+ *
+ * @param wheel  Wheel to advance
+ * @param now_us Current time, same counter as RTUMaster_WheelInit()
+ *               (wraps after 2^32 us)
+ */
+extern void RTUMaster_Tick(RTU_TimerWheel_t *wheel, uint32_t now_us);
+
+/**
+ * @brief Time until the next timer of the wheel is due.
+ *
+ * Use as the sleep / poll() timeout of the event loop. May return less
+ * than the real distance (when timers move down a level), never more.
+ *
+ * @return Microseconds, UINT32_MAX when no timer is armed
+ */
+extern uint32_t RTUMaster_NextTimeout(const RTU_TimerWheel_t *wheel);
+
+/**
+ * @brief Initialize a master line.
+ *
+ * @param line     Line object (caller-owned)
+ * @param wheel    Timer wheel driving the line
+ * @param baud     Line speed, sets the t3.5 gap and frame airtime
+ * @param transmit Sends one frame, must not block for the airtime
+ * @param user     Passed to transmit
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR on invalid parameters
+ */
+extern RTU_Sta_t RTUMaster_Init(RTU_Master_t *line, RTU_TimerWheel_t *wheel, uint32_t baud,
+                                RTUMaster_Transmit_t transmit, void *user);
+
+/**
+ * @brief Set the response timeout of a line (default RTU_MASTER_TIMEOUT_MS).
+ *
+ * @param timeout_us Time from the end of the request to the first response byte
+ */
+extern void RTUMaster_SetTimeout(RTU_Master_t *line, uint32_t timeout_us);
+
+/**
+ * @brief Queue a request; returns at once.
+ *
+ * The request is sent when the line is free and its done callback runs
+ * from RTUMaster_Tick() / RTUMaster_RxBytes() / RTUMaster_RxFrame() with
+ * req->result set.
+ *
+ * @note Supported function codes: 0x01 ~ 0x06, 0x0F, 0x10. Broadcasts
+ *       (id 0) are accepted for 0x05, 0x06, 0x0F and 0x10 only.
+ *
+ * @return RTU_OK when queued
+ * @return RTU_ERR if the request is invalid or does not fit RTU_MASTER_BUF_SIZE
+ */
+extern RTU_Sta_t RTUMaster_Submit(RTU_Master_t *line, RTU_MasterReq_t *req);
+
+/**
+ * @brief Remove a queued request that has not been sent yet.
+ *
+ * Its done callback runs with RTU_MRES_CANCELLED.
+ *
+ * @return RTU_OK when removed
+ * @return RTU_NOACTIVE if it is not queued (already sent or finished)
+ */
+extern RTU_Sta_t RTUMaster_Cancel(RTU_Master_t *line, RTU_MasterReq_t *req);
+
+/**
+ * @brief Feed received bytes (any chunking) to a line.
+ *
+ * The response ends when the expected length is reached or the line has
+ * been silent for t3.5.
+ *
+ * @note With RTU_MASTER_ADAPTIVE the slave turnaround is measured on the
+ *       wheel clock: call RTUMaster_Tick() before feeding the bytes of a wakeup.
+ */
+extern void RTUMaster_RxBytes(RTU_Master_t *line, const uint8_t *data, size_t len);
+
+/**
+ * @brief Feed a complete frame, for drivers that detect the frame end themselves.
+ */
+extern void RTUMaster_RxFrame(RTU_Master_t *line, const uint8_t *data, size_t len);
+
+/**
+ * @brief Requests queued or in progress on a line.
+ */
+extern size_t RTUMaster_Outstanding(const RTU_Master_t *line);
+
+/**
+ * @brief Turnaround statistics and current timeout of one slave (RTU_MASTER_ADAPTIVE).
+ *
+ * @param line  Line the slave is polled on
+ * @param id    Slave id
+ * @param stats Filled on success
+ *
+ * @return RTU_OK on success
+ * @return RTU_NOACTIVE if the slave is not tracked (not polled yet or entry reused)
+ * @return RTU_ERR on invalid parameters or RTU_MASTER_ADAPTIVE disabled
+ */
+extern RTU_Sta_t RTUMaster_SlaveStats(const RTU_Master_t *line, uint8_t id, RTU_MasterSlaveStats_t *stats);
+
+/**
+ * @brief Forget all learned turnaround times of a line; timeouts fall back to the line timeout.
+ */
+extern void RTUMaster_ResetStats(RTU_Master_t *line);
+
+/**
+ * @brief Create a multi-line runtime (RTU_MASTER_RUNTIME).
+ *
+ * Opens and configures every line (raw, non-blocking) and lays out the tag
+ * table; nothing is sent before RTUMaster_RuntimeStart().
+ *
+ * @param conf      Threading model and CPU affinity
+ * @param lines     Line table (copied)
+ * @param lineCount Number of lines
+ * @param tags      Tag table (copied), index = tag handle
+ * @param tagCount  Number of tags
+ *
+ * @return Runtime, NULL on invalid parameters, unopenable lines or
+ *         RTU_MASTER_RUNTIME disabled
+ */
+extern RTU_Runtime_t *RTUMaster_RuntimeCreate(const RTU_RuntimeConf_t *conf, const RTU_LineConf_t *lines, size_t lineCount,
+                                              const RTU_TagConf_t *tags, size_t tagCount);
+
+/**
+ * @brief Start the runtime threads; polling begins at once. Only once per runtime.
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if already started or a thread could not be created
+ */
+extern RTU_Sta_t RTUMaster_RuntimeStart(RTU_Runtime_t *rt);
+
+/**
+ * @brief Stop polling and join the threads. The tag table stays readable.
+ */
+extern void RTUMaster_RuntimeStop(RTU_Runtime_t *rt);
+
+/**
+ * @brief Stop the runtime, close its lines and free it.
+ */
+extern void RTUMaster_RuntimeDestroy(RTU_Runtime_t *rt);
+
+/**
+ * @brief Read a tag without locking; any number of threads may read at once.
+ *
+ * The runtime thread of the tag's line is the only writer; a read takes a
+ * seqlock snapshot of values and status, so both come from the same poll.
+ *
+ * @param rt     Runtime
+ * @param tag    Index in the tag table
+ * @param values Receives the last good values (may be NULL): uint16_t[num]
+ *               for 0x03 / 0x04, uint8_t[(num + 7) / 8] bits for 0x01 / 0x02
+ * @param info   Receives the status (may be NULL)
+ *
+ * @return RTU_OK on success
+ * @return RTU_NOACTIVE if the tag has no good values yet, or it was being
+ *         written for RTU_SEQLOCK_RETRIES attempts
+ * @return RTU_ERR on invalid parameters or RTU_MASTER_RUNTIME disabled
+ */
+extern RTU_Sta_t RTUMaster_TagRead(const RTU_Runtime_t *rt, size_t tag, void *values, RTU_TagInfo_t *info);
+
+/**
+ * @brief Counters of one runtime line, copied while it runs (each counter is exact, the set is not a snapshot).
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR on invalid parameters or RTU_MASTER_RUNTIME disabled
+ */
+extern RTU_Sta_t RTUMaster_RuntimeCounters(const RTU_Runtime_t *rt, size_t line, RTU_MasterCounters_t *count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef MODBUS_RTU_MASTER_TYPES_H
+#define MODBUS_RTU_MASTER_TYPES_H
+
+#include "RtuSlave_types.h" // RTU_Sta_t, function codes, exception codes
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define RTU_WHEEL_SLOTS (1UL << RTU_MASTER_WHEEL_BITS)
+
+/**
+ * Timer of the hierarchical wheel, embedded in the object it times.
+ * Armed timers sit in one wheel slot list; pprev == NULL means stopped.
+ */
+typedef struct RTU_Timer
+{
+    struct RTU_Timer *next;
+    struct RTU_Timer **pprev;
+    uint32_t expire; // absolute wheel tick
+    void (*fire)(struct RTU_Timer *timer);
+} RTU_Timer_t;
+
+/**
+ * Hierarchical timer wheel shared by any number of master lines.
+ * Level n slots are 2^(n * RTU_MASTER_WHEEL_BITS) ticks wide; timers move
+ * down a level when their slot comes up, so arming, stopping and expiring
+ * are O(1) no matter how many lines and requests are outstanding.
+ */
+typedef struct
+{
+    uint32_t now;    // current tick
+    uint32_t lastUs; // time of the last tick, in RTUMaster_Tick() units
+    size_t armed;    // armed timers, 0 lets idle time be skipped at once
+    RTU_Timer_t *slot[RTU_MASTER_WHEEL_LEVELS][RTU_WHEEL_SLOTS];
+} RTU_TimerWheel_t;
+
+typedef enum
+{
+    RTU_MRES_OK,
+    RTU_MRES_EXCEPTION,    // slave answered with an exception, see req->exception
+    RTU_MRES_TIMEOUT,      // no (complete) response within the timeout
+    RTU_MRES_CRC,          // response with a bad CRC
+    RTU_MRES_BAD_RESPONSE, // valid frame that does not answer the request
+    RTU_MRES_TX_ERR,       // transmit callback failed
+    RTU_MRES_CANCELLED,    // removed with RTUMaster_Cancel()
+} RTU_MasterResult_t;
+
+struct RTU_MasterReq;
+typedef void (*RTUMaster_Done_t)(struct RTU_MasterReq *req);
+
+/**
+ * One master transaction. Owned by the caller and queued without copying;
+ * it must stay valid until its done callback has run.
+ *
+ * data by function code:
+ * - 0x01 / 0x02 / 0x0F: uint8_t[(num + 7) / 8], bits packed LSB first
+ * - 0x03 / 0x04 / 0x10: uint16_t[num]
+ * - 0x05: uint8_t[1] (0 = OFF, else ON), 0x06: uint16_t[1] (num is ignored)
+ */
+typedef struct RTU_MasterReq
+{
+    uint8_t id;   // slave id, RTU_BROADCAST_ID for write broadcasts
+    uint8_t func; // RTU_FunctionCode_t
+    uint16_t addr;
+    uint16_t num;
+    void *data;            // read: filled on success, write: values to send
+    RTUMaster_Done_t done; // completion callback, may submit again
+    void *user;
+
+    RTU_MasterResult_t result;
+    uint8_t exception; // RTU_ExceptionCode_t with RTU_MRES_EXCEPTION
+
+    struct RTU_MasterReq *next; // queue link, internal
+} RTU_MasterReq_t;
+
+/* Send a frame; return < 0 on failure. The buffer is valid until the transaction ends. */
+typedef int (*RTUMaster_Transmit_t)(void *user, const uint8_t *data, size_t len);
+
+typedef enum
+{
+    RTU_MLINE_IDLE, // bus free, next request goes out at once
+    RTU_MLINE_GAP,  // inter-frame gap after a transaction
+    RTU_MLINE_WAIT, // request sent, waiting for the first response byte (or broadcast delay)
+    RTU_MLINE_RX,   // receiving, frame ends on t3.5 silence or expected length
+} RTU_MasterState_t;
+
+typedef struct
+{
+    uint32_t sent;
+    uint32_t ok;
+    uint32_t exceptions;
+    uint32_t timeouts;
+    uint32_t crcErrors;
+    uint32_t badResponses;
+    uint32_t stray; // bytes received while no response was expected
+} RTU_MasterCounters_t;
+
+/**
+ * Turnaround statistics of one slave (RTU_MASTER_ADAPTIVE), see RTUMaster_SlaveStats()
+ */
+typedef struct
+{
+    uint32_t samples;   // responses measured since the last timeout
+    uint32_t meanUs;    // smoothed turnaround: end of request to first response byte
+    uint32_t sigmaUs;   // smoothed standard deviation
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t timeouts;  // timeouts of this slave
+    uint32_t timeoutUs; // response timeout of the next request
+} RTU_MasterSlaveStats_t;
+
+#if RTU_MASTER_ADAPTIVE
+typedef struct
+{
+    uint8_t id;        // 0 = unused
+    uint32_t lastUse;  // line send counter at the last request, for reuse
+    uint32_t samples;
+    uint64_t mean8;    // mean turnaround x 8 (us)
+    uint64_t var;      // variance (us^2)
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t timeouts;
+} RTU_SlaveTiming_t;
+#endif
+
+/**
+ * One serial line. Requests run one at a time in submission order; any
+ * number of lines may share one timer wheel and one thread.
+ */
+typedef struct
+{
+    RTU_Timer_t timer; // gap, response and end-of-frame timer
+    RTU_TimerWheel_t *wheel;
+
+    RTUMaster_Transmit_t transmit;
+    void *user;
+
+    uint32_t baud;
+    uint32_t gapTicks;     // t3.5 at this baud rate
+    uint32_t timeoutTicks; // response timeout, upper bound of learned timeouts
+
+    RTU_MasterState_t state;
+    RTU_MasterReq_t *head; // queued, not yet sent
+    RTU_MasterReq_t *tail;
+    size_t queued;
+    RTU_MasterReq_t *active;
+
+    uint16_t expect; // full response length, 0 = broadcast
+    uint16_t txLen;
+    uint16_t rxLen;
+    uint8_t tx[RTU_MASTER_BUF_SIZE];
+    uint8_t rx[RTU_MASTER_BUF_SIZE];
+
+    RTU_MasterCounters_t count;
+
+#if RTU_MASTER_ADAPTIVE
+    uint32_t sentTick;          // wheel tick at which the request was on the wire
+    uint32_t turnUs;            // turnaround of the response being received
+    uint32_t waitTicks;         // learned timeout of the active request, 0 = line timeout
+    RTU_SlaveTiming_t *timing;  // entry of the active request's slave, NULL = broadcast
+    RTU_SlaveTiming_t slaves[RTU_MASTER_ADAPT_SLAVES];
+#endif
+} RTU_Master_t;
+
+typedef enum
+{
+    RTU_RT_THREAD_PER_LINE, // one thread per serial line
+    RTU_RT_SHARDED,         // lines spread over a fixed number of epoll threads
+} RTU_RuntimeModel_t;
+
+/**
+ * Runtime threads and their CPUs
+ */
+typedef struct
+{
+    RTU_RuntimeModel_t model;
+    size_t shards;    // RTU_RT_SHARDED: threads (0 = one per online CPU), at most one per line
+    const int *cpus;  // thread n runs on cpus[n % cpuCount], NULL = no affinity
+    size_t cpuCount;
+} RTU_RuntimeConf_t;
+
+typedef struct
+{
+    const char *path;   // serial device, e.g. "/dev/ttyS1"
+    uint32_t baud;      // standard termios rate
+    char parity;        // 'N', 'E' or 'O'
+    uint8_t stopBits;   // 1 or 2
+    uint32_t timeoutUs; // response timeout, 0 = RTU_MASTER_TIMEOUT_MS
+} RTU_LineConf_t;
+
+/**
+ * One polled block. Tags of a line are polled in table order.
+ */
+typedef struct
+{
+    size_t line;       // index into the line table
+    uint8_t id;        // slave id, 1 ~ 247
+    uint8_t func;      // 0x01 ~ 0x04
+    uint16_t addr;
+    uint16_t num;      // at most RTU_MASTER_TAG_REGS registers / 16 * RTU_MASTER_TAG_REGS bits
+    uint32_t periodUs; // poll period, 0 = back to back
+} RTU_TagConf_t;
+
+typedef struct
+{
+    uint32_t updates;          // completed polls, good or not
+    RTU_MasterResult_t result; // of the last poll
+    uint8_t exception;
+    uint64_t okTimeUs;         // CLOCK_MONOTONIC time of the values, 0 = never read
+} RTU_TagInfo_t;
+
+/* Opaque, see RTUMaster_RuntimeCreate() */
+typedef struct RTU_Runtime RTU_Runtime_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
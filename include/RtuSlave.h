@@ -1,5 +1,5 @@
 /**
- * @file RTUSlave.h
+ * @file RtuSlave.h
  * @author xfp23
  * @brief Modbus RTU Slave Interface (User API)
  * @version 0.1
@@ -11,7 +11,7 @@
 #ifndef RTUSLAVE_H
 #define RTUSLAVE_H
 
-#include "RTUSlave_types.h"
+#include "RtuSlave_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +33,37 @@ extern "C" {
  */
 extern RTU_Sta_t RTUSlave_Init(void);
 
+/**
+ * @brief Initialize the slave with a caller-supplied memory arena.
+ *
+ * Same as RTUSlave_Init(), but all register metadata created by the
+ * RTUSlave_Register*() calls is carved contiguously from `arena` instead
+ * of the heap. Re-registering a class releases its block and compacts the
+ * arena, so repeated reconfiguration neither fragments nor leaks.
+ *
+ * Each registered entry needs sizeof(RTU_Register_t) bytes.
+ *
+ * @param arena Static buffer owned by the caller (kept until RTUSlave_Deinit())
+ * @param size Size of the buffer in bytes
+ *
+ * @note Combine with RTU_NO_MALLOC = 1 for a build that never touches the heap.
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if arena is NULL or too small
+ */
+extern RTU_Sta_t RTUSlave_InitArena(void *arena, size_t size);
+
+/**
+ * @brief Report arena usage.
+ *
+ * @param used Bytes currently in use (may be NULL)
+ * @param peak High-water mark since RTUSlave_InitArena() (may be NULL)
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if no arena is configured
+ */
+extern RTU_Sta_t RTUSlave_ArenaUsage(size_t *used, size_t *peak);
+
 /**
  * @brief Deinitialize the Modbus RTU slave instance.
  *
@@ -61,9 +92,13 @@ extern void RTUSlave_Deinit(void);
  * @note
  * - Internal memory will be reallocated (previous registrations will be cleared)
  * - Map data is NOT copied; only pointers are stored
+ * - With RTU_HOT_SWAP the call may run while the slave is serving, from any
+ *   thread (one registration at a time): the new map is built aside and
+ *   served from the next RTUSlave_TimerHandler() call, which frees the old one
  *
  * @return RTU_OK on success
- * @return RTU_ERR on failure
+ * @return RTU_ERR on failure, or (RTU_HOT_SWAP) when earlier maps of the
+ *         class have not been taken over by RTUSlave_TimerHandler() yet
  */
 extern RTU_Sta_t RTUSlave_RegisterCoils(RTU_RegisterMap_t *Map, size_t regNum);
 
@@ -81,6 +116,9 @@ extern RTU_Sta_t RTUSlave_RegisterCoils(RTU_RegisterMap_t *Map, size_t regNum);
  * @note
  * - Each register must point to a valid 16-bit data variable
  * - Permissions (RO/RW) are respected during write operations
+ * - With RTU_TYPED_REGS an entry's type/order may make it a 32/64-bit or
+ *   float value covering 2 or 4 consecutive addresses
+ * - Replacing the map while serving: see RTUSlave_RegisterCoils() and RTU_HOT_SWAP
  *
  * @return RTU_OK on success
  * @return RTU_ERR on failure
@@ -99,12 +137,582 @@ extern RTU_Sta_t RTUSlave_RegisterHoldReg(RTU_RegisterMap_t *Map, size_t regNum)
  * @note
  * - These registers are strictly read-only
  * - Any write attempt will be rejected automatically
+ * - With RTU_TYPED_REGS an entry's type/order may make it a 32/64-bit or
+ *   float value covering 2 or 4 consecutive addresses
+ * - Replacing the map while serving: see RTUSlave_RegisterCoils() and RTU_HOT_SWAP
  *
  * @return RTU_OK on success
  * @return RTU_ERR on failure
  */
 extern RTU_Sta_t RTUSlave_RegisterInputReg(RTU_RegisterMap_t *Map, size_t regNum);
 
+/**
+ * @brief Register discrete inputs (bit-level, read-only).
+ *
+ * Used for Modbus function code:
+ * - 0x02 (Read Discrete Inputs)
+ *
+ * Each entry in the map corresponds to one input; `data` points to a
+ * uint8_t (0 or 1).
+ *
+ * @param Map Pointer to register map array
+ * @param regNum Number of inputs
+ *
+ * @note
+ * - Discrete inputs are strictly read-only
+ * - Addresses covered by a packed bitmap (see RTUSlave_RegisterDiscreteBitmap())
+ *   are served from the bitmap and never reach this table
+ * - Replacing the map while serving: see RTUSlave_RegisterCoils() and RTU_HOT_SWAP
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR on failure
+ */
+extern RTU_Sta_t RTUSlave_RegisterDiscreteInput(RTU_RegisterMap_t *Map, size_t regNum);
+
+/**
+ * @brief Register a const, sorted register table (no allocation, no copy).
+ *
+ * Serves a register class directly from a caller-owned RTU_Register_t array,
+ * typically generated by tools/rtu_mapgen.py and placed in flash. Lookups
+ * use binary search instead of a list walk.
+ *
+ * @param cls Register class served by the table
+ * @param table Array of nodes in strictly ascending address order, where
+ *              table[i].next == &table[i + 1] and the last next is NULL
+ * @param regNum Number of entries
+ *
+ * @note
+ * - The table is never written or freed by the library
+ * - Replaces any previous registration of the class; with RTU_HOT_SWAP
+ *   while serving, as RTUSlave_RegisterCoils() does
+ * - RTU_MAX_* limits do not apply (tables use no heap), except that with
+ *   RTU_DIRTY_TRACKING holding/coil tables must fit RTU_MAX_HOLD_REGS /
+ *   RTU_MAX_COILS (the size of the dirty queue)
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if the table is not sorted/chained or arguments are invalid
+ */
+extern RTU_Sta_t RTUSlave_RegisterTable(RTU_RegClass_t cls, const RTU_Register_t *table, size_t regNum);
+
+/**
+ * @brief Add registers to a class without rebuilding its map (RTU_DYNAMIC_REGS).
+ *
+ * Each entry is placed into a free pool slot and linked into the address
+ * index in O(log n); the other nodes are not touched.
+ *
+ * @param cls Register class to extend
+ * @param Map Entries to add, in any order
+ * @param regNum Number of entries
+ *
+ * @note
+ * - The first Insert/Remove/Rebind of a class copies its map into a pool
+ *   (heap or arena) that doubles when full, up to RTU_MAX_* entries.
+ *   A const table from RTUSlave_RegisterTable() is copied, never written
+ * - All or nothing: an address already present, a typed value overlapping
+ *   a neighbour or a full class rejects the whole call
+ * - Call from the context that runs RTUSlave_TimerHandler(), between
+ *   frames; with RTU_HOT_SWAP the newest published map is edited
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if disabled, out of memory or an entry is rejected
+ */
+extern RTU_Sta_t RTUSlave_InsertRegs(RTU_RegClass_t cls, const RTU_RegisterMap_t *Map, size_t regNum);
+
+/**
+ * @brief Remove the registers of a class starting in [startAddr, startAddr + count).
+ *
+ * @param cls Register class
+ * @param startAddr First address of the range
+ * @param count Number of addresses in the range
+ *
+ * @note
+ * - O(log n) per removed entry; freed slots are reused by later inserts,
+ *   the pool only shrinks when the class is registered again
+ * - Pending dirty entries of removed nodes are dropped
+ * - Same calling context as RTUSlave_InsertRegs()
+ *
+ * @return RTU_OK if at least one entry was removed
+ * @return RTU_ERR if disabled or no entry starts in the range
+ */
+extern RTU_Sta_t RTUSlave_RemoveRegs(RTU_RegClass_t cls, uint16_t startAddr, uint16_t count);
+
+/**
+ * @brief Point existing registers at new variables / callbacks.
+ *
+ * Every entry must name an address already in the class; data, permission,
+ * callback, group and type are replaced in place, the node keeps its slot.
+ *
+ * @param cls Register class
+ * @param Map Replacement entries
+ * @param regNum Number of entries
+ *
+ * @note
+ * - All entries are checked before any is changed
+ * - Same calling context as RTUSlave_InsertRegs()
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if disabled, an address is missing or a type does not fit
+ */
+extern RTU_Sta_t RTUSlave_RebindRegs(RTU_RegClass_t cls, const RTU_RegisterMap_t *Map, size_t regNum);
+
+/**
+ * @brief Register a packed bitmap of discrete inputs.
+ *
+ * Bit n of `bitmap` (LSB first within each byte) is the input at address
+ * `startAddr + n`. A 0x02 request that lies fully inside the bitmap is
+ * answered with a bulk bit copy instead of a per-node walk.
+ *
+ * @param startAddr Address of the first input (bit 0 of bitmap[0])
+ * @param count Number of inputs in the bitmap (1 ~ 65535)
+ * @param bitmap Application buffer of at least (count + 7) / 8 bytes
+ *
+ * @note Map data is NOT copied; only the pointer is stored.
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if arguments are invalid
+ */
+extern RTU_Sta_t RTUSlave_RegisterDiscreteBitmap(uint16_t startAddr, uint16_t count, const uint8_t *bitmap);
+
+/**
+ * @brief Publish a new discrete-input snapshot.
+ *
+ * Replaces the bitmap pointer in a single store, so a master always reads
+ * either the old or the new snapshot as a whole. Typical use is to fill a
+ * second buffer and publish it (double buffering).
+ *
+ * @param bitmap Buffer laid out like the one passed to RTUSlave_RegisterDiscreteBitmap()
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if no bitmap is registered or bitmap is NULL
+ */
+extern RTU_Sta_t RTUSlave_PublishDiscreteBitmap(const uint8_t *bitmap);
+
+/**
+ * @brief Register a FIFO queue (16-bit values, read-only).
+ *
+ * Used for Modbus function code:
+ * - 0x18 (Read FIFO Queue)
+ *
+ * The queue object is owned by the application (typically static) and is
+ * reset by this call. Registering another queue with the same address
+ * replaces the previous one.
+ *
+ * @param fifo Application-owned queue object
+ * @param addr FIFO pointer address used by the master
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if fifo is NULL or RTU_MAX_FIFOS queues are registered
+ */
+extern RTU_Sta_t RTUSlave_RegisterFifo(RTU_Fifo_t *fifo, uint16_t addr);
+
+/**
+ * @brief Push one value into a FIFO queue.
+ *
+ * Lock-free for a single producer (task or ISR) against the slave, which
+ * is the only consumer. Each 0x18 request drains up to 31 values.
+ *
+ * @param fifo Queue registered with RTUSlave_RegisterFifo()
+ * @param value Value to queue
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if the queue is full (value dropped, fifo->dropped incremented)
+ */
+extern RTU_Sta_t RTUSlave_FifoPush(RTU_Fifo_t *fifo, uint16_t value);
+
+/**
+ * @brief Register files for file record access.
+ *
+ * Used for Modbus function codes:
+ * - 0x14 (Read File Record)
+ * - 0x15 (Write File Record)
+ *
+ * Each entry describes one file of `records` 16-bit records, backed by
+ * `data` and/or served by `callback`:
+ * - data != NULL: records are read from / written to the buffer; the
+ *   callback (if any) is notified per sub-request and may veto it
+ * - data == NULL: the callback fills ctx->regs on read and consumes it on write
+ *
+ * @param Map Pointer to file map array
+ * @param fileNum Number of files
+ *
+ * @note
+ * - The map itself is referenced, not copied; keep it alive while registered
+ * - Previous file registrations are replaced
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR on failure
+ */
+extern RTU_Sta_t RTUSlave_RegisterFileRecord(RTU_FileRecordMap_t *Map, size_t fileNum);
+
+/**
+ * @brief Start updating the registers of a seqlock group.
+ *
+ * Registers whose map entry points to the same RTU_RegGroup_t are read by
+ * the master as one consistent snapshot. Bracket every application update
+ * of those variables with RTUSlave_GroupWriteBegin()/RTUSlave_GroupWriteEnd();
+ * no lock is taken and the writer never waits.
+ *
+ * Example:
+ * @code
+ * RTUSlave_GroupWriteBegin(&flowGroup);
+ * flowHi = (uint16_t)(flow >> 16);
+ * flowLo = (uint16_t)flow;
+ * RTUSlave_GroupWriteEnd(&flowGroup);
+ * @endcode
+ *
+ * @param group Group shared by the map entries
+ *
+ * @note
+ * - One writer per group at a time. Master writes (0x06/0x10) into a group
+ *   also go through the seqlock, so do not update a writable group from the
+ *   application while RTUSlave_TimerHandler() may run
+ * - Readers that keep hitting an update answer with exception 0x06 after
+ *   RTU_SEQLOCK_RETRIES attempts
+ */
+extern void RTUSlave_GroupWriteBegin(RTU_RegGroup_t *group);
+
+/**
+ * @brief Finish updating the registers of a seqlock group.
+ *
+ * Also invalidates cached responses (RTU_RESP_CACHE_SIZE) and schedules a
+ * checkpoint (RTU_PERSIST_ENABLE); the version counters behind them are
+ * bumped atomically, so this may run alongside RTUSlave_TimerHandler().
+ * Compilers without GCC-style __atomic builtins must serialise the two.
+ *
+ * @param group Group passed to RTUSlave_GroupWriteBegin()
+ */
+extern void RTUSlave_GroupWriteEnd(RTU_RegGroup_t *group);
+
+/**
+ * @brief Register a handler for one function code.
+ *
+ * Requests are dispatched through a 256-entry table indexed by the function
+ * code. A registered handler takes precedence over the built-in one, so it
+ * can serve a vendor code (e.g. firmware or calibration transfer) or replace
+ * a standard code.
+ *
+ * The handler works directly on the frame buffer:
+ * - ctx->req / ctx->reqLen: the request, CRC already checked and stripped
+ * - ctx->resp: the response, written from resp[2]; id and function code
+ *   are filled in and the CRC is appended by the library
+ * - ctx->respLen: total length without CRC (id and function code included),
+ *   at most ctx->respMax; leave it 0 to send no reply
+ *
+ * Returning an exception code other than RTU_EX_NONE sends that exception
+ * instead of the response.
+ *
+ * Example:
+ * @code
+ * RTU_ExceptionCode_t fw_chunk(RTU_FuncCtx_t *ctx)
+ * {
+ *     if (ctx->reqLen < 4 || !flash_write(&ctx->req[2], ctx->reqLen - 2))
+ *         return RTU_EX_SLAVE_FAILURE;
+ *     ctx->respLen = 2;
+ *     return RTU_EX_NONE;
+ * }
+ *
+ * RTUSlave_RegisterFuncHandler(0x65, fw_chunk);
+ * @endcode
+ *
+ * @param func Function code (1 ~ 127)
+ * @param handler Handler, NULL restores the built-in behaviour
+ *
+ * @note
+ * - resp and req share memory: consume the request before overwriting it
+ * - Broadcast requests (id 0) are passed to the handler too; the reply is
+ *   dropped by the library
+ * - The handler runs in the context of RTUSlave_TimerHandler()
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if func is invalid or all RTU_MAX_USER_FUNCS slots are used
+ */
+extern RTU_Sta_t RTUSlave_RegisterFuncHandler(uint8_t func, RTUSlave_FuncHandler_t handler);
+
+/**
+ * @brief Fetch and clear the registers changed by the master (requires RTU_DIRTY_TRACKING).
+ *
+ * Each holding register or coil whose value was changed by a master write
+ * is queued once until fetched, so the application handles only what
+ * changed instead of rescanning all its variables:
+ *
+ * @code
+ * uint16_t addr[16];
+ * size_t n;
+ * while ((n = RTUSlave_FetchDirty(RTU_CLASS_HOLDING_REGS, addr, 16)) > 0)
+ *     for (size_t i = 0; i < n; i++)
+ *         apply_setting(addr[i]);
+ * @endcode
+ *
+ * @param cls RTU_CLASS_HOLDING_REGS or RTU_CLASS_COILS
+ * @param addrs Receives the changed register addresses (no particular order)
+ * @param max Capacity of addrs; registers not returned stay queued
+ *
+ * @note
+ * - Cost is O(returned), independent of the map size
+ * - Writes that store the value already held are not reported
+ * - Call from the same context as RTUSlave_TimerHandler() (or serialise them)
+ * - Re-registering a class clears its queue
+ *
+ * @return Number of addresses written to addrs
+ */
+extern size_t RTUSlave_FetchDirty(RTU_RegClass_t cls, uint16_t *addrs, size_t max);
+
+/**
+ * @brief Release the requests parked by RTU_EX_PENDING (requires RTU_PENDING_MAX > 0).
+ *
+ * A register/file callback or function-code handler that cannot answer
+ * yet returns RTU_EX_PENDING. Nothing is sent; the request is kept in a
+ * pending slot (or answered with RTU_EX_SLAVE_BUSY when none is free).
+ * Once the slow operation has finished, call this function: the next
+ * RTUSlave_TimerHandler() call that finds no new frame runs each released
+ * request again from the start and sends its response.
+ *
+ * @code
+ * RTU_ExceptionCode_t eeprom_cb(RTU_Ctx_t *ctx)
+ * {
+ *     if (!eeprom_done(ctx->addr))
+ *     {
+ *         eeprom_start(ctx->addr, ctx->value);
+ *         return RTU_EX_PENDING;
+ *     }
+ *     return RTU_EX_NONE;
+ * }
+ *
+ * void eeprom_irq(void) { RTUSlave_CompletePending(); }
+ * @endcode
+ *
+ * @note
+ * - Callbacks run again on the re-run and must then return the final
+ *   result; with RTU_STAGED_WRITES nothing is stored until then
+ * - Without RTU_STAGED_WRITES a 0x0F / 0x10 write resumes at the
+ *   register (coil) whose callback parked it: the ones stored before are
+ *   not written again and their callbacks do not run twice
+ * - A function-code handler must return RTU_EX_PENDING before writing ctx->resp
+ * - Finish within the master's response timeout. When a new request for
+ *   this id arrives first, parked requests are still completed but their
+ *   responses are dropped
+ * - May be called from an interrupt
+ *
+ * @return RTU_OK if a request was released
+ * @return RTU_NOACTIVE if nothing was waiting
+ * @return RTU_ERR if deferred responses are not compiled in
+ */
+extern RTU_Sta_t RTUSlave_CompletePending(void);
+
+/**
+ * @brief Number of parked requests (waiting or released, not yet answered).
+ *
+ * @return Occupied pending slots (0 when deferred responses are not compiled in)
+ */
+extern size_t RTUSlave_PendingCount(void);
+
+/**
+ * @brief Tell the library that the application changed registers of a class.
+ *
+ * With RTU_RESP_CACHE_SIZE > 0, repeated 0x03 / 0x04 polls are answered
+ * from cached response frames until the class changes. Master writes,
+ * RTUSlave_GroupWriteEnd() and re-registration are seen automatically; a
+ * variable updated directly by the application is not, so call this
+ * afterwards (a single call may cover any number of updates).
+ *
+ * @param cls Register class that was updated
+ *
+ * With RTU_PERSIST_ENABLE, holding register changes announced this way
+ * are also saved by the next checkpoint.
+ *
+ * @note Cheap (one counter increment); may be called from an interrupt.
+ *       Does nothing when neither feature is compiled in.
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if cls is invalid or not compiled in
+ */
+extern RTU_Sta_t RTUSlave_RegsChanged(RTU_RegClass_t cls);
+
+/**
+ * @brief Keep the holding registers in a memory-mapped store file.
+ *
+ * Call after registering the holding registers. If the file holds a valid
+ * checkpoint of the same map (addresses and types), the registered
+ * variables are loaded from it; otherwise the file is (re)created from the
+ * current values. Changes are then saved write-behind by
+ * RTUSlave_TimerHandler() when no frame is pending, at most
+ * RTU_PERSIST_FLUSH_MS after they happen.
+ *
+ * @param path Store file, created if missing
+ *
+ * @note
+ * - POSIX only; needs RTU_PERSIST_ENABLE
+ * - Write callbacks are not run for loaded values
+ * - Call from the same context as RTUSlave_TimerHandler() (or serialise
+ *   them): with RTU_HOT_SWAP it first switches to a published holding map
+ *   and frees the one being served
+ * - Re-registering the holding registers saves and closes the store
+ * - RTUSlave_InsertRegs() / RemoveRegs() / RebindRegs() keep it open: when
+ *   they change the addresses or types, the store is started over from the
+ *   current values (and closed if that fails: RTUSlave_PersistFlush() then
+ *   returns RTU_ERR)
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR on failure, if already open or not compiled in
+ */
+extern RTU_Sta_t RTUSlave_PersistOpen(const char *path);
+
+/**
+ * @brief Save unsaved holding register changes now (e.g. before shutdown).
+ *
+ * Unlike the write-behind checkpoints of RTUSlave_TimerHandler(), this waits
+ * until the checkpoint is on the disk (msync MS_SYNC).
+ *
+ * @note Call from the same context as RTUSlave_TimerHandler() (or serialise
+ *       them); the handler writes checkpoints into the same slots.
+ *
+ * @return RTU_OK when a checkpoint was written, or the last write-behind
+ *         checkpoint was waited for
+ * @return RTU_NOACTIVE if nothing changed and the last checkpoint is on disk
+ * @return RTU_ERR if the store is not open or msync failed
+ */
+extern RTU_Sta_t RTUSlave_PersistFlush(void);
+
+/**
+ * @brief Save pending changes and close the store opened by RTUSlave_PersistOpen().
+ *
+ * @note Same calling context as RTUSlave_PersistFlush().
+ */
+extern void RTUSlave_PersistClose(void);
+
+/**
+ * @brief Create or attach the POSIX shared-memory register image.
+ *
+ * The image is RTU_SHM_BLOCK_REGS-register blocks, each guarded by its own
+ * seqlock (RTU_ShmBlock_t.group). The slave maps registers into it with
+ * RTUSlave_ShmFillMap(); producer processes attach the same name and update
+ * a block in place between RTUSlave_GroupWriteBegin(&blk->group) and
+ * RTUSlave_GroupWriteEnd(&blk->group), with no copy through the slave.
+ *
+ * Example (producer process):
+ * @code
+ * RTU_ShmImage_t *img = RTUSlave_ShmAttach("/plant-regs", 0);
+ * RTU_ShmBlock_t *blk = RTU_SHM_BLOCK(img, 2);
+ * RTUSlave_GroupWriteBegin(&blk->group);
+ * blk->regs[0] = flow_hi;
+ * blk->regs[1] = flow_lo;
+ * RTUSlave_GroupWriteEnd(&blk->group);
+ * @endcode
+ *
+ * @param name   shm_open() name, e.g. "/plant-regs"
+ * @param blocks Number of blocks to create (an existing image must have
+ *               exactly this many), 0 = attach an existing image only
+ *
+ * @note
+ * - POSIX only; needs RTU_SHM_ENABLE and the same RTU_SHM_BLOCK_REGS in
+ *   every process
+ * - One writer per block at a time; the master is the writer of blocks
+ *   mapped as holding registers
+ * - One image per process; RTUSlave_Deinit() detaches it
+ *
+ * @return The mapped image, NULL on failure, if one is already attached
+ *         or not compiled in
+ */
+extern RTU_ShmImage_t *RTUSlave_ShmAttach(const char *name, size_t blocks);
+
+/**
+ * @brief Unmap the image attached by RTUSlave_ShmAttach() (the object is not removed).
+ *
+ * @note Unregister the register classes mapped into it first.
+ */
+extern void RTUSlave_ShmDetach(void);
+
+/**
+ * @brief Fill register map entries that point into the shared image.
+ *
+ * Entry i serves address startAddr + i from image register firstReg + i
+ * (block (firstReg + i) / RTU_SHM_BLOCK_REGS), with the block's seqlock as
+ * its group. Register the map with RTUSlave_RegisterInputReg() or
+ * RTUSlave_RegisterHoldReg(); callbacks may be set on entries in between.
+ *
+ * @param Map       Map array of at least regNum entries (overwritten)
+ * @param regNum    Number of registers
+ * @param startAddr Modbus address of the first register
+ * @param firstReg  Image register index of the first register
+ * @param permiss   Permission of every entry
+ *
+ * @note Reads covering image registers are never served from the response
+ *       cache, since other processes change them unseen.
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if no image is attached, the range does not fit or not compiled in
+ */
+extern RTU_Sta_t RTUSlave_ShmFillMap(RTU_RegisterMap_t *Map, size_t regNum, uint16_t startAddr, size_t firstReg, RTU_Permiss_t permiss);
+
+/**
+ * @brief Copy one block of the shared image as a consistent snapshot.
+ *
+ * For consumer processes, e.g. to pick up setpoints the master wrote into
+ * holding registers mapped into the image.
+ *
+ * @param block Block index
+ * @param out   RTU_SHM_BLOCK_REGS values
+ *
+ * @return RTU_OK on success
+ * @return RTU_NOACTIVE if the block kept changing for RTU_SEQLOCK_RETRIES attempts (try again)
+ * @return RTU_ERR if no image is attached, block is out of range or not compiled in
+ */
+extern RTU_Sta_t RTUSlave_ShmReadBlock(size_t block, uint16_t *out);
+
+/**
+ * @brief Select the bus monitor mode (requires RTU_MONITOR_ENABLE).
+ *
+ * In monitor mode every frame handed to RTUSlave_ReceiveCallback() is
+ * appended to the capture ring, whatever its slave id, CRC or length (noise
+ * bursts and fragments too; frames of 2 bytes or less are never marked
+ * RTU_MON_FLAG_CRC_OK):
+ * - RTU_MONITOR_PASSIVE: capture only, nothing is processed or transmitted
+ * - RTU_MONITOR_PROMISC: capture, and keep serving this slave id; frames
+ *   sent through RTU_Transmit() are captured too (RTU_MON_FLAG_TX)
+ *
+ * Each record is RTU_MON_HDR_SIZE bytes of header followed by the frame:
+ * [RTU_MON_SYNC][flags][len_lo][len_hi][time, 4 bytes little endian][frame...]
+ *
+ * Received frames are stamped with RTU_MonitorTime() when
+ * RTUSlave_ReceiveCallback() is called (end of frame), transmitted frames
+ * when they are handed to RTU_Transmit() (start of frame).
+ *
+ * @param mode Monitor mode, RTU_MONITOR_OFF stops capturing
+ *
+ * @note
+ * - The serial driver must pass on every frame on the line, not only the
+ *   ones addressed to this slave
+ * - Switching mode does not clear the ring
+ *
+ * @return RTU_OK on success
+ * @return RTU_ERR if the monitor is not compiled in or mode is invalid
+ */
+extern RTU_Sta_t RTUSlave_SetMonitor(RTU_MonitorMode_t mode);
+
+/**
+ * @brief Drain captured records from the bus monitor ring.
+ *
+ * Copies whole records only, oldest first, and releases their space. The
+ * output can be written as is to a capture file for tools/rtu_capdecode.py.
+ *
+ * @param out Destination buffer
+ * @param max Size of out; at least RTU_MON_HDR_SIZE + RTU_FRAME_BUF_SIZE
+ *            guarantees progress
+ *
+ * @note Single consumer: call from one context only. It may run
+ *       concurrently with RTUSlave_TimerHandler().
+ *
+ * @return Number of bytes copied (0 when empty or monitor not compiled in)
+ */
+extern size_t RTUSlave_MonitorRead(uint8_t *out, size_t max);
+
+/**
+ * @brief Number of frames the bus monitor dropped because the ring was full.
+ *
+ * @return Dropped frame count since RTUSlave_Init()
+ */
+extern uint32_t RTUSlave_MonitorDropped(void);
+
 /**
  * @brief Receive raw Modbus RTU data from lower layer.
  *
@@ -132,6 +740,7 @@ extern void RTUSlave_ReceiveCallback(uint8_t *data, size_t len);
  * This function must be called periodically (e.g. in main loop or timer interrupt).
  *
  * Responsibilities:
+ * - Switch to register maps published meanwhile (RTU_HOT_SWAP)
  * - Detect complete frame
  * - Validate CRC
  * - Parse function code
@@ -144,6 +753,11 @@ extern void RTUSlave_ReceiveCallback(uint8_t *data, size_t len);
  * @return RTU_READ_HOLD_REG when a read holding register request is processed
  * @return RTU_WRITE_HOLD_REG when a write holding register request is processed
  * @return RTU_READ_COIL when a coil read is processed
+ * @return RTU_READ_DISCRETE_INPUT when a discrete input read is processed
+ * @return RTU_READ_FIFO when a FIFO queue read is processed
+ * @return RTU_READ_FILE / RTU_WRITE_FILE when a file record request is processed
+ * @return RTU_USER_FUNC when a registered function-code handler served the request
+ * @return RTU_PENDING when a callback parked the request, or a released one is parked again
  */
 extern RTU_Sta_t RTUSlave_TimerHandler(void);
 
@@ -152,6 +766,8 @@ extern RTU_Sta_t RTUSlave_TimerHandler(void);
  *
  * @param id Slave address (valid range: 1 ~ 254)
  *
+ * @note Broadcast writes (id 0) are always accepted in addition to this id.
+ *
  * @return RTU_OK on success
  * @return RTU_ERR if ID is invalid or module not initialized
  */
@@ -179,6 +795,17 @@ extern RTU_Sta_t RTUSlave_Modifyid(uint8_t id);
  */
 extern int RTU_Transmit(uint8_t *data, size_t size);
 
+/**
+ * @brief Time source for the bus monitor (weak function).
+ *
+ * Override with a free-running counter, ideally in microseconds (e.g. a
+ * 32-bit hardware timer). The default returns 0. Wrap-around is handled by
+ * the decoder.
+ *
+ * @return Current timestamp
+ */
+extern uint32_t RTU_MonitorTime(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,14 @@ extern "C"
 {
 #endif
 
+#define RTU_BROADCAST_ID (0x00U) // slave id of broadcast requests
+
+/* Bus monitor capture record: [sync][flags][len_lo][len_hi][time (4, LE)][frame...] */
+#define RTU_MON_SYNC (0xA5U)
+#define RTU_MON_HDR_SIZE (8U)
+#define RTU_MON_FLAG_CRC_OK (0x01U) // frame CRC is valid
+#define RTU_MON_FLAG_TX (0x02U)     // frame was sent by this slave
+
 typedef enum
 {
     RTU_OK,
@@ -21,6 +29,12 @@ typedef enum
     RTU_READ_COIL,      // Read Ciol
     RTU_WRITE_COIL,     // 写线圈
     RTU_READ_INPUT_REG,
+    RTU_READ_DISCRETE_INPUT,
+    RTU_READ_FIFO,
+    RTU_READ_FILE,
+    RTU_WRITE_FILE,
+    RTU_USER_FUNC, // handled by a registered function-code handler
+    RTU_PENDING,   // request parked until RTUSlave_CompletePending()
     RTU_NOACTIVE,
     RTU_ExCEPT_ACTIVE, // 有异常激活
 } RTU_Sta_t;
@@ -45,6 +59,7 @@ typedef enum
     RTU_EX_ILLEGAL_VALUE = 0x03, // 数量或数值非法
     RTU_EX_SLAVE_FAILURE = 0x04, // 内部处理出错
     RTU_EX_SLAVE_BUSY = 0x06,    // 设备正忙
+    RTU_EX_PENDING = 0xFF,       // 稍后应答 (never sent, see RTU_PENDING_MAX)
 } RTU_ExceptionCode_t;
 
 typedef enum
@@ -62,27 +77,181 @@ typedef enum
     /** Def Input Register */
     RTU_FUNC_READ_INPUT_REG = 0x04,     // read input regs
 
+    /** Def Discrete Input */
+    RTU_FUNC_READ_DISCRETE_INPUTS = 0x02, // read discrete inputs
+
+    /** Def FIFO Queue */
+    RTU_FUNC_READ_FIFO_QUEUE = 0x18, // read fifo queue
+
+    /** Def File Record */
+    RTU_FUNC_READ_FILE_RECORD = 0x14,  // read file record
+    RTU_FUNC_WRITE_FILE_RECORD = 0x15, // write file record
+
 } RTU_FunctionCode_t;
 
 typedef struct {
     uint16_t addr; // Trigger addr
     RTU_RW_t op;
     uint16_t value; // bus op value
+#if RTU_TYPED_REGS
+    uint64_t wide; // typed entry: whole value as raw bits (float/double bit pattern), value = first register
+#endif
 }RTU_Ctx_t;
 
 typedef RTU_ExceptionCode_t (*RTUSlave_Func_t)(RTU_Ctx_t *ctx);
 
+typedef struct {
+    uint16_t file;   // file number
+    uint16_t record; // first record of the sub-request
+    RTU_RW_t op;
+    uint16_t *regs;  // record data (host order), count entries
+    uint16_t count;
+} RTU_FileCtx_t;
+
+typedef RTU_ExceptionCode_t (*RTUSlave_FileFunc_t)(RTU_FileCtx_t *ctx);
+
+typedef struct {
+    uint8_t func;       // function code of the request
+    const uint8_t *req; // request frame from the slave id on, CRC already checked
+    size_t reqLen;      // request length without CRC
+    uint8_t *resp;      // response frame, same memory as req; fill from resp[2]
+    size_t respMax;     // usable response bytes (CRC excluded)
+    size_t respLen;     // response length without CRC set by the handler, 0 = no reply
+} RTU_FuncCtx_t;
+
+typedef RTU_ExceptionCode_t (*RTUSlave_FuncHandler_t)(RTU_FuncCtx_t *ctx);
+
+/**
+ * Seqlock guarding a group of registers that must be read as one snapshot
+ * (e.g. a 32-bit value split over two registers). Odd seq = update in progress.
+ */
+typedef struct
+{
+    volatile uint32_t seq;
+} RTU_RegGroup_t;
+
+/**
+ * Shared-memory register image (RTU_SHM_ENABLE): this header followed by
+ * `blocks` RTU_ShmBlock_t, each with its own seqlock. Producers in other
+ * processes update a block between RTUSlave_GroupWriteBegin(&blk->group)
+ * and RTUSlave_GroupWriteEnd(&blk->group).
+ */
+typedef struct
+{
+    RTU_RegGroup_t group; // seqlock of this block
+    uint16_t regs[RTU_SHM_BLOCK_REGS];
+} RTU_ShmBlock_t;
+
+typedef struct
+{
+    volatile uint32_t magic; // written last by the creator
+    uint32_t format;
+    uint32_t blocks;
+    uint32_t blockRegs; // RTU_SHM_BLOCK_REGS of the creator
+} RTU_ShmImage_t;
+
+/* Block n of an attached image */
+#define RTU_SHM_BLOCK(img, n) (&((RTU_ShmBlock_t *)((img) + 1))[(n)])
+
+/* Value type of a register entry (RTU_TYPED_REGS) */
+typedef enum
+{
+    RTU_TYPE_U16, // one register, uint16_t / int16_t (default)
+    RTU_TYPE_U32, // two registers
+    RTU_TYPE_I32,
+    RTU_TYPE_F32, // float
+    RTU_TYPE_U64, // four registers
+    RTU_TYPE_I64,
+    RTU_TYPE_F64, // double
+} RTU_RegType_t;
+
+/* Register order of a typed value on the wire, A = most significant byte */
+typedef enum
+{
+    RTU_ORDER_ABCD, // big endian, most significant register first (Modbus default)
+    RTU_ORDER_CDAB, // registers swapped
+    RTU_ORDER_BADC, // bytes swapped inside each register
+    RTU_ORDER_DCBA, // little endian
+} RTU_WordOrder_t;
+
+/* RTU_Register_t.type: value type in the low nibble, word order in the high nibble */
+#define RTU_REG_TYPE(type, order) ((uint8_t)((uint8_t)(type) | ((uint8_t)(order) << 4)))
+
 typedef struct RTU_Register
 {
     uint16_t address;
     uint8_t permiss;
+    uint8_t type; // RTU_REG_TYPE(), 0 = one uint16_t register
 
     RTUSlave_Func_t callback;
     void *value;
+    RTU_RegGroup_t *group; // optional seqlock group
 
     struct RTU_Register *next;
 } RTU_Register_t;
 
+typedef enum
+{
+    RTU_CLASS_COILS,
+    RTU_CLASS_DISCRETE_INPUTS,
+    RTU_CLASS_HOLDING_REGS,
+    RTU_CLASS_INPUT_REGS,
+} RTU_RegClass_t;
+
+typedef enum
+{
+    RTU_MEM_HEAP,   // one calloc'd block
+    RTU_MEM_ARENA,  // carved from the arena given to RTUSlave_InitArena()
+    RTU_MEM_CALLER, // caller-owned const table, never freed
+} RTU_MemOwner_t;
+
+#if RTU_DYNAMIC_REGS
+#define RTU_DYN_NIL (0xFFFFU) // no slot
+
+/**
+ * AVL tree entry of one node slot of a dynamic map
+ */
+typedef struct
+{
+    uint16_t left;  // lower addresses; next free slot while the slot is free
+    uint16_t right; // higher addresses
+    uint8_t height;
+} RTU_RegIndex_t;
+#endif
+
+typedef struct
+{
+    RTU_Register_t *head; // head[0..num), chained in array order
+    size_t num;
+    bool sorted;          // strictly ascending addresses (binary search)
+    RTU_MemOwner_t owner;
+#if RTU_DYNAMIC_REGS
+    size_t capacity;      // dynamic map: slots in head, chained in address order; 0 = fixed map
+    uint16_t root;        // AVL root slot, the tree follows the slots
+    uint16_t freeSlot;    // first free slot
+#endif
+} RTU_RegList_t;
+
+#if RTU_HOT_SWAP
+#define RTU_SWAP_SLOTS (3U) // per class: published + replaced before adoption
+
+typedef enum
+{
+    RTU_SWAP_FREE,
+    RTU_SWAP_BUSY, // filled by a registration, published or being adopted
+    RTU_SWAP_DEAD, // arena block replaced before adoption, released by the server
+} RTU_SwapState_t;
+
+/**
+ * Map built by a registration call, waiting to be adopted by RTUSlave_TimerHandler()
+ */
+typedef struct
+{
+    RTU_RegList_t list;
+    volatile uint8_t state; // RTU_SwapState_t
+} RTU_SwapSlot_t;
+#endif
+
 typedef struct
 {
     uint16_t addr;
@@ -90,25 +259,204 @@ typedef struct
 
     RTUSlave_Func_t callback;
     void *data;
+    RTU_RegGroup_t *group; // optional: registers sharing a group are read as one snapshot
+
+    RTU_RegType_t type;    // optional (RTU_TYPED_REGS): data points to a value of this type
+    RTU_WordOrder_t order; // register order of a typed value
 } RTU_RegisterMap_t;
 
+/**
+ * Packed discrete-input snapshot: bit n of bits[] (LSB first) is the
+ * input at address start + n. The application swaps `bits` in one store.
+ */
+typedef struct
+{
+    uint16_t start;
+    uint16_t count;
+    const uint8_t *volatile bits;
+} RTU_BitImage_t;
+
+/**
+ * Single-producer / single-consumer register FIFO for FC 0x18.
+ * The application pushes with RTUSlave_FifoPush(), the slave drains it.
+ * head is written only by the producer, tail only by the slave.
+ */
+typedef struct
+{
+    uint16_t address;
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    volatile uint32_t dropped; // pushes rejected because the queue was full
+    uint16_t buf[RTU_FIFO_DEPTH];
+} RTU_Fifo_t;
+
+typedef struct
+{
+    uint16_t file;     // file number (1 ~ 65535)
+    RTU_Permiss_t permiss;
+    uint16_t records;  // number of 16-bit records (1 ~ 10000)
+
+    RTUSlave_FileFunc_t callback; // optional; provides the data when `data` is NULL
+    uint16_t *data;    // optional backing buffer of `records` entries
+} RTU_FileRecordMap_t;
+
 typedef struct
 {
     bool ready;
     size_t len;
+    uint32_t time; // RTU_MonitorTime() at reception (bus monitor only)
 } RTU_GFrame_t;
 
+typedef enum
+{
+    RTU_MONITOR_OFF,     // normal slave
+    RTU_MONITOR_PASSIVE, // capture every frame, never reply
+    RTU_MONITOR_PROMISC, // capture every frame and keep serving this slave id
+} RTU_MonitorMode_t;
+
+#if RTU_DIRTY_TRACKING
+typedef struct
+{
+    uint16_t *queue; // node indices changed since the last fetch
+    uint32_t *mark;  // one bit per node: index is queued
+    size_t count;
+    size_t capacity;
+} RTU_DirtySet_t;
+#endif
+
+#if RTU_MONITOR_ENABLE
+typedef struct
+{
+    RTU_MonitorMode_t mode;
+    volatile uint32_t head; // free-running write offset, written by RTUSlave_TimerHandler()
+    volatile uint32_t tail; // free-running read offset, written by RTUSlave_MonitorRead()
+    uint32_t dropped;       // frames lost because the ring was full
+    uint8_t ring[RTU_MONITOR_RING_SIZE];
+} RTU_Monitor_t;
+#endif
+
+#if RTU_PENDING_MAX
+typedef enum
+{
+    RTU_PEND_FREE,
+    RTU_PEND_WAIT,  // parked, waiting for RTUSlave_CompletePending()
+    RTU_PEND_READY, // run again on the next idle RTUSlave_TimerHandler()
+} RTU_PendState_t;
+
+typedef struct
+{
+    volatile uint8_t state; // RTU_PendState_t, set by RTUSlave_CompletePending()
+    bool silent;            // broadcast or superseded by a newer request: no reply
+    uint16_t len;
+    uint16_t resume;        // registers / coils of a multiple write already stored
+    uint8_t frame[RTU_PENDING_FRAME_SIZE];
+} RTU_Pending_t;
+#endif
+
+#if RTU_RESP_CACHE_SIZE
+typedef struct
+{
+    uint8_t func;     // 0 = empty
+    uint16_t addr;
+    uint16_t num;
+    uint32_t version; // class data version the frame was built from
+    uint8_t frame[5U + RTU_RESP_CACHE_REGS * 2U];
+} RTU_RespCache_t;
+#endif
+
+#if RTU_PERSIST_ENABLE
+typedef struct
+{
+    uint8_t *map;          // MAP_SHARED view of the store file, NULL = closed
+    int fd;                // store file, open while map is set
+    size_t mapSize;
+    size_t slotSize;       // one checkpoint slot, page aligned
+    size_t words;          // registers saved per checkpoint
+    uint32_t seq;          // sequence number of the newest checkpoint
+    uint8_t active;        // slot holding the newest checkpoint
+    bool unsynced;         // newest checkpoint was only scheduled (MS_ASYNC)
+    uint32_t savedVersion; // holdVersion the newest checkpoint was taken at
+    bool waiting;          // unsaved changes seen since `since`
+    uint32_t since;        // ms timestamp of the first unsaved change
+} RTU_Persist_t;
+#endif
+
 typedef struct
 {
     uint8_t id;
-    uint8_t buf[RTU_DEFAULT_BUF_SIZE];
+    bool broadcast; // current request was sent to RTU_BROADCAST_ID
+    uint8_t buf[RTU_FRAME_BUF_SIZE];
     uint16_t buf_size;
 
     volatile RTU_GFrame_t g_frame;
 
-    RTU_Register_t *coils;       // coils / read and write
-    RTU_Register_t *holdingRegs; // holding / read and write
-    RTU_Register_t *inputRegs;   // input register / read only
+    RTU_RegList_t coils;          // coils / read and write
+    RTU_RegList_t holdingRegs;    // holding / read and write
+    RTU_RegList_t inputRegs;      // input register / read only
+    RTU_RegList_t discreteInputs; // discrete input / read only
+
+    RTU_BitImage_t discreteImage; // packed discrete inputs / read only
+
+    RTU_Fifo_t *fifos[RTU_MAX_FIFOS]; // fifo queues / read only
+
+    RTU_FileRecordMap_t *files; // file records / read and write
+    size_t fileNum;
+
+    uint8_t *arena;     // register metadata pool, NULL = heap
+    size_t arenaSize;
+    size_t arenaUsed;
+    size_t arenaPeak;   // high-water mark of arenaUsed
+
+#if RTU_HOT_SWAP
+    RTU_SwapSlot_t swapSlot[4][RTU_SWAP_SLOTS]; // per RTU_RegClass_t
+    RTU_SwapSlot_t *swapNew[4];                 // published, not yet adopted
+    volatile bool swapPending;                  // something to adopt or release
+    volatile bool arenaLock;                    // arena and slots claimed by a writer or the server
+#endif
+
+    uint8_t funcSlot[256]; // function code -> userFuncs index + 1, 0 = built-in
+    RTUSlave_FuncHandler_t userFuncs[RTU_MAX_USER_FUNCS];
+
+#if RTU_MONITOR_ENABLE
+    RTU_Monitor_t mon; // bus monitor capture ring
+#endif
+
+#if RTU_PENDING_MAX
+    RTU_Pending_t pending[RTU_PENDING_MAX];
+    uint8_t reqCopy[RTU_PENDING_FRAME_SIZE]; // current request as received
+    uint16_t reqLen;                         // 0 = too long to park
+    uint8_t curSlot;                         // pending index + 1 while re-running, 0 = new request
+    uint16_t resumeFrom;                     // first register / coil a re-run still writes
+    bool deferred;                           // current request was parked
+#endif
+
+#if RTU_RESP_CACHE_SIZE
+    RTU_RespCache_t respCache[RTU_RESP_CACHE_SIZE]; // encoded 0x03 / 0x04 responses
+    uint8_t respCacheNext;                          // next entry to replace
+#endif
+
+#if RTU_RESP_CACHE_SIZE || RTU_PERSIST_ENABLE
+    volatile uint32_t holdVersion;  // bumped when holding registers change
+    volatile uint32_t inputVersion; // bumped when input registers change
+#endif
+
+#if RTU_PERSIST_ENABLE
+    RTU_Persist_t persist; // memory-mapped holding register store
+#endif
+
+#if RTU_SHM_ENABLE
+    RTU_ShmImage_t *shm; // attached shared-memory image, NULL = none
+    size_t shmSize;
+#endif
+
+#if RTU_DIRTY_TRACKING
+    RTU_DirtySet_t dirtyHold;  // holding registers written by the master
+    RTU_DirtySet_t dirtyCoils; // coils written by the master
+    uint16_t dirtyHoldQueue[RTU_MAX_HOLD_REGS];
+    uint32_t dirtyHoldMark[(RTU_MAX_HOLD_REGS + 31U) / 32U];
+    uint16_t dirtyCoilQueue[RTU_MAX_COILS];
+    uint32_t dirtyCoilMark[(RTU_MAX_COILS + 31U) / 32U];
+#endif
 
 } RTU_SlaveObj_t;
 
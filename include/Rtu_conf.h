@@ -33,6 +33,617 @@ extern "C" {
 #define RTU_DEFAULT_BUF_SIZE    (256U)
 #endif
 
+/* ============================================================
+ * Memory configuration
+ * ============================================================
+ */
+
+/**
+ * @brief Forbid heap use (0 = heap allowed, 1 = no malloc/free)
+ *
+ * When set, the library never calls calloc()/free(). Register maps must
+ * then be placed in the arena given to RTUSlave_InitArena() or served from
+ * const tables (RTUSlave_RegisterTable()); other registrations fail.
+ */
+#ifndef RTU_NO_MALLOC
+#define RTU_NO_MALLOC           (0)
+#endif
+
+/**
+ * @brief Replace register maps while the slave is serving (0 = off, 1 = on)
+ *
+ * 0: RTUSlave_Register*() free the old map and build the new one in place;
+ *    they must not run while RTUSlave_TimerHandler() does
+ * 1: RTUSlave_Register*() build the complete new map aside and publish it,
+ *    from any thread. The next RTUSlave_TimerHandler() call switches to it
+ *    before looking at a frame and frees the old one there, when no request
+ *    can still reference it. Request processing takes no lock; the handler
+ *    only tries to claim the published map. With an arena, old and new map
+ *    must fit in it together. RTUSlave_FetchDirty() and
+ *    RTUSlave_PersistOpen() switch maps too, so they belong to the
+ *    handler's context.
+ *
+ * Needs GCC-compatible __atomic builtins.
+ */
+#ifndef RTU_HOT_SWAP
+#define RTU_HOT_SWAP            (0)
+#endif
+
+/**
+ * @brief Insert, remove and rebind single registers (0 = off, 1 = on)
+ *
+ * 1: RTUSlave_InsertRegs() / RTUSlave_RemoveRegs() / RTUSlave_RebindRegs()
+ *    change a register class entry by entry in O(log n), without rebuilding
+ *    it. The first call moves the class into a pool of node slots indexed by
+ *    an AVL tree (sizeof(RTU_Register_t) + 6 bytes per slot); the pool
+ *    doubles when full, up to RTU_MAX_* of the class.
+ */
+#ifndef RTU_DYNAMIC_REGS
+#define RTU_DYNAMIC_REGS        (0)
+#endif
+
+/* ============================================================
+ * Extended frame configuration (vendor function code)
+ * ============================================================
+ */
+
+/**
+ * @brief Enable the extended large-frame function code (0 = off, 1 = on)
+ *
+ * Intended for dedicated point-to-point links only. Adds the vendor
+ * function code RTU_EXT_FUNC_CODE, which reads/writes register blocks of up
+ * to RTU_EXT_MAX_REGS registers with a 16-bit byte count and the usual CRC.
+ *
+ * Standard masters never send this code, so enabling it does not change
+ * behaviour on a shared bus; it only enlarges the frame buffer.
+ */
+#ifndef RTU_EXT_FRAME_ENABLE
+#define RTU_EXT_FRAME_ENABLE    (0)
+#endif
+
+/**
+ * @brief Vendor function code used for extended frames (user-defined range 65 ~ 72)
+ */
+#ifndef RTU_EXT_FUNC_CODE
+#define RTU_EXT_FUNC_CODE       (0x41U)
+#endif
+
+/**
+ * @brief Maximum number of registers in one extended frame
+ */
+#ifndef RTU_EXT_MAX_REGS
+#define RTU_EXT_MAX_REGS        (1024U)
+#endif
+
+/**
+ * @brief Frame buffer size when extended frames are enabled (in bytes)
+ *
+ * Largest frame is a write request:
+ *   1 (ID) + 1 (FUNC) + 1 (SUB) + 4 (ADDR/QTY) + 2 (BYTE COUNT) + 2 * regs (DATA) + 2 (CRC)
+ */
+#ifndef RTU_EXT_BUF_SIZE
+#define RTU_EXT_BUF_SIZE        (RTU_EXT_MAX_REGS * 2U + 11U)
+#endif
+
+#if RTU_EXT_FRAME_ENABLE && (RTU_EXT_BUF_SIZE > RTU_DEFAULT_BUF_SIZE)
+#define RTU_FRAME_BUF_SIZE      RTU_EXT_BUF_SIZE
+#else
+#define RTU_FRAME_BUF_SIZE      RTU_DEFAULT_BUF_SIZE
+#endif
+
+#if RTU_FRAME_BUF_SIZE > 65535U
+#error "RTU_FRAME_BUF_SIZE must fit in 16 bits"
+#endif
+
+/* ============================================================
+ * Typed register configuration
+ * ============================================================
+ */
+
+/**
+ * @brief 32/64-bit and floating point register entries (0 = off, 1 = on)
+ *
+ * A holding / input register map entry may then describe a uint32_t,
+ * int32_t, float (2 registers) or uint64_t, int64_t, double (4 registers)
+ * variable with one node, in any of the ABCD / CDAB / BADC / DCBA word
+ * orders. Reads and writes always cover the whole value; a request that
+ * starts or ends inside it is answered with RTU_EX_ILLEGAL_ADDR.
+ */
+#ifndef RTU_TYPED_REGS
+#define RTU_TYPED_REGS          (0)
+#endif
+
+/* ============================================================
+ * Write configuration
+ * ============================================================
+ */
+
+/**
+ * @brief All-or-nothing multi-register writes (0 = per register, 1 = staged)
+ *
+ * Affects 0x0F (Write Multiple Coils), 0x10 (Write Multiple Registers) and
+ * the extended write.
+ * - 0: each register's write callback runs right before that register is
+ *      stored; an exception midway leaves the earlier registers written
+ * - 1: every write callback of the block is run first, with the values
+ *      taken from the request (the shadow copy); the block is stored only
+ *      when all of them return RTU_EX_NONE, otherwise nothing is written
+ *
+ * In staged mode callbacks act as validators: while they run, the
+ * variables still hold the old values.
+ */
+#ifndef RTU_STAGED_WRITES
+#define RTU_STAGED_WRITES       (0)
+#endif
+
+/**
+ * @brief Track holding registers and coils changed by the master (0 = off, 1 = on)
+ *
+ * Every master write (0x05, 0x06, 0x0F, 0x10, extended write) that changes
+ * a value queues that register once; RTUSlave_FetchDirty() returns and
+ * clears the queued addresses in O(changed).
+ *
+ * Costs 2 bytes + 1 bit of RAM per RTU_MAX_HOLD_REGS / RTU_MAX_COILS entry.
+ */
+#ifndef RTU_DIRTY_TRACKING
+#define RTU_DIRTY_TRACKING      (0)
+#endif
+
+/* ============================================================
+ * Deferred response configuration
+ * ============================================================
+ */
+
+/**
+ * @brief Number of requests that can wait for a deferred response (0 = off)
+ *
+ * A register/file callback or function-code handler that cannot answer yet
+ * (slow EEPROM, request forwarded to another bus, ...) returns
+ * RTU_EX_PENDING. The request is parked in one of these slots and run again
+ * after RTUSlave_CompletePending(); the response goes out then.
+ * When every slot is taken, or with 0, RTU_EX_SLAVE_BUSY is sent instead.
+ */
+#ifndef RTU_PENDING_MAX
+#define RTU_PENDING_MAX         (0)
+#endif
+
+/**
+ * @brief Longest request (bytes, CRC included) that can be parked
+ *
+ * Longer requests answer RTU_EX_PENDING with RTU_EX_SLAVE_BUSY.
+ * RAM cost: RTU_PENDING_MAX + 1 copies of this size.
+ */
+#ifndef RTU_PENDING_FRAME_SIZE
+#define RTU_PENDING_FRAME_SIZE  (64U)
+#endif
+
+#if RTU_PENDING_MAX > 255
+#error "RTU_PENDING_MAX must be <= 255"
+#endif
+
+#if RTU_PENDING_MAX && ((RTU_PENDING_FRAME_SIZE < 8U) || (RTU_PENDING_FRAME_SIZE > RTU_FRAME_BUF_SIZE))
+#error "RTU_PENDING_FRAME_SIZE must be between 8 and RTU_FRAME_BUF_SIZE"
+#endif
+
+/* ============================================================
+ * Response cache configuration
+ * ============================================================
+ */
+
+/**
+ * @brief Number of cached 0x03 / 0x04 responses (0 = off)
+ *
+ * Masters tend to poll the same ranges every cycle. Each entry keeps the
+ * complete encoded response (CRC included) of one (function, address,
+ * quantity) request; a repeated poll is answered with the stored frame as
+ * long as the register class has not changed since.
+ *
+ * A class counts as changed after any master write, a seqlock group
+ * write (RTUSlave_GroupWriteEnd()), re-registration, or
+ * RTUSlave_RegsChanged(). The application must call one of the latter two
+ * after updating plain variables, or stale values are served.
+ * Ranges with a read callback are never cached.
+ */
+#ifndef RTU_RESP_CACHE_SIZE
+#define RTU_RESP_CACHE_SIZE     (0)
+#endif
+
+/**
+ * @brief Largest cached response, in registers
+ *
+ * RAM cost: RTU_RESP_CACHE_SIZE * (RTU_RESP_CACHE_REGS * 2 + 16) bytes.
+ */
+#ifndef RTU_RESP_CACHE_REGS
+#define RTU_RESP_CACHE_REGS     (32U)
+#endif
+
+#if RTU_RESP_CACHE_SIZE > 255
+#error "RTU_RESP_CACHE_SIZE must be <= 255"
+#endif
+
+#if RTU_RESP_CACHE_SIZE && ((RTU_RESP_CACHE_REGS < 1U) || (RTU_RESP_CACHE_REGS > 125U))
+#error "RTU_RESP_CACHE_REGS must be between 1 and 125"
+#endif
+
+/* ============================================================
+ * Persistent holding register configuration
+ * ============================================================
+ */
+
+/**
+ * @brief Keep holding registers in a memory-mapped file (0 = off, 1 = on)
+ *
+ * POSIX hosts only (mmap / msync). Adds RTUSlave_PersistOpen(): the file
+ * holds two checkpoint slots of the holding register values; changes are
+ * written behind into the older slot and msync'ed in one batch, so a crash
+ * always leaves the last complete checkpoint. Checkpoints are taken
+ * between requests, so a multi-register write is saved entirely or not
+ * at all.
+ *
+ * RTUSlave_TimerHandler() only schedules the write-back (MS_ASYNC); before
+ * the next checkpoint reuses a slot it waits for the previous write-back
+ * (MS_SYNC), which had RTU_PERSIST_FLUSH_MS to finish.
+ * RTUSlave_PersistFlush() / RTUSlave_PersistClose() wait for the disk.
+ * Call one of them before a controlled power-off.
+ *
+ * Changes made by the application count once it calls
+ * RTUSlave_RegsChanged() or RTUSlave_GroupWriteEnd().
+ */
+#ifndef RTU_PERSIST_ENABLE
+#define RTU_PERSIST_ENABLE      (0)
+#endif
+
+/**
+ * @brief Write-behind delay (in milliseconds)
+ *
+ * A checkpoint is written at most this long after the first unsaved
+ * change; every change in between goes into the same msync. 0 saves on
+ * the next idle RTUSlave_TimerHandler() call.
+ */
+#ifndef RTU_PERSIST_FLUSH_MS
+#define RTU_PERSIST_FLUSH_MS    (1000U)
+#endif
+
+/* ============================================================
+ * Shared-memory register image configuration
+ * ============================================================
+ */
+
+/**
+ * @brief POSIX shared-memory register image (0 = off, 1 = on)
+ *
+ * POSIX only (shm_open / mmap; link with -lrt on older glibc). Adds
+ * RTUSlave_ShmAttach(): an image of register blocks, each guarded by its
+ * own seqlock (an RTU_RegGroup_t), that other processes map and update in
+ * place. Input / holding register entries point straight into it, so
+ * producer values reach the master without any IPC copy.
+ */
+#ifndef RTU_SHM_ENABLE
+#define RTU_SHM_ENABLE          (0)
+#endif
+
+/**
+ * @brief Registers per shared-memory block (one seqlock each)
+ *
+ * A block is the unit a producer updates atomically. Must match in every
+ * process attaching the image.
+ */
+#ifndef RTU_SHM_BLOCK_REGS
+#define RTU_SHM_BLOCK_REGS      (32U)
+#endif
+
+#if (RTU_SHM_BLOCK_REGS < 1U) || (RTU_SHM_BLOCK_REGS > 4096U)
+#error "RTU_SHM_BLOCK_REGS must be between 1 and 4096"
+#endif
+
+/* ============================================================
+ * Bus monitor configuration
+ * ============================================================
+ */
+
+/**
+ * @brief Enable the bus monitor (0 = off, 1 = on)
+ *
+ * Adds RTUSlave_SetMonitor() / RTUSlave_MonitorRead(): every frame seen on
+ * the line (any slave id, requests, responses, exceptions, CRC failures) is
+ * time-stamped and appended to a binary capture ring, which the application
+ * drains to a file or port. Decode captures with tools/rtu_capdecode.py.
+ */
+#ifndef RTU_MONITOR_ENABLE
+#define RTU_MONITOR_ENABLE      (0)
+#endif
+
+/**
+ * @brief Capture ring size (in bytes)
+ *
+ * Must be a power of two. Each frame takes 8 header bytes plus the frame.
+ */
+#ifndef RTU_MONITOR_RING_SIZE
+#define RTU_MONITOR_RING_SIZE   (4096U)
+#endif
+
+#if RTU_MONITOR_ENABLE && (RTU_MONITOR_RING_SIZE & (RTU_MONITOR_RING_SIZE - 1U)) != 0U
+#error "RTU_MONITOR_RING_SIZE must be a power of two"
+#endif
+
+/* ============================================================
+ * Function code / register class selection
+ * ============================================================
+ */
+
+/**
+ * @brief Register classes compiled into the slave (0 = excluded, 1 = included)
+ *
+ * Excluding a class drops every function code that serves it together with
+ * the helpers only those codes use. Its registration functions stay
+ * available but return RTU_ERR, and its requests are answered with
+ * exception 0x01 (Illegal Function).
+ *
+ * Example (device that only serves input registers):
+ *   -DRTU_COILS_ENABLE=0 -DRTU_DISCRETE_INPUTS_ENABLE=0 -DRTU_HOLD_REGS_ENABLE=0
+ *   -DRTU_FIFO_ENABLE=0 -DRTU_FILE_RECORD_ENABLE=0
+ */
+#ifndef RTU_COILS_ENABLE
+#define RTU_COILS_ENABLE            (1)
+#endif
+
+#ifndef RTU_DISCRETE_INPUTS_ENABLE
+#define RTU_DISCRETE_INPUTS_ENABLE  (1)
+#endif
+
+#ifndef RTU_HOLD_REGS_ENABLE
+#define RTU_HOLD_REGS_ENABLE        (1)
+#endif
+
+#ifndef RTU_INPUT_REGS_ENABLE
+#define RTU_INPUT_REGS_ENABLE       (1)
+#endif
+
+/**
+ * @brief FIFO queues, function code 0x18 (Read FIFO Queue)
+ */
+#ifndef RTU_FIFO_ENABLE
+#define RTU_FIFO_ENABLE             (1)
+#endif
+
+/**
+ * @brief File records, function codes 0x14 / 0x15 (Read / Write File Record)
+ */
+#ifndef RTU_FILE_RECORD_ENABLE
+#define RTU_FILE_RECORD_ENABLE      (1)
+#endif
+
+/**
+ * @brief Individual function codes (default: follow their register class)
+ *
+ * Allows e.g. a read-only holding register image by disabling 0x06 / 0x10
+ * while keeping 0x03.
+ */
+#ifndef RTU_FC_READ_COILS_ENABLE
+#define RTU_FC_READ_COILS_ENABLE            RTU_COILS_ENABLE            // 0x01
+#endif
+
+#ifndef RTU_FC_WRITE_SINGLE_COIL_ENABLE
+#define RTU_FC_WRITE_SINGLE_COIL_ENABLE     RTU_COILS_ENABLE            // 0x05
+#endif
+
+#ifndef RTU_FC_WRITE_MULTIPLE_COILS_ENABLE
+#define RTU_FC_WRITE_MULTIPLE_COILS_ENABLE  RTU_COILS_ENABLE            // 0x0F
+#endif
+
+#ifndef RTU_FC_READ_DISCRETE_INPUTS_ENABLE
+#define RTU_FC_READ_DISCRETE_INPUTS_ENABLE  RTU_DISCRETE_INPUTS_ENABLE  // 0x02
+#endif
+
+#ifndef RTU_FC_READ_HOLD_REGS_ENABLE
+#define RTU_FC_READ_HOLD_REGS_ENABLE        RTU_HOLD_REGS_ENABLE        // 0x03
+#endif
+
+#ifndef RTU_FC_WRITE_SINGLE_REG_ENABLE
+#define RTU_FC_WRITE_SINGLE_REG_ENABLE      RTU_HOLD_REGS_ENABLE        // 0x06
+#endif
+
+#ifndef RTU_FC_WRITE_MULTIPLE_REGS_ENABLE
+#define RTU_FC_WRITE_MULTIPLE_REGS_ENABLE   RTU_HOLD_REGS_ENABLE        // 0x10
+#endif
+
+#ifndef RTU_FC_READ_INPUT_REGS_ENABLE
+#define RTU_FC_READ_INPUT_REGS_ENABLE       RTU_INPUT_REGS_ENABLE       // 0x04
+#endif
+
+#if (RTU_FC_READ_COILS_ENABLE || RTU_FC_WRITE_SINGLE_COIL_ENABLE || RTU_FC_WRITE_MULTIPLE_COILS_ENABLE) && !RTU_COILS_ENABLE
+#error "coil function codes need RTU_COILS_ENABLE"
+#endif
+
+#if RTU_FC_READ_DISCRETE_INPUTS_ENABLE && !RTU_DISCRETE_INPUTS_ENABLE
+#error "0x02 needs RTU_DISCRETE_INPUTS_ENABLE"
+#endif
+
+#if (RTU_FC_READ_HOLD_REGS_ENABLE || RTU_FC_WRITE_SINGLE_REG_ENABLE || RTU_FC_WRITE_MULTIPLE_REGS_ENABLE) && !RTU_HOLD_REGS_ENABLE
+#error "holding register function codes need RTU_HOLD_REGS_ENABLE"
+#endif
+
+#if RTU_FC_READ_INPUT_REGS_ENABLE && !RTU_INPUT_REGS_ENABLE
+#error "0x04 needs RTU_INPUT_REGS_ENABLE"
+#endif
+
+#if RTU_PERSIST_ENABLE && !RTU_HOLD_REGS_ENABLE
+#error "RTU_PERSIST_ENABLE needs RTU_HOLD_REGS_ENABLE"
+#endif
+
+/* ============================================================
+ * Master configuration (src/RtuMaster.c)
+ * ============================================================
+ */
+
+/**
+ * @brief Frame buffer of each master line (in bytes)
+ *
+ * Holds one request and one response; 256 fits every standard frame.
+ */
+#ifndef RTU_MASTER_BUF_SIZE
+#define RTU_MASTER_BUF_SIZE         (256U)
+#endif
+
+/**
+ * @brief Timer wheel resolution (in microseconds)
+ *
+ * Gaps, frame ends and response timeouts are rounded up to this tick.
+ */
+#ifndef RTU_MASTER_TICK_US
+#define RTU_MASTER_TICK_US          (100U)
+#endif
+
+/**
+ * @brief Timer wheel geometry: 2^BITS slots per level, LEVELS levels
+ *
+ * The wheel spans 2^(BITS * LEVELS) ticks (default 2^24 x 100 us = 27 min);
+ * longer timers are clamped to that.
+ */
+#ifndef RTU_MASTER_WHEEL_BITS
+#define RTU_MASTER_WHEEL_BITS       (6U)
+#endif
+
+#ifndef RTU_MASTER_WHEEL_LEVELS
+#define RTU_MASTER_WHEEL_LEVELS     (4U)
+#endif
+
+/**
+ * @brief Default response timeout (in milliseconds), counted from the end of the request
+ */
+#ifndef RTU_MASTER_TIMEOUT_MS
+#define RTU_MASTER_TIMEOUT_MS       (1000U)
+#endif
+
+/**
+ * @brief Turnaround delay after a broadcast (in milliseconds)
+ *
+ * Slaves process a broadcast without answering; the line stays quiet this
+ * long before the next request.
+ */
+#ifndef RTU_MASTER_BCAST_DELAY_MS
+#define RTU_MASTER_BCAST_DELAY_MS   (100U)
+#endif
+
+/**
+ * @brief Adaptive master timing
+ *
+ * 1: learn the turnaround time of each slave and wait mean + K * sigma for
+ *    its responses instead of the full line timeout
+ * 0: fixed line timeout (default)
+ */
+#ifndef RTU_MASTER_ADAPTIVE
+#define RTU_MASTER_ADAPTIVE         (0U)
+#endif
+
+/**
+ * @brief Master inter-frame gap above 19200 baud
+ *
+ * 1: exact t3.5 of the baud rate (334 us at 115200). Only for buses where
+ *    every slave ends frames after 3.5 characters as well: a slave using
+ *    the fixed 1750 us of the spec merges frames sent this close into one.
+ * 0: the fixed 1750 us of the spec (default)
+ */
+#ifndef RTU_MASTER_EXACT_GAP
+#define RTU_MASTER_EXACT_GAP        (0U)
+#endif
+
+/**
+ * @brief Slaves tracked per line; the least recently polled entry is reused
+ */
+#ifndef RTU_MASTER_ADAPT_SLAVES
+#define RTU_MASTER_ADAPT_SLAVES     (16U)
+#endif
+
+/**
+ * @brief Timeout = mean + K * sigma of the measured turnaround
+ */
+#ifndef RTU_MASTER_ADAPT_K
+#define RTU_MASTER_ADAPT_K          (4U)
+#endif
+
+/**
+ * @brief Responses measured before the learned timeout replaces the line timeout
+ */
+#ifndef RTU_MASTER_ADAPT_SAMPLES
+#define RTU_MASTER_ADAPT_SAMPLES    (8U)
+#endif
+
+/**
+ * @brief Lower bound of a learned timeout (in microseconds); the line timeout is the upper bound
+ */
+#ifndef RTU_MASTER_ADAPT_FLOOR_US
+#define RTU_MASTER_ADAPT_FLOOR_US   (2000U)
+#endif
+
+/**
+ * @brief Multi-line master runtime (Linux: pthreads, epoll, timerfd)
+ *
+ * 1: RTUMaster_Runtime*() open serial lines, poll a tag table from one
+ *    thread per line or from sharded epoll threads, and publish results
+ *    that readers take without locks
+ * 0: not compiled, the runtime API returns errors (default)
+ */
+#ifndef RTU_MASTER_RUNTIME
+#define RTU_MASTER_RUNTIME          (0U)
+#endif
+
+/**
+ * @brief Value capacity of one runtime tag (in registers; bit tags hold 16 bits per register)
+ */
+#ifndef RTU_MASTER_TAG_REGS
+#define RTU_MASTER_TAG_REGS         (125U)
+#endif
+
+#if RTU_MASTER_BUF_SIZE < 16U || RTU_MASTER_BUF_SIZE > 65535U
+#error "RTU_MASTER_BUF_SIZE must be between 16 and 65535"
+#endif
+
+#if RTU_MASTER_TICK_US < 1U
+#error "RTU_MASTER_TICK_US must be at least 1"
+#endif
+
+#if RTU_MASTER_WHEEL_BITS < 1U || RTU_MASTER_WHEEL_LEVELS < 1U || \
+    RTU_MASTER_WHEEL_BITS * RTU_MASTER_WHEEL_LEVELS > 31U
+#error "RTU_MASTER_WHEEL_BITS * RTU_MASTER_WHEEL_LEVELS must be between 1 and 31"
+#endif
+
+#if RTU_MASTER_ADAPTIVE && (RTU_MASTER_ADAPT_SLAVES < 1U || RTU_MASTER_ADAPT_SLAVES > 247U)
+#error "RTU_MASTER_ADAPT_SLAVES must be between 1 and 247"
+#endif
+
+#if RTU_MASTER_RUNTIME && (RTU_MASTER_TAG_REGS < 1U || RTU_MASTER_TAG_REGS > 125U)
+#error "RTU_MASTER_TAG_REGS must be between 1 and 125"
+#endif
+
+/* ============================================================
+ * Data kernel configuration
+ * ============================================================
+ */
+
+/**
+ * @brief Vector kernels for register and coil data (src/RtuKernels.c)
+ *
+ * 1: array-backed runs of registers / coils (consecutive addresses whose
+ *    values are consecutive array elements) are byte-swapped and bit-packed
+ *    with SSE2 / AVX2 (x86-64) or NEON (AArch64) kernels, in the slave read
+ *    and write paths and in the master; other CPUs use the scalar kernels
+ * 0: the slave and master keep their per-node loops, RtuKernels.c is not
+ *    needed (default)
+ */
+#ifndef RTU_SIMD_ENABLE
+#define RTU_SIMD_ENABLE             (0U)
+#endif
+
+/**
+ * @brief Pick the AVX2 kernels at run time when the CPU has them (x86-64, GCC / Clang)
+ *
+ * 0: SSE2 only, for targets where AVX2 frequency drops are not wanted
+ */
+#ifndef RTU_SIMD_AVX2
+#define RTU_SIMD_AVX2               (1U)
+#endif
+
 /* ============================================================
  * Register capacity configuration
  * ============================================================
@@ -78,6 +689,83 @@ extern "C" {
 #endif
 
 
+/**
+ * @brief Maximum number of discrete inputs (bit type, read-only)
+ *
+ * Used for function code:
+ * - 0x02 (Read Discrete Inputs)
+ *
+ * Only limits the node table; a packed bitmap registered with
+ * RTUSlave_RegisterDiscreteBitmap() may hold up to 65535 inputs.
+ */
+#ifndef RTU_MAX_DISCRETE_INPUTS
+#define RTU_MAX_DISCRETE_INPUTS (128U)
+#endif
+
+
+/**
+ * @brief Maximum number of FIFO queues
+ *
+ * Used for function code:
+ * - 0x18 (Read FIFO Queue)
+ */
+#ifndef RTU_MAX_FIFOS
+#define RTU_MAX_FIFOS           (4U)
+#endif
+
+
+/**
+ * @brief Depth of each FIFO queue (in 16-bit values)
+ *
+ * Must be a power of two. One 0x18 request drains at most 31 values.
+ */
+#ifndef RTU_FIFO_DEPTH
+#define RTU_FIFO_DEPTH          (64U)
+#endif
+
+#if (RTU_FIFO_DEPTH & (RTU_FIFO_DEPTH - 1U)) != 0U || RTU_FIFO_DEPTH > 32768U
+#error "RTU_FIFO_DEPTH must be a power of two (<= 32768)"
+#endif
+
+
+/**
+ * @brief Snapshot attempts for seqlock register groups
+ *
+ * A read request that overlaps a group being updated is retried this many
+ * times before the slave answers with exception 0x06 (Slave Busy).
+ */
+#ifndef RTU_SEQLOCK_RETRIES
+#define RTU_SEQLOCK_RETRIES     (8U)
+#endif
+
+
+/**
+ * @brief Maximum number of files for file record access
+ *
+ * Used for function codes:
+ * - 0x14 (Read File Record)
+ * - 0x15 (Write File Record)
+ */
+#ifndef RTU_MAX_FILES
+#define RTU_MAX_FILES           (16U)
+#endif
+
+
+/**
+ * @brief Maximum number of user function-code handlers
+ *
+ * Slots for RTUSlave_RegisterFuncHandler(). A handler may serve a vendor
+ * function code or replace a built-in one.
+ */
+#ifndef RTU_MAX_USER_FUNCS
+#define RTU_MAX_USER_FUNCS      (8U)
+#endif
+
+#if RTU_MAX_USER_FUNCS > 255U
+#error "RTU_MAX_USER_FUNCS must be <= 255"
+#endif
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,278 @@
+/**
+ * @file RtuKernels.c
+ * @author xfp23
+ * @brief Vectorised encode / decode kernels for Modbus register and coil data
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * - 寄存器块大端编解码：16 位字节交换拷贝
+ * - 线圈位打包 / 解包：每个线圈一个字节 <-> LSB 优先的位串
+ * - x86-64 使用 SSE2，CPU 支持时运行时切换到 AVX2；AArch64 使用 NEON；其余走标量
+ */
+
+#include "RtuKernels.h"
+#include "string.h"
+
+#if RTU_SIMD_ENABLE && defined(__SSE2__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define RTU_KERNEL_SSE2 1
+#include "emmintrin.h"
+#if RTU_SIMD_AVX2 && defined(__GNUC__)
+#define RTU_KERNEL_AVX2 1
+#include "immintrin.h"
+#define RTU_HAS_AVX2() __builtin_cpu_supports("avx2")
+#endif
+#elif RTU_SIMD_ENABLE && defined(__aarch64__) && defined(__ARM_NEON) && defined(__ORDER_LITTLE_ENDIAN__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define RTU_KERNEL_NEON 1
+#include "arm_neon.h"
+#endif
+
+#if RTU_KERNEL_NEON
+/* bit weight of each lane, LSB first within each packed byte */
+static const uint8_t rtu_bit_weight[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+#endif
+
+/* ---------- 16 位字节交换：8 / 16 个寄存器一组 ---------- */
+
+#if RTU_KERNEL_SSE2
+static size_t rtu_swap16_sse2(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + k * 2));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *)(dst + k * 2), v);
+    }
+    return k;
+}
+#endif
+
+#if RTU_KERNEL_AVX2
+__attribute__((target("avx2"))) static size_t rtu_swap16_avx2(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    const __m256i order = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                           1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + k * 2));
+        _mm256_storeu_si256((__m256i *)(dst + k * 2), _mm256_shuffle_epi8(v, order));
+    }
+    return k + rtu_swap16_sse2(dst + k * 2, src + k * 2, n - k);
+}
+#endif
+
+#if RTU_KERNEL_NEON
+static size_t rtu_swap16_neon(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8)
+        vst1q_u8(dst + k * 2, vrev16q_u8(vld1q_u8(src + k * 2)));
+    return k;
+}
+#endif
+
+/* Byte-swap as many registers as the vector unit takes; returns how many were done */
+static size_t rtu_swap16_vec(uint8_t *dst, const uint8_t *src, size_t n)
+{
+#if RTU_KERNEL_AVX2
+    if (RTU_HAS_AVX2())
+        return rtu_swap16_avx2(dst, src, n);
+#endif
+#if RTU_KERNEL_SSE2
+    return rtu_swap16_sse2(dst, src, n);
+#elif RTU_KERNEL_NEON
+    return rtu_swap16_neon(dst, src, n);
+#else
+    (void)dst;
+    (void)src;
+    (void)n;
+    return 0;
+#endif
+}
+
+void RTUKernel_BswapStore16(uint8_t *dst_be, const uint16_t *src, size_t n)
+{
+    size_t k = rtu_swap16_vec(dst_be, (const uint8_t *)src, n);
+    for (; k < n; k++)
+    {
+        dst_be[k * 2 + 0] = (uint8_t)(src[k] >> 8);
+        dst_be[k * 2 + 1] = (uint8_t)(src[k] & 0xFF);
+    }
+}
+
+void RTUKernel_BswapLoad16(uint16_t *dst, const uint8_t *src_be, size_t n)
+{
+    size_t k = rtu_swap16_vec((uint8_t *)dst, src_be, n);
+    for (; k < n; k++)
+        dst[k] = (uint16_t)(((uint16_t)src_be[k * 2] << 8) | src_be[k * 2 + 1]);
+}
+
+/* ---------- 位打包：16 / 32 个线圈一组，非零即 ON ---------- */
+
+#if RTU_KERNEL_SSE2
+static size_t rtu_pack_sse2(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + k));
+        unsigned m = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero));
+        dst[k / 8 + 0] = (uint8_t)(m & 0xFF);
+        dst[k / 8 + 1] = (uint8_t)((m >> 8) & 0xFF);
+    }
+    return k;
+}
+#endif
+
+#if RTU_KERNEL_AVX2
+__attribute__((target("avx2"))) static size_t rtu_pack_avx2(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + k));
+        uint32_t m = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero));
+        memcpy(&dst[k / 8], &m, sizeof(m));
+    }
+    return k + rtu_pack_sse2(dst + k / 8, src + k, n - k);
+}
+#endif
+
+#if RTU_KERNEL_NEON
+static size_t rtu_pack_neon(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    const uint8x16_t weight = vld1q_u8(rtu_bit_weight);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16)
+    {
+        uint8x16_t v = vld1q_u8(src + k);
+        v = vandq_u8(vtstq_u8(v, v), weight);
+        dst[k / 8 + 0] = vaddv_u8(vget_low_u8(v));
+        dst[k / 8 + 1] = vaddv_u8(vget_high_u8(v));
+    }
+    return k;
+}
+#endif
+
+void RTUKernel_PackBits(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    size_t k;
+#if RTU_KERNEL_AVX2
+    if (RTU_HAS_AVX2())
+        k = rtu_pack_avx2(dst, src, n);
+    else
+        k = rtu_pack_sse2(dst, src, n);
+#elif RTU_KERNEL_SSE2
+    k = rtu_pack_sse2(dst, src, n);
+#elif RTU_KERNEL_NEON
+    k = rtu_pack_neon(dst, src, n);
+#else
+    k = 0;
+#endif
+
+    for (; k < n; k += 8)
+    {
+        size_t end = (n - k < 8) ? (n - k) : 8;
+        uint8_t b = 0;
+        for (size_t j = 0; j < end; j++)
+            b |= (uint8_t)((src[k + j] != 0 ? 1u : 0u) << j);
+        dst[k / 8] = b;
+    }
+}
+
+/* ---------- 位解包：16 / 32 个线圈一组，输出 0 / 1 ---------- */
+
+#if RTU_KERNEL_SSE2
+static size_t rtu_unpack_sse2(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    const __m128i weight = _mm_set1_epi64x((long long)0x8040201008040201ULL);
+    const __m128i one = _mm_set1_epi8(1);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16)
+    {
+        /* b0 b1 -> b0 x 8, b1 x 8 */
+        __m128i v = _mm_cvtsi32_si128(src[k / 8] | (src[k / 8 + 1] << 8));
+        v = _mm_unpacklo_epi8(v, v);
+        v = _mm_unpacklo_epi16(v, v);
+        v = _mm_unpacklo_epi32(v, v);
+        v = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(v, weight), weight), one);
+        _mm_storeu_si128((__m128i *)(dst + k), v);
+    }
+    return k;
+}
+#endif
+
+#if RTU_KERNEL_AVX2
+__attribute__((target("avx2"))) static size_t rtu_unpack_avx2(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    /* every 128-bit lane holds the 4 source bytes, lane 0 spreads b0 b1, lane 1 b2 b3 */
+    const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                            2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i weight = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+    const __m256i one = _mm256_set1_epi8(1);
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32)
+    {
+        uint32_t w;
+        memcpy(&w, &src[k / 8], sizeof(w));
+        __m256i v = _mm256_shuffle_epi8(_mm256_set1_epi32((int)w), spread);
+        v = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(v, weight), weight), one);
+        _mm256_storeu_si256((__m256i *)(dst + k), v);
+    }
+    return k + rtu_unpack_sse2(dst + k, src + k / 8, n - k);
+}
+#endif
+
+#if RTU_KERNEL_NEON
+static size_t rtu_unpack_neon(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    const uint8x16_t weight = vld1q_u8(rtu_bit_weight);
+    const uint8x16_t one = vdupq_n_u8(1);
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16)
+    {
+        uint8x16_t v = vcombine_u8(vdup_n_u8(src[k / 8]), vdup_n_u8(src[k / 8 + 1]));
+        vst1q_u8(dst + k, vandq_u8(vtstq_u8(v, weight), one));
+    }
+    return k;
+}
+#endif
+
+void RTUKernel_UnpackBits(uint8_t *dst, const uint8_t *src, size_t n)
+{
+    size_t k;
+#if RTU_KERNEL_AVX2
+    if (RTU_HAS_AVX2())
+        k = rtu_unpack_avx2(dst, src, n);
+    else
+        k = rtu_unpack_sse2(dst, src, n);
+#elif RTU_KERNEL_SSE2
+    k = rtu_unpack_sse2(dst, src, n);
+#elif RTU_KERNEL_NEON
+    k = rtu_unpack_neon(dst, src, n);
+#else
+    k = 0;
+#endif
+
+    for (; k < n; k++)
+        dst[k] = (uint8_t)((src[k >> 3] >> (k & 0x07)) & 0x01);
+}
+
+const char *RTUKernel_Name(void)
+{
+#if RTU_KERNEL_AVX2
+    if (RTU_HAS_AVX2())
+        return "avx2";
+#endif
+#if RTU_KERNEL_SSE2
+    return "sse2";
+#elif RTU_KERNEL_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,1398 @@
+/**
+ * @file RtuMaster.c
+ * @author xfp23
+ * @brief Non-blocking Modbus RTU master
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * - 每条总线一个 RTU_Master_t，请求由调用者持有，排队时不拷贝
+ * - 提交立即返回，完成时调用请求的回调
+ * - 帧间隔、响应超时与帧结束检测都由共享的分级时间轮驱动
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // pthread_setaffinity_np() of the line runtime
+#endif
+
+#include "RtuMaster.h"
+#include "stddef.h"
+#include "string.h"
+#if RTU_SIMD_ENABLE
+#include "RtuKernels.h"
+#endif
+#if RTU_MASTER_RUNTIME
+#include "errno.h"
+#include "fcntl.h"
+#include "pthread.h"
+#include "sched.h"
+#include "stdlib.h"
+#include "sys/epoll.h"
+#include "sys/eventfd.h"
+#include "sys/timerfd.h"
+#include "termios.h"
+#include "time.h"
+#include "unistd.h"
+#endif
+
+#define RTU_WHEEL_MASK (RTU_WHEEL_SLOTS - 1UL)
+#define RTU_WHEEL_SPAN (1UL << (RTU_MASTER_WHEEL_BITS * RTU_MASTER_WHEEL_LEVELS))
+
+#define RTU_MASTER_OF(t) ((RTU_Master_t *)((uint8_t *)(t) - offsetof(RTU_Master_t, timer)))
+
+/* Acquire/release accessors for the runtime tag table; line counters have
+ * one writer and are read whole by other threads */
+#if defined(__GNUC__)
+#define RTU_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RTU_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define RTU_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define RTU_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define RTU_COUNT_ADD(c, n) __atomic_store_n(&(c), (c) + (n), __ATOMIC_RELAXED)
+#define RTU_COUNT_LOAD(c) __atomic_load_n(&(c), __ATOMIC_RELAXED)
+#else
+#define RTU_LOAD_ACQUIRE(p) (*(p))
+#define RTU_STORE_RELEASE(p, v) (*(p) = (v))
+#define RTU_FENCE_ACQUIRE()
+#define RTU_FENCE_RELEASE()
+#define RTU_COUNT_ADD(c, n) ((c) += (n))
+#define RTU_COUNT_LOAD(c) (c)
+#endif
+
+/* --- CRC16 (Modbus) --- */
+static uint16_t CRC16(const uint8_t *buf, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t pos = 0; pos < len; pos++)
+    {
+        crc ^= (uint16_t)buf[pos];
+        for (int i = 0; i < 8; i++)
+        {
+            if (crc & 0x0001)
+            {
+                crc >>= 1;
+                crc ^= 0xA001;
+            }
+            else
+            {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+/* ============================================================
+ * Timer wheel
+ * ============================================================
+ */
+
+/* Put an armed timer into the slot of the lowest level that covers it */
+static void rtu_wheel_place(RTU_TimerWheel_t *w, RTU_Timer_t *t)
+{
+    uint32_t delta = t->expire - w->now;
+    uint32_t level = 0;
+    while (level + 1U < RTU_MASTER_WHEEL_LEVELS && delta >= (1UL << (RTU_MASTER_WHEEL_BITS * (level + 1U))))
+        level++;
+
+    RTU_Timer_t **slot = &w->slot[level][(t->expire >> (RTU_MASTER_WHEEL_BITS * level)) & RTU_WHEEL_MASK];
+    t->next = *slot;
+    if (t->next != NULL)
+        t->next->pprev = &t->next;
+    t->pprev = slot;
+    *slot = t;
+}
+
+static void rtu_timer_stop(RTU_TimerWheel_t *w, RTU_Timer_t *t)
+{
+    if (t->pprev == NULL)
+        return;
+
+    *t->pprev = t->next;
+    if (t->next != NULL)
+        t->next->pprev = t->pprev;
+    t->pprev = NULL;
+    w->armed--;
+}
+
+/* (Re)arm a timer ticks from now; at least one tick, at most the wheel span */
+static void rtu_timer_start(RTU_TimerWheel_t *w, RTU_Timer_t *t, uint32_t ticks)
+{
+    rtu_timer_stop(w, t);
+    if (ticks == 0)
+        ticks = 1;
+    if (ticks >= RTU_WHEEL_SPAN)
+        ticks = RTU_WHEEL_SPAN - 1U;
+
+    t->expire = w->now + ticks;
+    rtu_wheel_place(w, t);
+    w->armed++;
+}
+
+/* Advance one tick: move higher-level slots that came up down, then fire level 0 */
+static void rtu_wheel_step(RTU_TimerWheel_t *w)
+{
+    w->now++;
+
+    for (uint32_t level = 1; level < RTU_MASTER_WHEEL_LEVELS; level++)
+    {
+        uint32_t shift = RTU_MASTER_WHEEL_BITS * level;
+        if ((w->now & ((1UL << shift) - 1UL)) != 0)
+            break;
+
+        RTU_Timer_t **slot = &w->slot[level][(w->now >> shift) & RTU_WHEEL_MASK];
+        RTU_Timer_t *t = *slot;
+        *slot = NULL;
+        while (t != NULL)
+        {
+            RTU_Timer_t *next = t->next;
+            rtu_wheel_place(w, t);
+            t = next;
+        }
+    }
+
+    /* move the due slot to a local list first: callbacks may stop or re-arm any timer */
+    RTU_Timer_t *due = w->slot[0][w->now & RTU_WHEEL_MASK];
+    w->slot[0][w->now & RTU_WHEEL_MASK] = NULL;
+    if (due != NULL)
+        due->pprev = &due;
+
+    while (due != NULL)
+    {
+        RTU_Timer_t *t = due;
+        rtu_timer_stop(w, t);
+        t->fire(t);
+    }
+}
+
+void RTUMaster_WheelInit(RTU_TimerWheel_t *wheel, uint32_t now_us)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->lastUs = now_us;
+}
+
+void RTUMaster_Tick(RTU_TimerWheel_t *wheel, uint32_t now_us)
+{
+    uint32_t ticks = (now_us - wheel->lastUs) / RTU_MASTER_TICK_US;
+    wheel->lastUs += ticks * RTU_MASTER_TICK_US;
+
+    while (ticks != 0)
+    {
+        if (wheel->armed == 0)
+        {
+            wheel->now += ticks; // nothing to expire: skip idle time at once
+            break;
+        }
+        rtu_wheel_step(wheel);
+        ticks--;
+    }
+}
+
+uint32_t RTUMaster_NextTimeout(const RTU_TimerWheel_t *wheel)
+{
+    if (wheel->armed == 0)
+        return UINT32_MAX;
+
+    /* scan level 0 up to the next cascade, which may bring an earlier timer down */
+    uint32_t limit = RTU_WHEEL_SLOTS - (wheel->now & RTU_WHEEL_MASK);
+    uint32_t ticks;
+    for (ticks = 1; ticks < limit; ticks++)
+    {
+        if (wheel->slot[0][(wheel->now + ticks) & RTU_WHEEL_MASK] != NULL)
+            break;
+    }
+
+    return ticks * RTU_MASTER_TICK_US;
+}
+
+/* ============================================================
+ * Master line
+ * ============================================================
+ */
+
+/* Microseconds rounded up to wheel ticks */
+static uint32_t rtu_us_to_ticks(uint32_t us)
+{
+    return (us + RTU_MASTER_TICK_US - 1U) / RTU_MASTER_TICK_US;
+}
+
+/* Airtime of len characters (11 bits each) */
+static uint32_t rtu_airtime_us(const RTU_Master_t *line, size_t len)
+{
+    return (uint32_t)(((uint64_t)len * 11U * 1000000U + line->baud - 1U) / line->baud);
+}
+
+/* Length of the data part of a request / response for the bit and register codes */
+static uint16_t rtu_bit_bytes(uint16_t num)
+{
+    return (uint16_t)((num + 7U) / 8U);
+}
+
+/* Validate req; returns the full response length, 1 for a broadcast, 0 if invalid */
+static uint16_t rtu_master_check(const RTU_MasterReq_t *req)
+{
+    uint16_t len = 8; // request frame
+    uint16_t expect = 8;
+
+    switch (req->func)
+    {
+    case RTU_FUNC_READ_COILS:
+    case RTU_FUNC_READ_DISCRETE_INPUTS:
+        if (req->num < 1 || req->num > 2000)
+            return 0;
+        expect = 5U + rtu_bit_bytes(req->num);
+        break;
+
+    case RTU_FUNC_READ_HOLD_REGS:
+    case RTU_FUNC_READ_INPUT_REG:
+        if (req->num < 1 || req->num > 125)
+            return 0;
+        expect = 5U + req->num * 2U;
+        break;
+
+    case RTU_FUNC_WRITE_SINGLE_COILS:
+    case RTU_FUNC_WRITE_SINGLE_REG:
+        break;
+
+    case RTU_FUNC_MULTIPLE_WRITE_COILS:
+        if (req->num < 1 || req->num > 1968)
+            return 0;
+        len = 9U + rtu_bit_bytes(req->num);
+        break;
+
+    case RTU_FUNC_MULTIPLE_WRITE_REG:
+        if (req->num < 1 || req->num > 123)
+            return 0;
+        len = 9U + req->num * 2U;
+        break;
+
+    default:
+        return 0;
+    }
+
+    if (len > RTU_MASTER_BUF_SIZE || expect > RTU_MASTER_BUF_SIZE)
+        return 0;
+
+    if (req->id == RTU_BROADCAST_ID)
+        return (req->func >= RTU_FUNC_WRITE_SINGLE_COILS) ? 1U : 0U; // writes only
+
+    return expect;
+}
+
+/* Build the request frame of a checked req into line->tx */
+static void rtu_master_build(RTU_Master_t *line, const RTU_MasterReq_t *req)
+{
+    uint8_t *f = line->tx;
+    uint16_t len = 6;
+
+    f[0] = req->id;
+    f[1] = req->func;
+    f[2] = (uint8_t)(req->addr >> 8);
+    f[3] = (uint8_t)(req->addr & 0xFF);
+    f[4] = (uint8_t)(req->num >> 8);
+    f[5] = (uint8_t)(req->num & 0xFF);
+
+    switch (req->func)
+    {
+    case RTU_FUNC_WRITE_SINGLE_COILS:
+        f[4] = (*(const uint8_t *)req->data != 0) ? 0xFF : 0x00;
+        f[5] = 0x00;
+        break;
+
+    case RTU_FUNC_WRITE_SINGLE_REG:
+        f[4] = (uint8_t)(*(const uint16_t *)req->data >> 8);
+        f[5] = (uint8_t)(*(const uint16_t *)req->data & 0xFF);
+        break;
+
+    case RTU_FUNC_MULTIPLE_WRITE_COILS:
+        f[6] = (uint8_t)rtu_bit_bytes(req->num);
+        memcpy(&f[7], req->data, f[6]);
+        len = 7U + f[6];
+        break;
+
+    case RTU_FUNC_MULTIPLE_WRITE_REG:
+        /* 功能码 + 起始地址 + 数量 + 字节数 + 数据 (大端) */
+        f[6] = (uint8_t)(req->num * 2U);
+#if RTU_SIMD_ENABLE
+        RTUKernel_BswapStore16(&f[7], (const uint16_t *)req->data, req->num);
+#else
+        for (uint16_t i = 0; i < req->num; i++)
+        {
+            uint16_t v = ((const uint16_t *)req->data)[i];
+            f[7 + i * 2] = (uint8_t)(v >> 8);
+            f[8 + i * 2] = (uint8_t)(v & 0xFF);
+        }
+#endif
+        len = 7U + f[6];
+        break;
+
+    default:
+        break;
+    }
+
+    uint16_t crc = CRC16(f, len);
+    f[len] = (uint8_t)(crc & 0xFF);
+    f[len + 1] = (uint8_t)(crc >> 8);
+    line->txLen = len + 2U;
+}
+
+#if RTU_MASTER_ADAPTIVE
+/* ============================================================
+ * Adaptive timing
+ * ============================================================
+ */
+
+#define RTU_TURN_MAX_US (0x0FFFFFFFUL) // keeps the variance within 64 bits
+
+static uint32_t rtu_isqrt(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (v >= root + bit)
+        {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static RTU_SlaveTiming_t *rtu_timing_find(const RTU_Master_t *line, uint8_t id)
+{
+    for (size_t i = 0; i < RTU_MASTER_ADAPT_SLAVES; i++)
+    {
+        if (line->slaves[i].id == id)
+            return (RTU_SlaveTiming_t *)&line->slaves[i];
+    }
+    return NULL;
+}
+
+/* Entry of a slave, taking over the least recently polled one if it is new */
+static RTU_SlaveTiming_t *rtu_timing_get(RTU_Master_t *line, uint8_t id)
+{
+    RTU_SlaveTiming_t *st = rtu_timing_find(line, id);
+    if (st == NULL)
+    {
+        st = &line->slaves[0];
+        for (size_t i = 1; i < RTU_MASTER_ADAPT_SLAVES && st->id != 0; i++)
+        {
+            if (line->slaves[i].id == 0 || line->count.sent - line->slaves[i].lastUse > line->count.sent - st->lastUse)
+                st = &line->slaves[i];
+        }
+        memset(st, 0, sizeof(*st));
+        st->id = id;
+        st->minUs = UINT32_MAX;
+    }
+
+    st->lastUse = line->count.sent;
+    return st;
+}
+
+/* mean + K * sigma once enough responses were measured, else the line timeout */
+static uint32_t rtu_timing_timeout_us(const RTU_Master_t *line, const RTU_SlaveTiming_t *st)
+{
+    uint64_t ceiling = (uint64_t)line->timeoutTicks * RTU_MASTER_TICK_US;
+    if (st->samples < RTU_MASTER_ADAPT_SAMPLES)
+        return (uint32_t)ceiling;
+
+    uint64_t us = st->mean8 / 8U + (uint64_t)RTU_MASTER_ADAPT_K * rtu_isqrt(st->var);
+    if (us < RTU_MASTER_ADAPT_FLOOR_US)
+        us = RTU_MASTER_ADAPT_FLOOR_US;
+    if (us > ceiling)
+        us = ceiling;
+    return (uint32_t)us;
+}
+
+/* Smoothed mean and variance (gain 1/8), started from R and (R/2)^2 like TCP's RTT estimator */
+static void rtu_timing_sample(RTU_SlaveTiming_t *st, uint32_t us)
+{
+    if (us > RTU_TURN_MAX_US)
+        us = RTU_TURN_MAX_US;
+
+    if (st->samples == 0)
+    {
+        st->mean8 = (uint64_t)us * 8U;
+        st->var = (uint64_t)(us / 2U) * (us / 2U);
+    }
+    else
+    {
+        int64_t d = (int64_t)us - (int64_t)(st->mean8 / 8U);
+        st->mean8 = (uint64_t)((int64_t)st->mean8 + d);
+        st->var = (uint64_t)((int64_t)st->var + (d * d - (int64_t)st->var) / 8);
+    }
+
+    st->samples++;
+    if (us < st->minUs)
+        st->minUs = us;
+    if (us > st->maxUs)
+        st->maxUs = us;
+}
+
+/* Time from the end of the request to the first response byte; rxAir = airtime already received */
+static uint32_t rtu_turnaround_us(const RTU_Master_t *line, uint32_t rxAir)
+{
+    int64_t us = (int64_t)(int32_t)(line->wheel->now - line->sentTick) * RTU_MASTER_TICK_US - rxAir;
+    return (us > 0) ? (uint32_t)us : 0U;
+}
+#endif
+
+/* Finish the active request, start the inter-frame gap, then run its callback */
+static void rtu_master_finish(RTU_Master_t *line, RTU_MasterResult_t result, uint8_t exception)
+{
+    RTU_MasterReq_t *req = line->active;
+    line->active = NULL;
+    line->state = RTU_MLINE_GAP;
+    rtu_timer_start(line->wheel, &line->timer, line->gapTicks);
+
+#if RTU_MASTER_ADAPTIVE
+    if (line->timing != NULL)
+    {
+        if (result == RTU_MRES_OK || result == RTU_MRES_EXCEPTION)
+        {
+            rtu_timing_sample(line->timing, line->turnUs);
+        }
+        else if (result == RTU_MRES_TIMEOUT)
+        {
+            line->timing->timeouts++;
+            line->timing->samples = 0; // back to the line timeout until relearned
+
+            /* a learned timeout ran out: hold the line for another one, so a late
+               answer is drained instead of taken for the next request's */
+            if (line->waitTicks > line->gapTicks)
+                rtu_timer_start(line->wheel, &line->timer, line->waitTicks);
+        }
+        line->timing = NULL;
+    }
+#endif
+
+    switch (result)
+    {
+    case RTU_MRES_OK:
+        RTU_COUNT_ADD(line->count.ok, 1U);
+        break;
+    case RTU_MRES_EXCEPTION:
+        RTU_COUNT_ADD(line->count.exceptions, 1U);
+        break;
+    case RTU_MRES_TIMEOUT:
+        RTU_COUNT_ADD(line->count.timeouts, 1U);
+        break;
+    case RTU_MRES_CRC:
+        RTU_COUNT_ADD(line->count.crcErrors, 1U);
+        break;
+    case RTU_MRES_BAD_RESPONSE:
+        RTU_COUNT_ADD(line->count.badResponses, 1U);
+        break;
+    default:
+        break;
+    }
+
+    req->result = result;
+    req->exception = exception;
+    if (req->done != NULL)
+        req->done(req);
+}
+
+/* Send the next queued request (line idle) */
+static void rtu_master_kick(RTU_Master_t *line)
+{
+    while (line->state == RTU_MLINE_IDLE && line->head != NULL)
+    {
+        RTU_MasterReq_t *req = line->head;
+        line->head = req->next;
+        if (line->head == NULL)
+            line->tail = NULL;
+        line->queued--;
+
+        rtu_master_build(line, req);
+        line->active = req;
+        line->expect = (req->id == RTU_BROADCAST_ID) ? 0U : rtu_master_check(req);
+        line->rxLen = 0;
+        RTU_COUNT_ADD(line->count.sent, 1U);
+
+        if (line->transmit(line->user, line->tx, line->txLen) < 0)
+        {
+            rtu_master_finish(line, RTU_MRES_TX_ERR, 0); // leaves the line in its gap
+            return;
+        }
+
+        uint32_t air = rtu_us_to_ticks(rtu_airtime_us(line, line->txLen));
+        uint32_t wait = line->timeoutTicks;
+#if RTU_MASTER_ADAPTIVE
+        line->sentTick = line->wheel->now + air;
+        if (line->expect != 0)
+        {
+            /* drivers may hand over the response only once it is complete: allow its airtime */
+            line->timing = rtu_timing_get(line, req->id);
+            wait = rtu_us_to_ticks(rtu_timing_timeout_us(line, line->timing) + rtu_airtime_us(line, line->expect));
+            line->waitTicks = (line->timing->samples >= RTU_MASTER_ADAPT_SAMPLES) ? wait : 0U;
+        }
+#endif
+        if (line->expect == 0)
+        {
+            /* broadcast: nobody answers, give the slaves the turnaround delay */
+            line->state = RTU_MLINE_WAIT;
+            rtu_timer_start(line->wheel, &line->timer, air + rtu_us_to_ticks(RTU_MASTER_BCAST_DELAY_MS * 1000U));
+            return;
+        }
+
+        line->state = RTU_MLINE_WAIT;
+        rtu_timer_start(line->wheel, &line->timer, air + wait);
+    }
+}
+
+/* Check a complete response against the active request and store its data */
+static void rtu_master_response(RTU_Master_t *line)
+{
+    const RTU_MasterReq_t *req = line->active;
+    const uint8_t *f = line->rx;
+    uint16_t len = line->rxLen;
+
+    if (len < 5)
+    {
+        rtu_master_finish(line, RTU_MRES_TIMEOUT, 0); // fragment, no usable response
+        return;
+    }
+
+    uint16_t crc = (uint16_t)f[len - 2] | ((uint16_t)f[len - 1] << 8);
+    if (crc != CRC16(f, len - 2U))
+    {
+        rtu_master_finish(line, RTU_MRES_CRC, 0);
+        return;
+    }
+
+    if (f[0] != req->id || (f[1] & 0x7F) != req->func)
+    {
+        rtu_master_finish(line, RTU_MRES_BAD_RESPONSE, 0);
+        return;
+    }
+
+    if (f[1] & 0x80)
+    {
+        rtu_master_finish(line, (len == 5) ? RTU_MRES_EXCEPTION : RTU_MRES_BAD_RESPONSE, f[2]);
+        return;
+    }
+
+    if (len != line->expect)
+    {
+        rtu_master_finish(line, RTU_MRES_BAD_RESPONSE, 0);
+        return;
+    }
+
+    switch (req->func)
+    {
+    case RTU_FUNC_READ_COILS:
+    case RTU_FUNC_READ_DISCRETE_INPUTS:
+        /* 从机地址 + 功能码 + 字节数 + 数据 + CRC */
+        if (f[2] != rtu_bit_bytes(req->num))
+            break;
+        memcpy(req->data, &f[3], f[2]);
+        rtu_master_finish(line, RTU_MRES_OK, 0);
+        return;
+
+    case RTU_FUNC_READ_HOLD_REGS:
+    case RTU_FUNC_READ_INPUT_REG:
+        if (f[2] != req->num * 2U)
+            break;
+#if RTU_SIMD_ENABLE
+        RTUKernel_BswapLoad16((uint16_t *)req->data, &f[3], req->num);
+#else
+        for (uint16_t i = 0; i < req->num; i++)
+            ((uint16_t *)req->data)[i] = (uint16_t)((f[3 + i * 2] << 8) | f[4 + i * 2]);
+#endif
+        rtu_master_finish(line, RTU_MRES_OK, 0);
+        return;
+
+    default:
+        /* writes echo address and value / quantity */
+        if (memcmp(&f[2], &line->tx[2], 4) != 0)
+            break;
+        rtu_master_finish(line, RTU_MRES_OK, 0);
+        return;
+    }
+
+    rtu_master_finish(line, RTU_MRES_BAD_RESPONSE, 0);
+}
+
+/* Line timer: gap over, response timeout, broadcast delay or t3.5 silence after a response */
+static void rtu_master_timer(RTU_Timer_t *timer)
+{
+    RTU_Master_t *line = RTU_MASTER_OF(timer);
+
+    switch (line->state)
+    {
+    case RTU_MLINE_GAP:
+        line->state = RTU_MLINE_IDLE;
+        rtu_master_kick(line);
+        break;
+
+    case RTU_MLINE_WAIT:
+        rtu_master_finish(line, (line->expect == 0) ? RTU_MRES_OK : RTU_MRES_TIMEOUT, 0);
+        break;
+
+    case RTU_MLINE_RX:
+        rtu_master_response(line);
+        break;
+
+    default:
+        break;
+    }
+}
+
+RTU_Sta_t RTUMaster_Init(RTU_Master_t *line, RTU_TimerWheel_t *wheel, uint32_t baud,
+                         RTUMaster_Transmit_t transmit, void *user)
+{
+    if (line == NULL || wheel == NULL || transmit == NULL || baud == 0)
+        return RTU_ERR;
+
+    memset(line, 0, sizeof(*line));
+    line->wheel = wheel;
+    line->transmit = transmit;
+    line->user = user;
+    line->baud = baud;
+    line->timer.fire = rtu_master_timer;
+    line->state = RTU_MLINE_IDLE;
+
+    /* t3.5: 3.5 characters; the spec's fixed 1750 us above 19200 baud unless opted out */
+    uint32_t gap = (uint32_t)((38500000ULL + baud - 1U) / baud);
+#if !RTU_MASTER_EXACT_GAP
+    if (baud > 19200U)
+        gap = 1750U;
+#endif
+    line->gapTicks = rtu_us_to_ticks(gap);
+    line->timeoutTicks = rtu_us_to_ticks(RTU_MASTER_TIMEOUT_MS * 1000U);
+
+    return RTU_OK;
+}
+
+void RTUMaster_SetTimeout(RTU_Master_t *line, uint32_t timeout_us)
+{
+    line->timeoutTicks = rtu_us_to_ticks(timeout_us);
+}
+
+RTU_Sta_t RTUMaster_Submit(RTU_Master_t *line, RTU_MasterReq_t *req)
+{
+    if (line == NULL || req == NULL || req->data == NULL)
+        return RTU_ERR;
+
+    if (rtu_master_check(req) == 0)
+        return RTU_ERR;
+
+    req->next = NULL;
+    if (line->tail != NULL)
+        line->tail->next = req;
+    else
+        line->head = req;
+    line->tail = req;
+    line->queued++;
+
+    rtu_master_kick(line);
+    return RTU_OK;
+}
+
+RTU_Sta_t RTUMaster_Cancel(RTU_Master_t *line, RTU_MasterReq_t *req)
+{
+    RTU_MasterReq_t *prev = NULL;
+    for (RTU_MasterReq_t *r = line->head; r != NULL; prev = r, r = r->next)
+    {
+        if (r != req)
+            continue;
+
+        if (prev != NULL)
+            prev->next = r->next;
+        else
+            line->head = r->next;
+        if (line->tail == r)
+            line->tail = prev;
+        line->queued--;
+
+        req->result = RTU_MRES_CANCELLED;
+        req->exception = 0;
+        if (req->done != NULL)
+            req->done(req);
+        return RTU_OK;
+    }
+
+    return RTU_NOACTIVE;
+}
+
+void RTUMaster_RxBytes(RTU_Master_t *line, const uint8_t *data, size_t len)
+{
+    if (line->state != RTU_MLINE_WAIT && line->state != RTU_MLINE_RX)
+    {
+        RTU_COUNT_ADD(line->count.stray, (uint32_t)len);
+
+        /* somebody is still talking: keep the gap running until t3.5 after it */
+        if (line->state == RTU_MLINE_GAP && line->timer.expire - line->wheel->now < line->gapTicks)
+            rtu_timer_start(line->wheel, &line->timer, line->gapTicks);
+        return;
+    }
+    if (line->expect == 0)
+    {
+        RTU_COUNT_ADD(line->count.stray, (uint32_t)len); // nobody answers a broadcast
+        return;
+    }
+
+#if RTU_MASTER_ADAPTIVE
+    if (line->state == RTU_MLINE_WAIT)
+        line->turnUs = rtu_turnaround_us(line, rtu_airtime_us(line, len));
+#endif
+
+    size_t room = RTU_MASTER_BUF_SIZE - line->rxLen;
+    if (len > room)
+        len = room; // overlong frame: fails the length check
+    memcpy(&line->rx[line->rxLen], data, len);
+    line->rxLen += (uint16_t)len;
+    line->state = RTU_MLINE_RX;
+
+    /* complete as soon as the expected (or exception) length is in */
+    if (line->rxLen >= line->expect || (line->rxLen >= 5 && (line->rx[1] & 0x80)))
+    {
+        rtu_timer_stop(line->wheel, &line->timer);
+        rtu_master_response(line);
+        return;
+    }
+
+    rtu_timer_start(line->wheel, &line->timer, line->gapTicks); // frame ends on t3.5 silence
+}
+
+void RTUMaster_RxFrame(RTU_Master_t *line, const uint8_t *data, size_t len)
+{
+    if (line->state != RTU_MLINE_WAIT && line->state != RTU_MLINE_RX)
+    {
+        RTU_COUNT_ADD(line->count.stray, (uint32_t)len);
+        if (line->state == RTU_MLINE_GAP && line->timer.expire - line->wheel->now < line->gapTicks)
+            rtu_timer_start(line->wheel, &line->timer, line->gapTicks);
+        return;
+    }
+    if (line->expect == 0)
+    {
+        RTU_COUNT_ADD(line->count.stray, (uint32_t)len);
+        return;
+    }
+
+    if (len > RTU_MASTER_BUF_SIZE)
+        len = RTU_MASTER_BUF_SIZE;
+    memcpy(line->rx, data, len);
+    line->rxLen = (uint16_t)len;
+#if RTU_MASTER_ADAPTIVE
+    line->turnUs = rtu_turnaround_us(line, rtu_airtime_us(line, len));
+#endif
+
+    rtu_timer_stop(line->wheel, &line->timer);
+    rtu_master_response(line);
+}
+
+size_t RTUMaster_Outstanding(const RTU_Master_t *line)
+{
+    return line->queued + (line->active != NULL);
+}
+
+RTU_Sta_t RTUMaster_SlaveStats(const RTU_Master_t *line, uint8_t id, RTU_MasterSlaveStats_t *stats)
+{
+#if RTU_MASTER_ADAPTIVE
+    if (line == NULL || stats == NULL || id == RTU_BROADCAST_ID)
+        return RTU_ERR;
+
+    const RTU_SlaveTiming_t *st = rtu_timing_find(line, id);
+    if (st == NULL)
+        return RTU_NOACTIVE;
+
+    stats->samples = st->samples;
+    stats->meanUs = (uint32_t)(st->mean8 / 8U);
+    stats->sigmaUs = rtu_isqrt(st->var);
+    stats->minUs = (st->minUs != UINT32_MAX) ? st->minUs : 0U;
+    stats->maxUs = st->maxUs;
+    stats->timeouts = st->timeouts;
+    stats->timeoutUs = rtu_timing_timeout_us(line, st);
+    return RTU_OK;
+#else
+    (void)line;
+    (void)id;
+    (void)stats;
+    return RTU_ERR;
+#endif
+}
+
+void RTUMaster_ResetStats(RTU_Master_t *line)
+{
+#if RTU_MASTER_ADAPTIVE
+    for (size_t i = 0; i < RTU_MASTER_ADAPT_SLAVES; i++)
+    {
+        RTU_SlaveTiming_t *st = &line->slaves[i];
+        uint8_t id = (st == line->timing) ? st->id : 0U; // the active request still reports here
+
+        memset(st, 0, sizeof(*st));
+        st->id = id;
+        st->minUs = UINT32_MAX;
+    }
+#else
+    (void)line;
+#endif
+}
+
+/* ============================================================
+ * Multi-line runtime
+ * ============================================================
+ */
+
+#if RTU_MASTER_RUNTIME
+
+struct RTU_RtShard;
+
+/* Tags are written by one runtime thread each; the alignment keeps them on separate cache lines */
+typedef struct __attribute__((aligned(64)))
+{
+    /* read side */
+    volatile uint32_t seq; // odd while the runtime thread writes
+    RTU_TagInfo_t info;
+    uint16_t values[RTU_MASTER_TAG_REGS];
+
+    /* runtime thread only */
+    RTU_TagConf_t conf;
+    RTU_MasterReq_t req;
+    RTU_Timer_t timer;   // period timer
+    uint32_t startTick;  // wheel tick the last poll was submitted
+    uint32_t periodTicks;
+    uint16_t buf[RTU_MASTER_TAG_REGS]; // poll target, published on success
+} RTU_RtTag_t;
+
+typedef struct
+{
+    RTU_Master_t master;
+    int fd;
+    struct RTU_RtShard *shard;
+} RTU_RtLine_t;
+
+typedef struct RTU_RtShard
+{
+    RTU_Runtime_t *rt;
+    RTU_TimerWheel_t wheel; // shared by the lines of the shard
+    pthread_t thread;
+    bool started;
+    int cpu;   // -1 = no affinity
+    int epfd;
+    int tfd;   // timerfd, armed to RTUMaster_NextTimeout()
+    int efd;   // eventfd, wakes the thread for stop
+} RTU_RtShard_t;
+
+struct RTU_Runtime
+{
+    RTU_RtLine_t *lines;
+    size_t lineCount;
+    RTU_RtShard_t *shards;
+    size_t shardCount;
+    RTU_RtTag_t *tags;
+    size_t tagCount;
+    volatile int stop;
+    bool started;
+};
+
+#define RTU_RT_TAG_OF(t) ((RTU_RtTag_t *)((uint8_t *)(t) - offsetof(RTU_RtTag_t, timer)))
+
+static uint64_t rtu_rt_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+
+static size_t rtu_rt_bytes(const RTU_TagConf_t *conf)
+{
+    return (conf->func <= RTU_FUNC_READ_DISCRETE_INPUTS) ? (conf->num + 7U) / 8U : conf->num * 2U;
+}
+
+/* Read a region the runtime thread may be writing; validated by the seqlock */
+static void rtu_rt_copy(void *dst, const volatile void *src, size_t len)
+{
+    const volatile uint8_t *s = (const volatile uint8_t *)src;
+    uint8_t *d = (uint8_t *)dst;
+    for (size_t i = 0; i < len; i++)
+        d[i] = s[i];
+}
+
+static speed_t rtu_rt_speed(uint32_t baud)
+{
+    static const struct
+    {
+        uint32_t baud;
+        speed_t speed;
+    } table[] = {
+        {1200, B1200}, {2400, B2400}, {4800, B4800}, {9600, B9600}, {19200, B19200},
+        {38400, B38400}, {57600, B57600}, {115200, B115200}, {230400, B230400},
+    };
+
+    for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+    {
+        if (table[i].baud == baud)
+            return table[i].speed;
+    }
+    return B0;
+}
+
+/* Open a line raw and non-blocking; -1 on failure */
+static int rtu_rt_open(const RTU_LineConf_t *lc)
+{
+    speed_t speed = rtu_rt_speed(lc->baud);
+    if (lc->path == NULL || speed == B0 || (lc->stopBits != 1 && lc->stopBits != 2) ||
+        (lc->parity != 'N' && lc->parity != 'E' && lc->parity != 'O'))
+        return -1;
+
+    int fd = open(lc->path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    struct termios t;
+    if (tcgetattr(fd, &t) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&t);
+    t.c_cflag |= CLOCAL | CREAD;
+    t.c_cflag &= ~(tcflag_t)(PARENB | PARODD | CSTOPB);
+    if (lc->parity != 'N')
+        t.c_cflag |= (lc->parity == 'O') ? (PARENB | PARODD) : PARENB;
+    if (lc->stopBits == 2)
+        t.c_cflag |= CSTOPB;
+    t.c_cc[VMIN] = 0;
+    t.c_cc[VTIME] = 0;
+    cfsetispeed(&t, speed);
+    cfsetospeed(&t, speed);
+    if (tcsetattr(fd, TCSANOW, &t) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIOFLUSH);
+
+    return fd;
+}
+
+/* Master transmit: the tty buffer takes a whole frame, a short write is a failure */
+static int rtu_rt_transmit(void *user, const uint8_t *data, size_t len)
+{
+    RTU_RtLine_t *line = (RTU_RtLine_t *)user;
+    ssize_t n;
+
+    do
+    {
+        n = write(line->fd, data, len);
+    } while (n < 0 && errno == EINTR);
+
+    return (n == (ssize_t)len) ? 0 : -1;
+}
+
+/* Publish the poll result under the tag's seqlock */
+static void rtu_rt_publish(RTU_RtTag_t *tag)
+{
+    tag->seq = tag->seq + 1u; // odd: readers retry
+    RTU_FENCE_RELEASE();
+
+    tag->info.updates++;
+    tag->info.result = tag->req.result;
+    tag->info.exception = tag->req.exception;
+    if (tag->req.result == RTU_MRES_OK)
+    {
+        memcpy(tag->values, tag->buf, rtu_rt_bytes(&tag->conf));
+        tag->info.okTimeUs = rtu_rt_now_us();
+    }
+
+    RTU_STORE_RELEASE(&tag->seq, tag->seq + 1u); // even: snapshot complete
+}
+
+static void rtu_rt_poll(RTU_RtTag_t *tag)
+{
+    RTU_Runtime_t *rt = tag->req.user;
+    RTU_RtLine_t *line = &rt->lines[tag->conf.line];
+
+    tag->startTick = line->shard->wheel.now;
+    RTUMaster_Submit(&line->master, &tag->req);
+}
+
+static void rtu_rt_tag_timer(RTU_Timer_t *timer)
+{
+    rtu_rt_poll(RTU_RT_TAG_OF(timer));
+}
+
+/* Poll done: publish, then poll again when the period since the last start is over */
+static void rtu_rt_done(RTU_MasterReq_t *req)
+{
+    RTU_RtTag_t *tag = (RTU_RtTag_t *)((uint8_t *)req - offsetof(RTU_RtTag_t, req));
+    RTU_Runtime_t *rt = req->user;
+    RTU_TimerWheel_t *wheel = &rt->lines[tag->conf.line].shard->wheel;
+
+    rtu_rt_publish(tag);
+    if (rt->stop)
+        return;
+
+    uint32_t elapsed = wheel->now - tag->startTick;
+    if (elapsed >= tag->periodTicks)
+        rtu_rt_poll(tag);
+    else
+        rtu_timer_start(wheel, &tag->timer, tag->periodTicks - elapsed);
+}
+
+static void rtu_rt_drain(int fd)
+{
+    uint64_t v;
+    while (read(fd, &v, sizeof(v)) > 0)
+    {
+    }
+}
+
+static void *rtu_rt_shard_main(void *arg)
+{
+    RTU_RtShard_t *shard = (RTU_RtShard_t *)arg;
+    RTU_Runtime_t *rt = shard->rt;
+    struct epoll_event ev[32];
+    uint8_t buf[RTU_MASTER_BUF_SIZE];
+
+    if (shard->cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(shard->cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set); // best effort
+    }
+
+    RTUMaster_Tick(&shard->wheel, (uint32_t)rtu_rt_now_us());
+    for (size_t i = 0; i < rt->tagCount; i++)
+    {
+        if (rt->lines[rt->tags[i].conf.line].shard == shard)
+            rtu_rt_poll(&rt->tags[i]);
+    }
+
+    while (!RTU_LOAD_ACQUIRE(&rt->stop))
+    {
+        uint32_t next = RTUMaster_NextTimeout(&shard->wheel);
+        struct itimerspec its = {0};
+        if (next != UINT32_MAX)
+        {
+            its.it_value.tv_sec = next / 1000000U;
+            its.it_value.tv_nsec = (long)(next % 1000000U) * 1000L;
+        }
+        timerfd_settime(shard->tfd, 0, &its, NULL);
+
+        int n = epoll_wait(shard->epfd, ev, (int)(sizeof(ev) / sizeof(ev[0])), -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        /* tick first: turnaround is measured on the wheel clock */
+        RTUMaster_Tick(&shard->wheel, (uint32_t)rtu_rt_now_us());
+
+        for (int i = 0; i < n; i++)
+        {
+            RTU_RtLine_t *line = (RTU_RtLine_t *)ev[i].data.ptr;
+            if (line == NULL)
+            {
+                rtu_rt_drain(shard->tfd);
+                rtu_rt_drain(shard->efd);
+                continue;
+            }
+
+            ssize_t len;
+            while ((len = read(line->fd, buf, sizeof(buf))) > 0)
+                RTUMaster_RxBytes(&line->master, buf, (size_t)len);
+        }
+    }
+
+    return NULL;
+}
+
+static void rtu_rt_free(RTU_Runtime_t *rt)
+{
+    for (size_t i = 0; i < rt->shardCount; i++)
+    {
+        RTU_RtShard_t *shard = &rt->shards[i];
+        if (shard->epfd >= 0)
+            close(shard->epfd);
+        if (shard->tfd >= 0)
+            close(shard->tfd);
+        if (shard->efd >= 0)
+            close(shard->efd);
+    }
+    for (size_t i = 0; i < rt->lineCount; i++)
+    {
+        if (rt->lines[i].fd >= 0)
+            close(rt->lines[i].fd);
+    }
+
+    free(rt->tags);
+    free(rt->shards);
+    free(rt->lines);
+    free(rt);
+}
+
+static bool rtu_rt_tag_valid(const RTU_TagConf_t *tc, size_t lineCount)
+{
+    if (tc->line >= lineCount || tc->id == RTU_BROADCAST_ID || tc->id > 247 || tc->num == 0)
+        return false;
+
+    switch (tc->func)
+    {
+    case RTU_FUNC_READ_COILS:
+    case RTU_FUNC_READ_DISCRETE_INPUTS:
+        return tc->num <= 2000 && tc->num <= RTU_MASTER_TAG_REGS * 16U;
+    case RTU_FUNC_READ_HOLD_REGS:
+    case RTU_FUNC_READ_INPUT_REG:
+        return tc->num <= RTU_MASTER_TAG_REGS;
+    default:
+        return false;
+    }
+}
+#endif
+
+RTU_Runtime_t *RTUMaster_RuntimeCreate(const RTU_RuntimeConf_t *conf, const RTU_LineConf_t *lines, size_t lineCount,
+                                       const RTU_TagConf_t *tags, size_t tagCount)
+{
+#if RTU_MASTER_RUNTIME
+    if (conf == NULL || lines == NULL || lineCount == 0 || (tags == NULL && tagCount != 0) ||
+        (conf->cpus == NULL) != (conf->cpuCount == 0))
+        return NULL;
+    for (size_t i = 0; i < tagCount; i++)
+    {
+        if (!rtu_rt_tag_valid(&tags[i], lineCount))
+            return NULL;
+    }
+
+    size_t shards = lineCount;
+    if (conf->model == RTU_RT_SHARDED)
+    {
+        shards = conf->shards;
+        if (shards == 0)
+        {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            shards = (cpus > 0) ? (size_t)cpus : 1U;
+        }
+        if (shards > lineCount)
+            shards = lineCount;
+    }
+
+    RTU_Runtime_t *rt = calloc(1, sizeof(*rt));
+    if (rt == NULL)
+        return NULL;
+    rt->lines = calloc(lineCount, sizeof(*rt->lines));
+    rt->shards = calloc(shards, sizeof(*rt->shards));
+    if (tagCount != 0 && posix_memalign((void **)&rt->tags, 64, tagCount * sizeof(*rt->tags)) != 0)
+        rt->tags = NULL;
+    if (rt->lines == NULL || rt->shards == NULL || (tagCount != 0 && rt->tags == NULL))
+    {
+        rtu_rt_free(rt);
+        return NULL;
+    }
+    if (tagCount != 0)
+        memset(rt->tags, 0, tagCount * sizeof(*rt->tags));
+
+    rt->lineCount = lineCount;
+    rt->shardCount = shards;
+    rt->tagCount = tagCount;
+    for (size_t i = 0; i < lineCount; i++)
+        rt->lines[i].fd = -1;
+    for (size_t i = 0; i < shards; i++)
+    {
+        rt->shards[i].epfd = -1;
+        rt->shards[i].tfd = -1;
+        rt->shards[i].efd = -1;
+    }
+
+    uint32_t now = (uint32_t)rtu_rt_now_us();
+    for (size_t i = 0; i < shards; i++)
+    {
+        RTU_RtShard_t *shard = &rt->shards[i];
+        shard->rt = rt;
+        shard->cpu = (conf->cpus != NULL) ? conf->cpus[i % conf->cpuCount] : -1;
+        shard->epfd = epoll_create1(EPOLL_CLOEXEC);
+        shard->tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        shard->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        RTUMaster_WheelInit(&shard->wheel, now);
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+        if (shard->epfd < 0 || shard->tfd < 0 || shard->efd < 0 ||
+            epoll_ctl(shard->epfd, EPOLL_CTL_ADD, shard->tfd, &ev) != 0 ||
+            epoll_ctl(shard->epfd, EPOLL_CTL_ADD, shard->efd, &ev) != 0)
+        {
+            rtu_rt_free(rt);
+            return NULL;
+        }
+    }
+
+    for (size_t i = 0; i < lineCount; i++)
+    {
+        RTU_RtLine_t *line = &rt->lines[i];
+        line->shard = &rt->shards[i % shards];
+        line->fd = rtu_rt_open(&lines[i]);
+
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = line};
+        if (line->fd < 0 ||
+            RTUMaster_Init(&line->master, &line->shard->wheel, lines[i].baud, rtu_rt_transmit, line) != RTU_OK ||
+            epoll_ctl(line->shard->epfd, EPOLL_CTL_ADD, line->fd, &ev) != 0)
+        {
+            rtu_rt_free(rt);
+            return NULL;
+        }
+        if (lines[i].timeoutUs != 0)
+            RTUMaster_SetTimeout(&line->master, lines[i].timeoutUs);
+    }
+
+    for (size_t i = 0; i < tagCount; i++)
+    {
+        RTU_RtTag_t *tag = &rt->tags[i];
+        tag->conf = tags[i];
+        tag->periodTicks = (tags[i].periodUs + RTU_MASTER_TICK_US - 1U) / RTU_MASTER_TICK_US;
+        tag->timer.fire = rtu_rt_tag_timer;
+        tag->req.id = tags[i].id;
+        tag->req.func = tags[i].func;
+        tag->req.addr = tags[i].addr;
+        tag->req.num = tags[i].num;
+        tag->req.data = tag->buf;
+        tag->req.done = rtu_rt_done;
+        tag->req.user = rt;
+    }
+
+    return rt;
+#else
+    (void)conf;
+    (void)lines;
+    (void)lineCount;
+    (void)tags;
+    (void)tagCount;
+    return NULL;
+#endif
+}
+
+RTU_Sta_t RTUMaster_RuntimeStart(RTU_Runtime_t *rt)
+{
+#if RTU_MASTER_RUNTIME
+    if (rt == NULL || rt->started)
+        return RTU_ERR;
+
+    rt->started = true;
+    for (size_t i = 0; i < rt->shardCount; i++)
+    {
+        RTU_RtShard_t *shard = &rt->shards[i];
+        if (pthread_create(&shard->thread, NULL, rtu_rt_shard_main, shard) != 0)
+        {
+            RTUMaster_RuntimeStop(rt);
+            return RTU_ERR;
+        }
+        shard->started = true;
+    }
+
+    return RTU_OK;
+#else
+    (void)rt;
+    return RTU_ERR;
+#endif
+}
+
+void RTUMaster_RuntimeStop(RTU_Runtime_t *rt)
+{
+#if RTU_MASTER_RUNTIME
+    if (rt == NULL)
+        return;
+
+    RTU_STORE_RELEASE(&rt->stop, 1);
+    for (size_t i = 0; i < rt->shardCount; i++)
+    {
+        uint64_t one = 1;
+        if (write(rt->shards[i].efd, &one, sizeof(one)) < 0)
+        {
+            // counter already non-zero: the thread is awake anyway
+        }
+    }
+    for (size_t i = 0; i < rt->shardCount; i++)
+    {
+        if (rt->shards[i].started)
+            pthread_join(rt->shards[i].thread, NULL);
+        rt->shards[i].started = false;
+    }
+#else
+    (void)rt;
+#endif
+}
+
+void RTUMaster_RuntimeDestroy(RTU_Runtime_t *rt)
+{
+#if RTU_MASTER_RUNTIME
+    if (rt == NULL)
+        return;
+
+    RTUMaster_RuntimeStop(rt);
+    rtu_rt_free(rt);
+#else
+    (void)rt;
+#endif
+}
+
+RTU_Sta_t RTUMaster_TagRead(const RTU_Runtime_t *rt, size_t tag, void *values, RTU_TagInfo_t *info)
+{
+#if RTU_MASTER_RUNTIME
+    if (rt == NULL || tag >= rt->tagCount)
+        return RTU_ERR;
+
+    const RTU_RtTag_t *t = &rt->tags[tag];
+    RTU_TagInfo_t snap;
+
+    for (uint8_t attempt = 0; attempt < RTU_SEQLOCK_RETRIES; attempt++)
+    {
+        uint32_t seq = RTU_LOAD_ACQUIRE(&t->seq);
+        if (seq & 1u)
+            continue;
+
+        rtu_rt_copy(&snap, &t->info, sizeof(snap));
+        if (values != NULL)
+            rtu_rt_copy(values, t->values, rtu_rt_bytes(&t->conf));
+
+        RTU_FENCE_ACQUIRE();
+        if (RTU_LOAD_ACQUIRE(&t->seq) != seq)
+            continue;
+
+        if (info != NULL)
+            *info = snap;
+        return (snap.okTimeUs != 0) ? RTU_OK : RTU_NOACTIVE;
+    }
+
+    return RTU_NOACTIVE;
+#else
+    (void)rt;
+    (void)tag;
+    (void)values;
+    (void)info;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUMaster_RuntimeCounters(const RTU_Runtime_t *rt, size_t line, RTU_MasterCounters_t *count)
+{
+#if RTU_MASTER_RUNTIME
+    if (rt == NULL || line >= rt->lineCount || count == NULL)
+        return RTU_ERR;
+
+    const RTU_MasterCounters_t *c = &rt->lines[line].master.count;
+    count->sent = RTU_COUNT_LOAD(c->sent);
+    count->ok = RTU_COUNT_LOAD(c->ok);
+    count->exceptions = RTU_COUNT_LOAD(c->exceptions);
+    count->timeouts = RTU_COUNT_LOAD(c->timeouts);
+    count->crcErrors = RTU_COUNT_LOAD(c->crcErrors);
+    count->badResponses = RTU_COUNT_LOAD(c->badResponses);
+    count->stray = RTU_COUNT_LOAD(c->stray);
+    return RTU_OK;
+#else
+    (void)rt;
+    (void)line;
+    (void)count;
+    return RTU_ERR;
+#endif
+}
@@ -10,8 +10,23 @@
  * - 定时处理函数解析并响应（调用弱 RTU_Transmit）
  */
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L // clock_gettime(), ftruncate() of the persistent store and shm image
+#endif
+
 #include "RtuSlave.h"
 #include "stdlib.h"
+#include "string.h"
+#if RTU_PERSIST_ENABLE || RTU_SHM_ENABLE
+#include "fcntl.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "time.h"
+#include "unistd.h"
+#endif
+#if RTU_SIMD_ENABLE
+#include "RtuKernels.h"
+#endif
 // #include "MicroKVTable.h"
 
 #define CHECK_CALLBACK_EX(x)               \
@@ -25,6 +40,47 @@
         }                                  \
     } while (0)
 
+/* Acquire/release accessors for state shared with application producers */
+#if defined(__GNUC__)
+#define RTU_LOAD_ACQUIRE(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RTU_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define RTU_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define RTU_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define RTU_TRY_LOCK(p) (!__atomic_test_and_set((p), __ATOMIC_ACQUIRE))
+#define RTU_UNLOCK(p) __atomic_clear((p), __ATOMIC_RELEASE)
+#define RTU_ATOMIC_INC(p) ((void)__atomic_fetch_add((p), 1u, __ATOMIC_RELEASE))
+#else
+#define RTU_LOAD_ACQUIRE(p) (*(p))
+#define RTU_STORE_RELEASE(p, v) (*(p) = (v))
+#define RTU_FENCE_ACQUIRE()
+#define RTU_FENCE_RELEASE()
+#define RTU_ATOMIC_INC(p) ((void)(*(p) = *(p) + 1u))
+#if RTU_HOT_SWAP
+#error "RTU_HOT_SWAP needs GCC-compatible __atomic builtins"
+#endif
+#endif
+
+/* Helpers shared by several function codes */
+#define RTU_NEED_READ_REGS (RTU_FC_READ_HOLD_REGS_ENABLE || RTU_FC_READ_INPUT_REGS_ENABLE || RTU_EXT_FRAME_ENABLE)
+#define RTU_NEED_WRITE_REGS (RTU_FC_WRITE_SINGLE_REG_ENABLE || RTU_FC_WRITE_MULTIPLE_REGS_ENABLE || RTU_EXT_FRAME_ENABLE)
+#define RTU_NEED_FIND_NODE (RTU_NEED_READ_REGS || RTU_NEED_WRITE_REGS || RTU_FC_READ_COILS_ENABLE ||  \
+                            RTU_FC_WRITE_SINGLE_COIL_ENABLE || RTU_FC_WRITE_MULTIPLE_COILS_ENABLE || \
+                            RTU_FC_READ_DISCRETE_INPUTS_ENABLE)
+#define RTU_NEED_REG_LISTS (RTU_COILS_ENABLE || RTU_DISCRETE_INPUTS_ENABLE || RTU_HOLD_REGS_ENABLE || RTU_INPUT_REGS_ENABLE)
+
+#define RTU_FIFO_MAX_READ (31U) // Modbus limit for one 0x18 response
+
+#define RTU_FILE_REF_TYPE (0x06U)     // reference type of every file sub-request
+#define RTU_FILE_MAX_RECORD (0x270FU) // highest record number (9999)
+#define RTU_FILE_MAX_SUBREQ (35U)     // 0xF5 / 7 bytes per read sub-request
+
+#define RTU_PERSIST_MAGIC (0x50555452UL) // "RTUP"
+#define RTU_PERSIST_FORMAT (1U)
+#define RTU_FNV_BASIS (2166136261UL)
+
+#define RTU_SHM_MAGIC (0x53555452UL) // "RTUS"
+#define RTU_SHM_FORMAT (1U)
+
 /* Internal singleton */
 static RTU_SlaveObj_t rtu_obj = {0};
 static RTU_SlaveObj_t *const this = &rtu_obj;
@@ -52,425 +108,2756 @@ static uint16_t CRC16(const uint8_t *buf, size_t len)
     return crc;
 }
 
-/* Free a linked list and set head pointer to NULL */
-static void rtufree_register_list(RTU_Register_t **headp)
+#if RTU_DIRTY_TRACKING
+/* Dirty set belonging to a register list, NULL for read-only classes */
+static RTU_DirtySet_t *rtu_dirty_set(const RTU_RegList_t *list)
 {
-    if (headp == NULL || *headp == NULL)
-        return;
-
-    RTU_Register_t *node = *headp;
-    while (node)
-    {
-        RTU_Register_t *next = node->next;
-        free(node);
-        node = next;
-    }
-    *headp = NULL;
+    if (list == &this->holdingRegs)
+        return &this->dirtyHold;
+    if (list == &this->coils)
+        return &this->dirtyCoils;
+    return NULL;
 }
 
-/* Build a linked list from Map and set *headp to first node.
- * Returns 0 on success, -1 on failure.
- *
- * NOTE: node->value points to the original map[i].data (no deep copy).
- */
-static int rtubuild_register_list(RTU_Register_t **headp, RTU_RegisterMap_t *map, size_t count)
+/* Drop every queued entry of a list (node indices become stale) */
+static void rtu_dirty_reset(const RTU_RegList_t *list)
 {
-    if (headp == NULL)
-        return -1;
+    RTU_DirtySet_t *set = rtu_dirty_set(list);
+    if (set == NULL || set->mark == NULL)
+        return;
 
-    *headp = NULL;
+    memset(set->mark, 0, ((set->capacity + 31U) / 32U) * sizeof(uint32_t));
+    set->count = 0;
+}
 
-    if (map == NULL || count == 0)
-        return 0; // nothing to build
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS
+/* Forget a queued change of one node */
+static void rtu_dirty_drop(const RTU_RegList_t *list, uint16_t idx)
+{
+    RTU_DirtySet_t *set = rtu_dirty_set(list);
+    uint32_t bit = 1UL << (idx & 31U);
+    if (set == NULL || set->mark == NULL || idx >= set->capacity || !(set->mark[idx >> 5] & bit))
+        return;
 
-    RTU_Register_t *prev = NULL;
-    for (size_t i = 0; i < count; ++i)
+    set->mark[idx >> 5] &= ~bit;
+    for (size_t i = 0; i < set->count; i++)
     {
-        RTU_Register_t *node = (RTU_Register_t *)calloc(1, sizeof(RTU_Register_t));
-        if (node == NULL)
+        if (set->queue[i] == idx)
         {
-            /* free already allocated nodes */
-            if (*headp)
-                rtufree_register_list(headp);
-            *headp = NULL;
-            return -1;
+            set->queue[i] = set->queue[--set->count];
+            break;
         }
+    }
+}
+#endif
 
-        node->address = map[i].addr;
-        node->value = map[i].data;
-        node->permiss = (uint8_t)map[i].permiss;
-        node->next = NULL;
-        node->callback = map[i].callback;
-
-        if (prev)
-            prev->next = node;
-        else
-            *headp = node;
+#if RTU_NEED_WRITE_REGS || RTU_FC_WRITE_SINGLE_COIL_ENABLE || RTU_FC_WRITE_MULTIPLE_COILS_ENABLE
+/* Queue a node changed by the master, once until it is fetched */
+static void rtu_mark_dirty(const RTU_RegList_t *list, const RTU_Register_t *node)
+{
+    RTU_DirtySet_t *set = rtu_dirty_set(list);
+    size_t idx = (size_t)(node - list->head);
+    if (set == NULL || idx >= set->capacity)
+        return;
 
-        prev = node;
-    }
+    uint32_t bit = 1UL << (idx & 31U);
+    if (set->mark[idx >> 5] & bit)
+        return;
 
-    return 0;
+    set->mark[idx >> 5] |= bit;
+    set->queue[set->count++] = (uint16_t)idx;
 }
+#endif
 
-/**
- * @brief 发送 Modbus 异常响应
- * @param func 原始请求的功能码
- * @param ex_code 异常码 (0x01 - 0x04)
- */
-static void rtu_send_exception(uint8_t func, RTU_ExceptionCode_t ex_code)
+#define RTU_MARK_DIRTY(list, node) rtu_mark_dirty((list), (node))
+#else
+#define RTU_MARK_DIRTY(list, node) ((void)0)
+#endif
+
+#if RTU_RESP_CACHE_SIZE || RTU_PERSIST_ENABLE
+/* Cached responses and saved checkpoints built from this list go stale */
+static void rtu_version_touch(const RTU_RegList_t *list)
 {
-    uint8_t *resp = this->buf; // 复用内部缓冲区
-    uint16_t crc;
+    /* bumped by the handler and by application threads alike: no bump may be lost */
+    if (list == &this->holdingRegs)
+        RTU_ATOMIC_INC(&this->holdVersion);
+    else if (list == &this->inputRegs)
+        RTU_ATOMIC_INC(&this->inputVersion);
+}
 
-    resp[0] = this->id;
-    resp[1] = func | 0x80;      // 功能码最高位置 1
-    resp[2] = (uint8_t)ex_code; // 填充异常码
+#define RTU_VERSION_TOUCH(list) rtu_version_touch(list)
+#else
+#define RTU_VERSION_TOUCH(list) ((void)0)
+#endif
 
-    // 计算这 3 个字节的 CRC
-    crc = CRC16(resp, 3);
-    resp[3] = (uint8_t)(crc & 0xFF);
-    resp[4] = (uint8_t)(crc >> 8);
+#if RTU_RESP_CACHE_SIZE
+/* Forget every cached response (slave id changed) */
+static void rtu_cache_clear(void)
+{
+    memset(this->respCache, 0, sizeof(this->respCache));
+    this->respCacheNext = 0;
+}
+#endif
 
-    // 异常帧长度固定为 5 字节
-    RTU_Transmit(resp, 5);
+#if RTU_TYPED_REGS
+/* Registers covered by a node: 1, or 2 / 4 for a typed value */
+static uint16_t rtu_node_words(uint8_t type)
+{
+    static const uint8_t words[] = {1, 2, 2, 2, 4, 4, 4};
+    return words[type & 0x0FU];
 }
 
-/* Initialize singleton */
-RTU_Sta_t RTUSlave_Init(void)
+/* Typed values need a 16-bit register class and must not run past 0xFFFF */
+static bool rtu_type_valid(const RTU_RegList_t *list, uint8_t type, uint16_t addr)
 {
-    /* buf is static array; set buf_size accordingly */
-    this->buf_size = (uint16_t)sizeof(this->buf);
+    if (type == 0)
+        return true;
 
-    /* default id 1 */
-    this->id = 1;
+    if ((type & 0x0FU) > RTU_TYPE_F64 || (type >> 4) > RTU_ORDER_DCBA)
+        return false;
+    if (list != &this->holdingRegs && list != &this->inputRegs)
+        return false;
 
-    /* ensure heads are empty (they are zeroed by static init, but be explicit) */
-    this->coils = NULL;
-    this->holdingRegs = NULL;
-    this->inputRegs = NULL;
+    return (uint32_t)addr + rtu_node_words(type) - 1U <= 0xFFFFU;
+}
 
-    this->g_frame.ready = false;
-    this->g_frame.len = 0;
+#define RTU_NODE_WORDS(node) ((uint32_t)rtu_node_words((node)->type))
+#else
+#define RTU_NODE_WORDS(node) 1U
+#endif
+
+#if RTU_DYNAMIC_REGS
+/* AVL index of a dynamic map, stored right after its node slots */
+#define RTU_DYN_INDEX(list) ((RTU_RegIndex_t *)((list)->head + (list)->capacity))
+/* Block of a dynamic map, rounded so the next arena block stays aligned */
+#define RTU_DYN_BYTES(cap) \
+    (((cap) * (sizeof(RTU_Register_t) + sizeof(RTU_RegIndex_t)) + sizeof(void *) - 1U) & ~(sizeof(void *) - 1U))
+#endif
+
+#if RTU_PERSIST_ENABLE
+/* Store file: one header page, then two checkpoint slots of
+ * [seq][sum][words x uint16_t] in native byte order */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t format;
+    uint32_t words;
+    uint32_t layout; // fingerprint of the holding map (addresses and types)
+} rtu_persist_hdr_t;
 
-    return RTU_OK;
+typedef struct
+{
+    uint32_t seq;
+    uint32_t sum; // FNV-1a over seq and the values
+} rtu_persist_slot_t;
+
+/* FNV-1a, used for the checkpoint checksum and the layout fingerprint */
+static uint32_t rtu_fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ p[i]) * 16777619UL;
+    return h;
 }
 
-/* Deinitialize, free everything allocated */
-void RTUSlave_Deinit(void)
+static uint32_t rtu_persist_now(void)
 {
-    if (this->coils)
-        rtufree_register_list(&this->coils);
-    if (this->holdingRegs)
-        rtufree_register_list(&this->holdingRegs);
-    if (this->inputRegs)
-        rtufree_register_list(&this->inputRegs);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000u + (uint32_t)(ts.tv_nsec / 1000000L);
+}
 
-    this->g_frame.ready = false;
-    this->g_frame.len = 0;
+/* Lowest-address node of a list, where its chain starts */
+static const RTU_Register_t *rtu_first_node(const RTU_RegList_t *list)
+{
+#if RTU_DYNAMIC_REGS
+    if (list->capacity != 0)
+    {
+        const RTU_RegIndex_t *index = RTU_DYN_INDEX(list);
+        uint16_t i = list->root;
+        if (i == RTU_DYN_NIL)
+            return NULL;
+        while (index[i].left != RTU_DYN_NIL)
+            i = index[i].left;
+        return &list->head[i];
+    }
+#endif
+    return list->head;
 }
 
-/* Registration APIs */
-RTU_Sta_t RTUSlave_RegisterCoils(RTU_RegisterMap_t *Map, size_t regNum)
+/* Registers saved for the holding map; *layout changes whenever an address or type does */
+static size_t rtu_persist_layout(uint32_t *layout)
 {
-    if (Map == NULL || regNum == 0 || regNum > RTU_MAX_COILS)
-        return RTU_ERR;
+    size_t words = 0;
+    uint32_t h = RTU_FNV_BASIS;
+    for (const RTU_Register_t *node = rtu_first_node(&this->holdingRegs); node != NULL; node = node->next)
+    {
+        h = rtu_fnv1a(h, &node->address, sizeof(node->address));
+        h = rtu_fnv1a(h, &node->type, sizeof(node->type));
+        words += RTU_NODE_WORDS(node);
+    }
+    *layout = h;
+    return words;
+}
 
-    /* Free existing */
-    if (this->coils)
-        rtufree_register_list(&this->coils);
+static rtu_persist_slot_t *rtu_persist_slot(uint8_t idx)
+{
+    size_t page = this->persist.mapSize - 2U * this->persist.slotSize;
+    return (rtu_persist_slot_t *)(this->persist.map + page + idx * this->persist.slotSize);
+}
 
-    if (rtubuild_register_list(&this->coils, Map, regNum) < 0)
+static uint32_t rtu_persist_sum(const rtu_persist_slot_t *slot, size_t words)
+{
+    uint32_t h = rtu_fnv1a(RTU_FNV_BASIS, &slot->seq, sizeof(slot->seq));
+    return rtu_fnv1a(h, slot + 1, words * sizeof(uint16_t));
+}
+
+/* Wait until the newest checkpoint, only scheduled with MS_ASYNC, is on disk */
+static RTU_Sta_t rtu_persist_settle(void)
+{
+    RTU_Persist_t *p = &this->persist;
+    if (!p->unsynced)
+        return RTU_OK;
+    if (msync(rtu_persist_slot(p->active), p->slotSize, MS_SYNC) != 0)
         return RTU_ERR;
 
+    p->unsynced = false;
     return RTU_OK;
 }
 
-RTU_Sta_t RTUSlave_RegisterHoldReg(RTU_RegisterMap_t *Map, size_t regNum)
+/* Save the holding values into the older slot and msync it with flags
+ * (MS_ASYNC from the handler, MS_SYNC to wait for the disk). The newest
+ * checkpoint is made durable first and never touched, so a crash leaves
+ * one of the two intact. */
+static RTU_Sta_t rtu_persist_checkpoint(int flags)
 {
-    if (Map == NULL || regNum == 0 || regNum > RTU_MAX_HOLD_REGS)
+    RTU_Persist_t *p = &this->persist;
+    if (rtu_persist_settle() != RTU_OK)
         return RTU_ERR;
 
-    if (this->holdingRegs)
-        rtufree_register_list(&this->holdingRegs);
+    uint8_t idx = p->active ^ 1U;
+    rtu_persist_slot_t *slot = rtu_persist_slot(idx);
+    uint16_t *img = (uint16_t *)(slot + 1);
+    uint32_t version = this->holdVersion;
+
+    for (const RTU_Register_t *node = rtu_first_node(&this->holdingRegs); node != NULL; node = node->next)
+    {
+        uint16_t words = RTU_NODE_WORDS(node);
+        uint16_t val[4] = {0};
+        if (node->value != NULL) // no storage behind the entry: its words stay 0
+            memcpy(val, node->value, words * sizeof(uint16_t));
+
+        /* unchanged words are not stored, so their pages stay clean for msync */
+        for (uint16_t j = 0; j < words; j++)
+        {
+            if (img[j] != val[j])
+                img[j] = val[j];
+        }
+        img += words;
+    }
 
-    if (rtubuild_register_list(&this->holdingRegs, Map, regNum) < 0)
+    slot->seq = p->seq + 1u;
+    slot->sum = rtu_persist_sum(slot, p->words);
+    if (msync(slot, p->slotSize, flags) != 0)
         return RTU_ERR;
 
+    p->seq = slot->seq;
+    p->active = idx;
+    p->unsynced = (flags != MS_SYNC);
+    p->savedVersion = version;
+    p->waiting = false;
     return RTU_OK;
 }
 
-RTU_Sta_t RTUSlave_RegisterInputReg(RTU_RegisterMap_t *Map, size_t regNum)
+/* Write-behind: save once RTU_PERSIST_FLUSH_MS passed since the first unsaved change */
+static void rtu_persist_poll(void)
 {
-    if (Map == NULL || regNum == 0 || regNum > RTU_MAX_INPUT_REGS)
-        return RTU_ERR;
+    RTU_Persist_t *p = &this->persist;
+    if (p->map == NULL || this->holdVersion == p->savedVersion)
+        return;
 
-    for (size_t i = 0; i < regNum; i++)
+    uint32_t now = rtu_persist_now();
+    if (!p->waiting)
     {
-        Map[i].permiss = RTU_PERMISS_OR; // only supply read permission
+        p->waiting = true;
+        p->since = now;
     }
+    if ((uint32_t)(now - p->since) < RTU_PERSIST_FLUSH_MS)
+        return;
 
-    if (this->inputRegs)
-        rtufree_register_list(&this->inputRegs);
+    /* only schedule the write-back; the previous one had RTU_PERSIST_FLUSH_MS
+     * to reach the disk, so settling it rarely waits */
+    if (rtu_persist_checkpoint(MS_ASYNC) != RTU_OK)
+        p->since = now; // retry after another delay
+}
 
-    if (rtubuild_register_list(&this->inputRegs, Map, regNum) < 0)
-        return RTU_ERR;
+/* Save pending changes and unmap the store */
+static void rtu_persist_close(void)
+{
+    RTU_Persist_t *p = &this->persist;
+    if (p->map == NULL)
+        return;
 
-    return RTU_OK;
+    if (this->holdVersion != p->savedVersion)
+        (void)rtu_persist_checkpoint(MS_SYNC);
+    else
+        (void)rtu_persist_settle();
+
+    munmap(p->map, p->mapSize);
+    close(p->fd);
+    memset(p, 0, sizeof(*p));
 }
 
-/* Receive callback: only copy bytes into internal buffer and mark ready.
- * IMPORTANT: This function does NOT parse or respond; parsing happens in TimerHandler().
- *
- * If incoming len > buf_size, the data is truncated and frame_ready becomes true.
- *
- * Concurrency note:
- * - Current implementation uses volatile g_frame flags. If ReceiveCallback is called
- *   from ISR and TimerHandler runs in task, it's acceptable in many embedded targets.
- * - For strict atomicity you may disable interrupts around ReceiveCallback or use
- *   a small mutex/critical section.
- */
-void RTUSlave_ReceiveCallback(uint8_t *data, size_t len)
+/* Size the open store file for words registers and map it; *fresh when
+ * the file had another size and was zero filled */
+static RTU_Sta_t rtu_persist_map(size_t words, bool *fresh)
 {
-    if (data == NULL || len == 0 || len > RTU_DEFAULT_BUF_SIZE)
-        return;
+    RTU_Persist_t *p = &this->persist;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t slotSize = (sizeof(rtu_persist_slot_t) + words * sizeof(uint16_t) + page - 1U) & ~(page - 1U);
+    size_t size = page + 2U * slotSize;
+
+    struct stat st;
+    *fresh = fstat(p->fd, &st) != 0 || (size_t)st.st_size != size;
+    if (*fresh && (ftruncate(p->fd, 0) != 0 || ftruncate(p->fd, (off_t)size) != 0))
+        return RTU_ERR;
 
-    size_t copy_len = len;
-    if (copy_len > sizeof(this->buf))
-        copy_len = sizeof(this->buf);
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, p->fd, 0);
+    if (map == MAP_FAILED)
+        return RTU_ERR;
 
-    /* copy first, then publish length+ready */
-    memcpy(this->buf, data, copy_len);
-    this->g_frame.len = copy_len;
-    this->g_frame.ready = true;
+    p->map = (uint8_t *)map;
+    p->mapSize = size;
+    p->slotSize = slotSize;
+    p->words = words;
+    return RTU_OK;
 }
 
-/* Helper: find node with address in list head (head is first-node pointer, or NULL) */
-static RTU_Register_t *rtu_find_node(RTU_Register_t *head, uint16_t addr)
+/* Start the mapped store over from the current values; closes it on failure */
+static RTU_Sta_t rtu_persist_start(uint32_t layout)
 {
-    RTU_Register_t *cur = head;
-    while (cur)
+    RTU_Persist_t *p = &this->persist;
+    size_t page = p->mapSize - 2U * p->slotSize;
+    rtu_persist_hdr_t *hdr = (rtu_persist_hdr_t *)p->map;
+
+    memset(p->map, 0, p->mapSize);
+    hdr->magic = RTU_PERSIST_MAGIC;
+    hdr->format = RTU_PERSIST_FORMAT;
+    hdr->words = (uint32_t)p->words;
+    hdr->layout = layout;
+    p->seq = 0;
+    p->active = 1; // first checkpoint goes to slot 0
+    p->unsynced = false;
+    if (msync(p->map, page, MS_SYNC) != 0 || rtu_persist_checkpoint(MS_SYNC) != RTU_OK)
     {
-        if (cur->address == addr)
-            return cur;
-        cur = cur->next;
+        munmap(p->map, p->mapSize);
+        close(p->fd);
+        memset(p, 0, sizeof(*p));
+        return RTU_ERR;
     }
-    return NULL;
+    return RTU_OK;
 }
 
-/* The periodic handler: when a frame is ready, process it. */
-RTU_Sta_t RTUSlave_TimerHandler(void)
+#if RTU_DYNAMIC_REGS
+/* The holding map was edited in place: keep saving it under its new layout.
+ * Closes the store if it cannot be rewritten. */
+static void rtu_persist_relayout(void)
 {
-    if (!this->g_frame.ready || this->g_frame.len < 8)
-        return RTU_NOACTIVE;
+    RTU_Persist_t *p = &this->persist;
+    if (p->map == NULL)
+        return;
 
-    /* snapshot frame pointer and len, then clear ready to allow next receive */
-    uint8_t *frame = this->buf;
-    size_t size = this->g_frame.len;
+    uint32_t layout;
+    size_t words = rtu_persist_layout(&layout);
+    const rtu_persist_hdr_t *hdr = (const rtu_persist_hdr_t *)p->map;
+    if (hdr->words == words && hdr->layout == layout)
+        return; // same addresses and types: the next checkpoint saves the new values
 
-    /* clear ready early so ReceiveCallback can overwrite buffer while we process */
-    this->g_frame.ready = false;
-    this->g_frame.len = 0;
+    bool fresh;
+    munmap(p->map, p->mapSize);
+    p->map = NULL;
+    if (rtu_persist_map(words, &fresh) != RTU_OK)
+    {
+        close(p->fd);
+        memset(p, 0, sizeof(*p));
+        return;
+    }
+    (void)rtu_persist_start(layout);
+}
+#endif
+#endif
 
-    /* Basic validation */
-    if (size < 8)
-        return RTU_ERR;
+#if RTU_SHM_ENABLE && RTU_NEED_READ_REGS
+/* Value lives in the shared image: other processes change it unseen */
+static bool rtu_shm_owns(const void *p)
+{
+    const uint8_t *base = (const uint8_t *)this->shm;
+    return base != NULL && (const uint8_t *)p >= base && (const uint8_t *)p < base + this->shmSize;
+}
 
-    if (frame[0] != this->id)
-        return RTU_ERR;
+#define RTU_SHM_OWNS(p) rtu_shm_owns(p)
+#else
+#define RTU_SHM_OWNS(p) false
+#endif
 
-    uint16_t recv_crc = (uint16_t)frame[size - 2] | ((uint16_t)frame[size - 1] << 8);
-    if (recv_crc != CRC16(frame, size - 2))
+#if RTU_NEED_REG_LISTS
+/* Carve size bytes from the arena, or calloc them when no arena is set */
+static void *rtu_alloc(size_t size, RTU_MemOwner_t *owner)
+{
+    if (this->arena != NULL)
     {
-        return RTU_ERR;
+        if (size > this->arenaSize - this->arenaUsed)
+            return NULL;
+
+        void *mem = this->arena + this->arenaUsed;
+        memset(mem, 0, size);
+        this->arenaUsed += size;
+        if (this->arenaUsed > this->arenaPeak)
+            this->arenaPeak = this->arenaUsed;
+
+        *owner = RTU_MEM_ARENA;
+        return mem;
     }
 
-    uint8_t func = frame[1];
-    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
-    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
-    RTU_Sta_t ret = RTU_ERR;
+#if RTU_NO_MALLOC
+    return NULL;
+#else
+    *owner = RTU_MEM_HEAP;
+    return calloc(1, size);
+#endif
+}
 
-    size_t resp_len = 0;
+/* Chain head[0..num) in array order */
+static void rtu_chain_nodes(RTU_Register_t *head, size_t num)
+{
+    for (size_t i = 0; i < num; i++)
+        head[i].next = (i + 1 < num) ? &head[i + 1] : NULL;
+}
+#endif
 
-    RTU_Ctx_t rtu_ctx = {0};
-    switch (func)
+/* Node slots of a list and the bytes of its block */
+static size_t rtu_list_slots(const RTU_RegList_t *list)
+{
+#if RTU_DYNAMIC_REGS
+    if (list->capacity != 0)
+        return list->capacity;
+#endif
+    return list->num;
+}
+
+static size_t rtu_list_bytes(const RTU_RegList_t *list)
+{
+#if RTU_DYNAMIC_REGS
+    if (list->capacity != 0)
+        return RTU_DYN_BYTES(list->capacity);
+#endif
+    return list->num * sizeof(RTU_Register_t);
+}
+
+/* Re-point the chain of a block that was moved down by len bytes */
+static void rtu_rebase_nodes(RTU_RegList_t *list, size_t len)
+{
+    for (size_t i = 0; i < rtu_list_slots(list); i++)
     {
-    case RTU_FUNC_READ_COILS: // red coils
+        if (list->head[i].next != NULL)
+            list->head[i].next = (RTU_Register_t *)((uint8_t *)list->head[i].next - len);
+    }
+}
+
+/* Every list that may own an arena block */
+static size_t rtu_arena_lists(RTU_RegList_t **lists)
+{
+    size_t n = 0;
+    lists[n++] = &this->coils;
+    lists[n++] = &this->discreteInputs;
+    lists[n++] = &this->holdingRegs;
+    lists[n++] = &this->inputRegs;
+#if RTU_HOT_SWAP
+    for (size_t c = 0; c < 4U; c++)
     {
-        if (reqNum == 0 || reqNum > 2000)
+        for (size_t s = 0; s < RTU_SWAP_SLOTS; s++)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
+            if (this->swapSlot[c][s].state != RTU_SWAP_FREE)
+                lists[n++] = &this->swapSlot[c][s].list;
         }
+    }
+#endif
+    return n;
+}
 
-        size_t byte_count = (reqNum + 7) / 8;
-        size_t needed = 1 + 1 + 1 + byte_count + 2; /* id + func + bytecount + data + crc */
-        if (needed > sizeof(this->buf))
+/* Release the node block of a list and reset it; caller tables are left
+ * untouched. Arena blocks above the released one are moved down so the
+ * arena stays contiguous; their lists are re-pointed. */
+static void rtu_release_nodes(RTU_RegList_t *list)
+{
+    if (list->head != NULL && list->owner == RTU_MEM_ARENA)
+    {
+        uint8_t *block = (uint8_t *)list->head;
+        size_t len = rtu_list_bytes(list);
+        uint8_t *end = this->arena + this->arenaUsed;
+
+#if RTU_HOT_SWAP
+        RTU_RegList_t *lists[4U + 4U * RTU_SWAP_SLOTS];
+#else
+        RTU_RegList_t *lists[4U];
+#endif
+        size_t count = rtu_arena_lists(lists);
+        for (size_t i = 0; i < count; i++)
         {
-            rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
-            return RTU_ERR;
+            RTU_RegList_t *l = lists[i];
+            if (l->owner == RTU_MEM_ARENA && (uint8_t *)l->head > block)
+                l->head = (RTU_Register_t *)((uint8_t *)l->head - len);
         }
 
-        memset(this->buf, 0, sizeof(this->buf));
-
-        this->buf[0] = this->id;
-        this->buf[1] = RTU_FUNC_READ_COILS;
-        this->buf[2] = (uint8_t)byte_count;
+        memmove(block, block + len, (size_t)(end - (block + len)));
+        this->arenaUsed -= len;
 
-        RTU_Register_t *node = rtu_find_node(this->coils, regAddr);
-        if (node == NULL)
+        for (size_t i = 0; i < count; i++)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
-            return RTU_ERR;
+            RTU_RegList_t *l = lists[i];
+            if (l != list && l->owner == RTU_MEM_ARENA && (uint8_t *)l->head >= block)
+                rtu_rebase_nodes(l, len);
         }
+    }
+#if !RTU_NO_MALLOC
+    else if (list->head != NULL && list->owner == RTU_MEM_HEAP)
+    {
+        free(list->head);
+    }
+#endif
+
+    list->head = NULL;
+    list->num = 0;
+    list->sorted = false;
+    list->owner = RTU_MEM_HEAP;
+#if RTU_DYNAMIC_REGS
+    list->capacity = 0;
+#endif
+}
 
-        for (uint16_t i = 0; i < reqNum; ++i)
-        {
-            uint16_t expect_addr = regAddr + i;
-            if (node == NULL || node->address != expect_addr)
-            {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_ERR;
-            }
-
-            uint8_t bit = 0;
-            if (node->value)
-            {
-                bit = ((*((uint8_t *)node->value)) != 0) ? 1u : 0u;
-
-                if (node->callback != NULL)
-                {
-                    rtu_ctx.addr = node->address;
-                    rtu_ctx.op = RTU_RW_READ;
-                    rtu_ctx.value = bit;
-                    CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
-                }
-            }
-            else
-            {
-                rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
-                return RTU_ERR;
-            }
-
-            size_t byte_index = 3 + (i >> 3);
-            size_t bit_index = i & 0x07;
-            this->buf[byte_index] |= (uint8_t)(bit << bit_index);
+/* Free the map a register class is served from */
+static void rtufree_register_list(RTU_RegList_t *list)
+{
+#if RTU_DIRTY_TRACKING
+    rtu_dirty_reset(list);
+#endif
+#if RTU_PERSIST_ENABLE
+    if (list == &this->holdingRegs)
+        rtu_persist_close(); // the saved layout ends with this map
+#endif
+    RTU_VERSION_TOUCH(list);
+
+    rtu_release_nodes(list);
+}
 
-            node = node->next;
-        }
+#if RTU_HOT_SWAP
+/*
+ * Hot swap: a registration builds the new map in a swap slot and publishes
+ * it; RTUSlave_TimerHandler() adopts it between two requests, the only
+ * point where no node of the old map can be referenced, and frees the old
+ * map there. Writers and the server share arenaLock for the arena and the
+ * slots; writers wait for it, the server only tries it and keeps serving
+ * the current map when it is taken.
+ */
 
-        size_t crc_pos = 3 + byte_count;
-        uint16_t crc = CRC16(this->buf, crc_pos);
-        this->buf[crc_pos + 0] = (uint8_t)(crc & 0x00FF);
-        this->buf[crc_pos + 1] = (uint8_t)((crc >> 8) & 0x00FF);
+/* Claim the arena and the swap slots for a registration */
+static void rtu_swap_lock(void)
+{
+    while (!RTU_TRY_LOCK(&this->arenaLock))
+    {
+    }
+}
 
-        resp_len = crc_pos + 2;
-        RTU_Transmit(this->buf, resp_len);
+/* Class index of a register list, RTU_RegClass_t order */
+static size_t rtu_swap_class(const RTU_RegList_t *list)
+{
+    if (list == &this->coils)
+        return RTU_CLASS_COILS;
+    if (list == &this->discreteInputs)
+        return RTU_CLASS_DISCRETE_INPUTS;
+    if (list == &this->holdingRegs)
+        return RTU_CLASS_HOLDING_REGS;
+    return RTU_CLASS_INPUT_REGS;
+}
 
-        ret = RTU_READ_COIL;
-        break;
+/* Free swap slot of a class, NULL when the server has not caught up yet */
+static RTU_SwapSlot_t *rtu_swap_slot(size_t cls)
+{
+    for (size_t s = 0; s < RTU_SWAP_SLOTS; s++)
+    {
+        if (this->swapSlot[cls][s].state == RTU_SWAP_FREE)
+            return &this->swapSlot[cls][s];
     }
+    return NULL;
+}
 
-    case RTU_FUNC_READ_HOLD_REGS:
+/* Hand a filled slot to the server, replacing a map it has not adopted yet */
+static void rtu_swap_publish(size_t cls, RTU_SwapSlot_t *slot)
+{
+    RTU_SwapSlot_t *prev = this->swapNew[cls];
+    if (prev != NULL)
     {
-        if (reqNum == 0 || reqNum > 125)
+        /* never served; arena blocks are only moved by the server */
+        if (prev->list.owner == RTU_MEM_ARENA)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
+            prev->state = RTU_SWAP_DEAD;
         }
+        else
+        {
+            rtu_release_nodes(&prev->list);
+            prev->state = RTU_SWAP_FREE;
+        }
+    }
 
-        size_t byte_count = reqNum * 2;
-        size_t needed = 1 + 1 + 1 + byte_count + 2;
-        if (needed > sizeof(this->buf))
-            return RTU_ERR;
-
-        memset(this->buf, 0, sizeof(this->buf));
+    slot->state = RTU_SWAP_BUSY;
+    this->swapNew[cls] = slot;
+    RTU_STORE_RELEASE(&this->swapPending, true);
+}
 
-        this->buf[0] = this->id;
-        this->buf[1] = RTU_FUNC_READ_HOLD_REGS;
-        this->buf[2] = (uint8_t)byte_count;
+/* Serve the published maps from now on and free the ones they replace (slots claimed) */
+static void rtu_swap_take(void)
+{
+    if (!this->swapPending)
+        return;
 
-        RTU_Register_t *node = rtu_find_node(this->holdingRegs, regAddr);
-        if (node == NULL)
+    RTU_RegList_t *views[] = {&this->coils, &this->discreteInputs, &this->holdingRegs, &this->inputRegs};
+    for (size_t c = 0; c < 4U; c++)
+    {
+        RTU_SwapSlot_t *slot = this->swapNew[c];
+        if (slot != NULL)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+            rtufree_register_list(views[c]); // re-points the slot if its block moves
+            *views[c] = slot->list;
+            slot->state = RTU_SWAP_FREE;
+            this->swapNew[c] = NULL;
+        }
+
+        for (size_t s = 0; s < RTU_SWAP_SLOTS; s++)
+        {
+            if (this->swapSlot[c][s].state == RTU_SWAP_DEAD)
+            {
+                rtu_release_nodes(&this->swapSlot[c][s].list);
+                this->swapSlot[c][s].state = RTU_SWAP_FREE;
+            }
+        }
+    }
+
+    this->swapPending = false;
+}
+
+static void rtu_swap_adopt(void)
+{
+    if (!RTU_LOAD_ACQUIRE(&this->swapPending) || !RTU_TRY_LOCK(&this->arenaLock))
+        return; // nothing new, or a registration is building: next call
+
+    rtu_swap_take();
+    RTU_UNLOCK(&this->arenaLock);
+}
+
+#define RTU_SWAP_ADOPT() rtu_swap_adopt()
+#else
+#define RTU_SWAP_ADOPT() ((void)0)
+#endif
+
+#if RTU_NEED_REG_LISTS
+/* Node from a map entry; the chain link is left to the caller */
+static void rtu_fill_node(RTU_Register_t *node, const RTU_RegisterMap_t *map, bool readOnly)
+{
+    node->address = map->addr;
+    node->value = map->data;
+    node->permiss = readOnly ? (uint8_t)RTU_PERMISS_OR : (uint8_t)map->permiss;
+    node->callback = map->callback;
+    node->group = map->group;
+#if RTU_TYPED_REGS
+    node->type = RTU_REG_TYPE(map->type, map->order);
+#else
+    node->type = 0;
+#endif
+}
+
+/* Build one contiguous node block from Map into out; list is the class it
+ * is built for. Returns 0 on success, -1 on failure.
+ *
+ * NOTE: node->value points to the original map[i].data (no deep copy).
+ */
+static int rtubuild_register_list(const RTU_RegList_t *list, RTU_RegList_t *out, const RTU_RegisterMap_t *map, size_t count,
+                                  bool readOnly)
+{
+    if (list == NULL || out == NULL)
+        return -1;
+
+    if (map == NULL || count == 0)
+        return 0; // nothing to build
+
+#if RTU_TYPED_REGS
+    for (size_t i = 0; i < count; ++i)
+    {
+        if ((unsigned)map[i].type > RTU_TYPE_F64 || (unsigned)map[i].order > RTU_ORDER_DCBA ||
+            !rtu_type_valid(list, RTU_REG_TYPE(map[i].type, map[i].order), map[i].addr))
+            return -1;
+
+        /* a typed value must end before the next entry starts */
+        if (i > 0 && map[i].addr > map[i - 1].addr &&
+            (uint32_t)map[i].addr < (uint32_t)map[i - 1].addr + rtu_node_words((uint8_t)map[i - 1].type))
+            return -1;
+    }
+#endif
+
+    RTU_MemOwner_t owner = RTU_MEM_HEAP;
+    RTU_Register_t *nodes = (RTU_Register_t *)rtu_alloc(count * sizeof(RTU_Register_t), &owner);
+    if (nodes == NULL)
+        return -1;
+
+    bool sorted = true;
+    for (size_t i = 0; i < count; ++i)
+    {
+        rtu_fill_node(&nodes[i], &map[i], readOnly);
+
+        if (i > 0 && map[i].addr <= map[i - 1].addr)
+            sorted = false;
+    }
+    rtu_chain_nodes(nodes, count);
+
+    out->head = nodes;
+    out->num = count;
+    out->sorted = sorted;
+    out->owner = owner;
+#if RTU_DYNAMIC_REGS
+    out->capacity = 0;
+#endif
+
+    return 0;
+}
+
+/* Replace a register class with a list built from Map */
+static RTU_Sta_t rtu_register_list(RTU_RegList_t *list, const RTU_RegisterMap_t *Map, size_t regNum, size_t maxNum, bool readOnly)
+{
+    if (Map == NULL || regNum == 0 || regNum > maxNum)
+        return RTU_ERR;
+
+#if RTU_HOT_SWAP
+    size_t cls = rtu_swap_class(list);
+    RTU_Sta_t ret = RTU_ERR;
+
+    rtu_swap_lock();
+    RTU_SwapSlot_t *slot = rtu_swap_slot(cls);
+    if (slot != NULL && rtubuild_register_list(list, &slot->list, Map, regNum, readOnly) == 0)
+    {
+        rtu_swap_publish(cls, slot);
+        ret = RTU_OK;
+    }
+    RTU_UNLOCK(&this->arenaLock);
+
+    return ret;
+#else
+    /* Free existing */
+    rtufree_register_list(list);
+
+    if (rtubuild_register_list(list, list, Map, regNum, readOnly) < 0)
+        return RTU_ERR;
+
+    return RTU_OK;
+#endif
+}
+#endif
+
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS
+/*
+ * Dynamic maps: the class lives in a pool of `capacity` node slots followed
+ * by an AVL tree over them. A node keeps its slot until it is removed, so
+ * the chain (address order), dirty indices and pointers held by a request
+ * stay valid; insert, remove and rebind cost O(log n). Free slots are
+ * chained through index[].left and reused first.
+ */
+
+static uint8_t rtu_dyn_height(const RTU_RegIndex_t *index, uint16_t i)
+{
+    return (i == RTU_DYN_NIL) ? 0U : index[i].height;
+}
+
+static void rtu_dyn_fix(RTU_RegIndex_t *index, uint16_t i)
+{
+    uint8_t l = rtu_dyn_height(index, index[i].left);
+    uint8_t r = rtu_dyn_height(index, index[i].right);
+    index[i].height = (uint8_t)((l > r ? l : r) + 1U);
+}
+
+static uint16_t rtu_dyn_rotate_right(RTU_RegIndex_t *index, uint16_t i)
+{
+    uint16_t l = index[i].left;
+    index[i].left = index[l].right;
+    index[l].right = i;
+    rtu_dyn_fix(index, i);
+    rtu_dyn_fix(index, l);
+    return l;
+}
+
+static uint16_t rtu_dyn_rotate_left(RTU_RegIndex_t *index, uint16_t i)
+{
+    uint16_t r = index[i].right;
+    index[i].right = index[r].left;
+    index[r].left = i;
+    rtu_dyn_fix(index, i);
+    rtu_dyn_fix(index, r);
+    return r;
+}
+
+/* Rebalance subtree i after one of its sides changed height by one */
+static uint16_t rtu_dyn_balance(RTU_RegIndex_t *index, uint16_t i)
+{
+    rtu_dyn_fix(index, i);
+    int bf = (int)rtu_dyn_height(index, index[i].left) - (int)rtu_dyn_height(index, index[i].right);
+    if (bf > 1)
+    {
+        uint16_t l = index[i].left;
+        if (rtu_dyn_height(index, index[l].left) < rtu_dyn_height(index, index[l].right))
+            index[i].left = rtu_dyn_rotate_left(index, l);
+        return rtu_dyn_rotate_right(index, i);
+    }
+    if (bf < -1)
+    {
+        uint16_t r = index[i].right;
+        if (rtu_dyn_height(index, index[r].right) < rtu_dyn_height(index, index[r].left))
+            index[i].right = rtu_dyn_rotate_right(index, r);
+        return rtu_dyn_rotate_left(index, i);
+    }
+    return i;
+}
+
+/* Add slot to subtree i; its address is not in the tree yet */
+static uint16_t rtu_dyn_link(const RTU_Register_t *nodes, RTU_RegIndex_t *index, uint16_t i, uint16_t slot)
+{
+    if (i == RTU_DYN_NIL)
+    {
+        index[slot].left = RTU_DYN_NIL;
+        index[slot].right = RTU_DYN_NIL;
+        index[slot].height = 1U;
+        return slot;
+    }
+
+    if (nodes[slot].address < nodes[i].address)
+        index[i].left = rtu_dyn_link(nodes, index, index[i].left, slot);
+    else
+        index[i].right = rtu_dyn_link(nodes, index, index[i].right, slot);
+    return rtu_dyn_balance(index, i);
+}
+
+/* Take the lowest slot out of subtree i into *min */
+static uint16_t rtu_dyn_unlink_min(RTU_RegIndex_t *index, uint16_t i, uint16_t *min)
+{
+    if (index[i].left == RTU_DYN_NIL)
+    {
+        *min = i;
+        return index[i].right;
+    }
+
+    index[i].left = rtu_dyn_unlink_min(index, index[i].left, min);
+    return rtu_dyn_balance(index, i);
+}
+
+/* Take the slot holding addr (present) out of subtree i */
+static uint16_t rtu_dyn_unlink(const RTU_Register_t *nodes, RTU_RegIndex_t *index, uint16_t i, uint16_t addr)
+{
+    if (addr < nodes[i].address)
+    {
+        index[i].left = rtu_dyn_unlink(nodes, index, index[i].left, addr);
+    }
+    else if (addr > nodes[i].address)
+    {
+        index[i].right = rtu_dyn_unlink(nodes, index, index[i].right, addr);
+    }
+    else
+    {
+        uint16_t left = index[i].left;
+        uint16_t right = index[i].right;
+        if (right == RTU_DYN_NIL)
+            return left;
+
+        /* the lowest slot of the right side takes its place */
+        right = rtu_dyn_unlink_min(index, right, &i);
+        index[i].left = left;
+        index[i].right = right;
+    }
+    return rtu_dyn_balance(index, i);
+}
+
+/* Slot with the highest address below addr, or with the lowest address >= addr (above) */
+static uint16_t rtu_dyn_near(const RTU_RegList_t *list, uint32_t addr, bool above)
+{
+    const RTU_RegIndex_t *index = RTU_DYN_INDEX(list);
+    uint16_t best = RTU_DYN_NIL;
+    uint16_t i = list->root;
+    while (i != RTU_DYN_NIL)
+    {
+        if (list->head[i].address < addr)
+        {
+            if (!above)
+                best = i;
+            i = index[i].right;
+        }
+        else
+        {
+            if (above)
+                best = i;
+            i = index[i].left;
+        }
+    }
+    return best;
+}
+
+/* Link a filled slot into the tree and the chain, unless it overlaps a neighbour */
+static RTU_Sta_t rtu_dyn_place(RTU_RegList_t *list, uint16_t slot)
+{
+    RTU_Register_t *node = &list->head[slot];
+    uint16_t prev = rtu_dyn_near(list, node->address, false);
+    uint16_t next = rtu_dyn_near(list, node->address, true);
+
+    if (next != RTU_DYN_NIL && (uint32_t)node->address + RTU_NODE_WORDS(node) > list->head[next].address)
+        return RTU_ERR; // address taken, or a typed value would run into the next entry
+    if (prev != RTU_DYN_NIL &&
+        (uint32_t)list->head[prev].address + RTU_NODE_WORDS(&list->head[prev]) > node->address)
+        return RTU_ERR;
+
+    node->next = (next != RTU_DYN_NIL) ? &list->head[next] : NULL;
+    if (prev != RTU_DYN_NIL)
+        list->head[prev].next = node;
+
+    list->root = rtu_dyn_link(list->head, RTU_DYN_INDEX(list), list->root, slot);
+    return RTU_OK;
+}
+
+/* Unlink a slot from the tree and the chain and free it; prev is the node before it */
+static void rtu_dyn_remove(RTU_RegList_t *list, uint16_t slot, uint16_t prev)
+{
+    RTU_RegIndex_t *index = RTU_DYN_INDEX(list);
+    RTU_Register_t *node = &list->head[slot];
+
+    if (prev != RTU_DYN_NIL)
+        list->head[prev].next = node->next;
+    list->root = rtu_dyn_unlink(list->head, index, list->root, node->address);
+
+#if RTU_DIRTY_TRACKING
+    rtu_dirty_drop(list, slot); // must not be reported for the slot's next owner
+#endif
+
+    memset(node, 0, sizeof(*node));
+    index[slot].left = list->freeSlot;
+    list->freeSlot = slot;
+    list->num--;
+}
+
+/* Move a list into a pool of cap slots; nodes keep their slot. A fixed map
+ * is indexed on the way and must not hold duplicate or overlapping entries. */
+static RTU_Sta_t rtu_dyn_grow(RTU_RegList_t *list, size_t cap)
+{
+    size_t used = rtu_list_slots(list);
+    RTU_RegList_t pool = {0};
+
+    pool.head = (RTU_Register_t *)rtu_alloc(RTU_DYN_BYTES(cap), &pool.owner);
+    if (pool.head == NULL)
+        return RTU_ERR;
+
+    pool.num = list->num;
+    pool.sorted = true;
+    pool.capacity = cap;
+    pool.root = RTU_DYN_NIL;
+    pool.freeSlot = RTU_DYN_NIL;
+
+    RTU_RegIndex_t *index = RTU_DYN_INDEX(&pool);
+    if (used != 0)
+        memcpy(pool.head, list->head, used * sizeof(RTU_Register_t));
+
+    if (list->capacity != 0)
+    {
+        memcpy(index, RTU_DYN_INDEX(list), used * sizeof(RTU_RegIndex_t));
+        rtu_rebase_nodes(&pool, (size_t)((uint8_t *)list->head - (uint8_t *)pool.head));
+        pool.root = list->root;
+        pool.freeSlot = list->freeSlot;
+    }
+    else
+    {
+        for (size_t i = 0; i < used; i++)
+        {
+            if (rtu_dyn_place(&pool, (uint16_t)i) != RTU_OK)
+            {
+                rtu_release_nodes(&pool); // the last block: nothing else moves
+                return RTU_ERR;
+            }
+        }
+    }
+
+    for (size_t i = cap; i-- > used;)
+    {
+        index[i].left = pool.freeSlot;
+        pool.freeSlot = (uint16_t)i;
+    }
+
+    RTU_RegList_t old = *list;
+    *list = pool;
+    rtu_release_nodes(&old); // may move the pool down, list is re-pointed with it
+    return RTU_OK;
+}
+
+/* Make the list dynamic with room for n more entries, doubling the pool */
+static RTU_Sta_t rtu_dyn_reserve(RTU_RegList_t *list, size_t n)
+{
+    size_t max = (list == &this->coils)         ? RTU_MAX_COILS
+                 : (list == &this->holdingRegs) ? RTU_MAX_HOLD_REGS
+                 : (list == &this->inputRegs)   ? RTU_MAX_INPUT_REGS
+                                                : RTU_MAX_DISCRETE_INPUTS;
+    if (max > RTU_DYN_NIL)
+        max = RTU_DYN_NIL;
+
+    size_t need = list->num + n;
+    if (need > max)
+        return RTU_ERR;
+    if (list->capacity != 0 && need <= list->capacity)
+        return RTU_OK;
+
+    size_t cap = (rtu_list_slots(list) > 16U) ? rtu_list_slots(list) : 16U;
+    while (cap < need)
+        cap *= 2U;
+    return rtu_dyn_grow(list, (cap < max) ? cap : max);
+}
+
+/* The class changed under cached responses and the saved holding layout */
+static void rtu_dyn_changed(RTU_RegList_t *list)
+{
+    (void)list;
+    RTU_VERSION_TOUCH(list);
+#if RTU_PERSIST_ENABLE
+    if (list == &this->holdingRegs)
+        rtu_persist_relayout();
+#endif
+}
+
+static RTU_Sta_t rtu_dyn_insert(RTU_RegList_t *list, const RTU_RegisterMap_t *Map, size_t regNum)
+{
+    bool readOnly = (list == &this->inputRegs || list == &this->discreteInputs);
+    if (rtu_dyn_reserve(list, regNum) != RTU_OK)
+        return RTU_ERR;
+
+    size_t done = 0;
+    for (; done < regNum; done++)
+    {
+#if RTU_TYPED_REGS
+        if ((unsigned)Map[done].type > RTU_TYPE_F64 || (unsigned)Map[done].order > RTU_ORDER_DCBA ||
+            !rtu_type_valid(list, RTU_REG_TYPE(Map[done].type, Map[done].order), Map[done].addr))
+            break;
+#endif
+        RTU_RegIndex_t *index = RTU_DYN_INDEX(list);
+        uint16_t slot = list->freeSlot;
+        list->freeSlot = index[slot].left;
+        rtu_fill_node(&list->head[slot], &Map[done], readOnly);
+        if (rtu_dyn_place(list, slot) != RTU_OK)
+        {
+            memset(&list->head[slot], 0, sizeof(RTU_Register_t));
+            index[slot].left = list->freeSlot;
+            list->freeSlot = slot;
+            break;
+        }
+        list->num++;
+    }
+
+    if (done < regNum)
+    {
+        /* all or nothing: take back what this call added */
+        while (done-- > 0)
+        {
+            uint16_t slot = rtu_dyn_near(list, Map[done].addr, true);
+            rtu_dyn_remove(list, slot, rtu_dyn_near(list, Map[done].addr, false));
+        }
+        return RTU_ERR;
+    }
+
+    rtu_dyn_changed(list);
+    return RTU_OK;
+}
+
+static RTU_Sta_t rtu_dyn_remove_range(RTU_RegList_t *list, uint16_t startAddr, uint16_t count)
+{
+    uint32_t end = (uint32_t)startAddr + count;
+    if (list->num == 0 || rtu_dyn_reserve(list, 0) != RTU_OK)
+        return RTU_ERR;
+
+    uint16_t prev = rtu_dyn_near(list, startAddr, false);
+    uint16_t slot = rtu_dyn_near(list, startAddr, true);
+    if (slot == RTU_DYN_NIL || list->head[slot].address >= end)
+        return RTU_ERR;
+
+    while (slot != RTU_DYN_NIL && list->head[slot].address < end)
+    {
+        RTU_Register_t *next = list->head[slot].next;
+        rtu_dyn_remove(list, slot, prev);
+        slot = (next != NULL) ? (uint16_t)(next - list->head) : RTU_DYN_NIL;
+    }
+
+    rtu_dyn_changed(list);
+    return RTU_OK;
+}
+
+static RTU_Sta_t rtu_dyn_rebind(RTU_RegList_t *list, const RTU_RegisterMap_t *Map, size_t regNum)
+{
+    bool readOnly = (list == &this->inputRegs || list == &this->discreteInputs);
+    if (list->num == 0 || rtu_dyn_reserve(list, 0) != RTU_OK)
+        return RTU_ERR;
+
+    /* check every entry before changing any */
+    for (size_t i = 0; i < regNum; i++)
+    {
+        uint16_t slot = rtu_dyn_near(list, Map[i].addr, true);
+        if (slot == RTU_DYN_NIL || list->head[slot].address != Map[i].addr)
+            return RTU_ERR;
+#if RTU_TYPED_REGS
+        uint8_t type = RTU_REG_TYPE(Map[i].type, Map[i].order);
+        const RTU_Register_t *next = list->head[slot].next;
+        if ((unsigned)Map[i].type > RTU_TYPE_F64 || (unsigned)Map[i].order > RTU_ORDER_DCBA ||
+            !rtu_type_valid(list, type, Map[i].addr) ||
+            (next != NULL && (uint32_t)Map[i].addr + rtu_node_words(type) > next->address))
             return RTU_ERR;
+#endif
+    }
+
+    for (size_t i = 0; i < regNum; i++)
+    {
+        RTU_Register_t *node = &list->head[rtu_dyn_near(list, Map[i].addr, true)];
+        RTU_Register_t *next = node->next;
+        rtu_fill_node(node, &Map[i], readOnly);
+        node->next = next;
+    }
+
+    rtu_dyn_changed(list);
+    return RTU_OK;
+}
+#endif
+
+#if RTU_FC_READ_DISCRETE_INPUTS_ENABLE
+/* Copy nbits bits starting at bit offset `off` of src into dst (LSB first).
+ * Works a byte at a time; unused high bits of the last dst byte are cleared. */
+static void rtu_copy_bits(uint8_t *dst, const uint8_t *src, size_t off, size_t nbits)
+{
+    size_t nbytes = (nbits + 7) / 8;
+    size_t src_byte = off >> 3;
+    uint8_t shift = (uint8_t)(off & 0x07);
+    size_t src_last = (off + nbits - 1) >> 3;
+
+    for (size_t i = 0; i < nbytes; i++, src_byte++)
+    {
+        uint8_t b = (uint8_t)(src[src_byte] >> shift);
+        if (shift != 0 && src_byte + 1 <= src_last)
+            b |= (uint8_t)(src[src_byte + 1] << (8 - shift));
+        dst[i] = b;
+    }
+
+    if (nbits & 0x07)
+        dst[nbytes - 1] &= (uint8_t)((1u << (nbits & 0x07)) - 1u);
+}
+#endif
+
+#if RTU_MONITOR_ENABLE
+/* Copy n bytes into / out of the capture ring at free-running offset pos */
+static void rtu_mon_put(uint32_t pos, const uint8_t *src, size_t n)
+{
+    size_t off = pos & (RTU_MONITOR_RING_SIZE - 1U);
+    size_t first = RTU_MONITOR_RING_SIZE - off;
+    if (first > n)
+        first = n;
+
+    memcpy(&this->mon.ring[off], src, first);
+    memcpy(this->mon.ring, src + first, n - first);
+}
+
+static void rtu_mon_get(uint32_t pos, uint8_t *dst, size_t n)
+{
+    size_t off = pos & (RTU_MONITOR_RING_SIZE - 1U);
+    size_t first = RTU_MONITOR_RING_SIZE - off;
+    if (first > n)
+        first = n;
+
+    memcpy(dst, &this->mon.ring[off], first);
+    memcpy(dst + first, this->mon.ring, n - first);
+}
+
+/* Append one frame record; a record that does not fit is dropped whole */
+static void rtu_mon_log(const uint8_t *frame, size_t len, uint32_t time, uint8_t flags)
+{
+    RTU_Monitor_t *mon = &this->mon;
+    uint32_t head = mon->head;
+    uint32_t used = head - RTU_LOAD_ACQUIRE(&mon->tail);
+    size_t need = RTU_MON_HDR_SIZE + len;
+
+    if (need > RTU_MONITOR_RING_SIZE - used)
+    {
+        mon->dropped++;
+        return;
+    }
+
+    uint8_t hdr[RTU_MON_HDR_SIZE] = {
+        RTU_MON_SYNC,
+        flags,
+        (uint8_t)(len & 0xFF),
+        (uint8_t)(len >> 8),
+        (uint8_t)(time & 0xFF),
+        (uint8_t)((time >> 8) & 0xFF),
+        (uint8_t)((time >> 16) & 0xFF),
+        (uint8_t)(time >> 24),
+    };
+
+    rtu_mon_put(head, hdr, RTU_MON_HDR_SIZE);
+    rtu_mon_put(head + RTU_MON_HDR_SIZE, frame, len);
+    RTU_STORE_RELEASE(&mon->head, head + (uint32_t)need); // publish after the data
+}
+#endif
+
+/* Send a response unless the current request is a broadcast (no reply allowed) */
+static void rtu_reply(uint8_t *data, size_t len)
+{
+    if (this->broadcast)
+        return;
+
+#if RTU_MONITOR_ENABLE
+    if (this->mon.mode == RTU_MONITOR_PROMISC)
+        rtu_mon_log(data, len, RTU_MonitorTime(), RTU_MON_FLAG_CRC_OK | RTU_MON_FLAG_TX);
+#endif
+
+    RTU_Transmit(data, len);
+}
+
+#if RTU_PENDING_MAX
+static void rtu_send_exception(uint8_t func, RTU_ExceptionCode_t ex_code);
+
+/* Helper: park the current request for RTUSlave_CompletePending(), busy when no slot is free */
+static void rtu_park_request(uint8_t func)
+{
+    RTU_Pending_t *p = NULL;
+
+    if (this->curSlot != 0)
+    {
+        p = &this->pending[this->curSlot - 1]; // parked again: keep its slot
+    }
+    else if (this->reqLen != 0)
+    {
+        for (uint8_t i = 0; i < RTU_PENDING_MAX; i++)
+        {
+            if (this->pending[i].state == RTU_PEND_FREE)
+            {
+                p = &this->pending[i];
+                memcpy(p->frame, this->reqCopy, this->reqLen);
+                p->len = this->reqLen;
+                p->silent = this->broadcast;
+                break;
+            }
         }
+    }
+
+    if (p == NULL)
+    {
+        rtu_send_exception(func, RTU_EX_SLAVE_BUSY);
+        return;
+    }
+
+    p->resume = this->resumeFrom;
+    p->state = RTU_PEND_WAIT;
+    this->deferred = true;
+}
+#endif
+
+#if RTU_PENDING_MAX && !RTU_STAGED_WRITES
+/* A multiple write parked by a callback has stored everything before it;
+ * the re-run starts at that callback instead of writing (and notifying) twice */
+#define RTU_RESUME_FROM() (this->resumeFrom)
+#define RTU_RESUME_AT(i) (this->resumeFrom = (i))
+#else
+#define RTU_RESUME_FROM() 0U
+#define RTU_RESUME_AT(i) ((void)0)
+#endif
+
+/**
+ * @brief 发送 Modbus 异常响应
+ * @param func 原始请求的功能码
+ * @param ex_code 异常码 (0x01 - 0x04)
+ */
+static void rtu_send_exception(uint8_t func, RTU_ExceptionCode_t ex_code)
+{
+    uint8_t *resp = this->buf; // 复用内部缓冲区
+    uint16_t crc;
+
+    /* RTU_EX_PENDING is never sent: park the request, or busy when that is not possible */
+    if (ex_code == RTU_EX_PENDING)
+    {
+#if RTU_PENDING_MAX
+        rtu_park_request(func);
+        return;
+#else
+        ex_code = RTU_EX_SLAVE_BUSY;
+#endif
+    }
+
+    resp[0] = this->id;
+    resp[1] = func | 0x80;      // 功能码最高位置 1
+    resp[2] = (uint8_t)ex_code; // 填充异常码
+
+    // 计算这 3 个字节的 CRC
+    crc = CRC16(resp, 3);
+    resp[3] = (uint8_t)(crc & 0xFF);
+    resp[4] = (uint8_t)(crc >> 8);
+
+    // 异常帧长度固定为 5 字节
+    rtu_reply(resp, 5);
+}
+
+/* Initialize singleton */
+RTU_Sta_t RTUSlave_Init(void)
+{
+    /* buf is static array; set buf_size accordingly */
+    this->buf_size = (uint16_t)sizeof(this->buf);
+
+    /* default id 1 */
+    this->id = 1;
+
+    /* ensure heads are empty (they are zeroed by static init, but be explicit) */
+    memset(&this->coils, 0, sizeof(this->coils));
+    memset(&this->holdingRegs, 0, sizeof(this->holdingRegs));
+    memset(&this->inputRegs, 0, sizeof(this->inputRegs));
+    memset(&this->discreteInputs, 0, sizeof(this->discreteInputs));
+    memset(&this->discreteImage, 0, sizeof(this->discreteImage));
+    memset(this->fifos, 0, sizeof(this->fifos));
+    this->files = NULL;
+    this->fileNum = 0;
+
+    this->arena = NULL;
+    this->arenaSize = 0;
+    this->arenaUsed = 0;
+    this->arenaPeak = 0;
+
+#if RTU_HOT_SWAP
+    memset(this->swapSlot, 0, sizeof(this->swapSlot));
+    memset(this->swapNew, 0, sizeof(this->swapNew));
+    this->swapPending = false;
+    this->arenaLock = false;
+#endif
+
+    memset(this->funcSlot, 0, sizeof(this->funcSlot));
+    memset(this->userFuncs, 0, sizeof(this->userFuncs));
+
+#if RTU_MONITOR_ENABLE
+    this->mon.mode = RTU_MONITOR_OFF;
+    this->mon.head = 0;
+    this->mon.tail = 0;
+    this->mon.dropped = 0;
+#endif
+
+#if RTU_RESP_CACHE_SIZE
+    rtu_cache_clear();
+#endif
+
+#if RTU_PENDING_MAX
+    memset(this->pending, 0, sizeof(this->pending));
+    this->reqLen = 0;
+    this->curSlot = 0;
+    this->deferred = false;
+#endif
+
+#if RTU_DIRTY_TRACKING
+    this->dirtyHold.queue = this->dirtyHoldQueue;
+    this->dirtyHold.mark = this->dirtyHoldMark;
+    this->dirtyHold.capacity = RTU_MAX_HOLD_REGS;
+    this->dirtyCoils.queue = this->dirtyCoilQueue;
+    this->dirtyCoils.mark = this->dirtyCoilMark;
+    this->dirtyCoils.capacity = RTU_MAX_COILS;
+    rtu_dirty_reset(&this->holdingRegs);
+    rtu_dirty_reset(&this->coils);
+#endif
+
+    this->g_frame.ready = false;
+    this->g_frame.len = 0;
+
+    return RTU_OK;
+}
+
+RTU_Sta_t RTUSlave_InitArena(void *arena, size_t size)
+{
+    if (arena == NULL)
+        return RTU_ERR;
+
+    RTUSlave_Deinit();
+    RTUSlave_Init();
+
+    /* align the start so every node block is naturally aligned */
+    uintptr_t base = (uintptr_t)arena;
+    uintptr_t aligned = (base + (sizeof(void *) - 1)) & ~(uintptr_t)(sizeof(void *) - 1);
+    if (aligned - base >= size)
+        return RTU_ERR;
+
+    this->arena = (uint8_t *)aligned;
+    this->arenaSize = size - (size_t)(aligned - base);
+
+    return RTU_OK;
+}
+
+RTU_Sta_t RTUSlave_ArenaUsage(size_t *used, size_t *peak)
+{
+    if (this->arena == NULL)
+        return RTU_ERR;
+
+    if (used)
+        *used = this->arenaUsed;
+    if (peak)
+        *peak = this->arenaPeak;
+
+    return RTU_OK;
+}
+
+/* Deinitialize, free everything allocated */
+void RTUSlave_Deinit(void)
+{
+    rtufree_register_list(&this->coils);
+    rtufree_register_list(&this->holdingRegs);
+    rtufree_register_list(&this->inputRegs);
+    rtufree_register_list(&this->discreteInputs);
+#if RTU_HOT_SWAP
+    /* maps published but never adopted */
+    for (size_t c = 0; c < 4U; c++)
+    {
+        for (size_t s = 0; s < RTU_SWAP_SLOTS; s++)
+        {
+            if (this->swapSlot[c][s].state != RTU_SWAP_FREE)
+            {
+                rtu_release_nodes(&this->swapSlot[c][s].list);
+                this->swapSlot[c][s].state = RTU_SWAP_FREE;
+            }
+        }
+        this->swapNew[c] = NULL;
+    }
+    this->swapPending = false;
+#endif
+    memset(&this->discreteImage, 0, sizeof(this->discreteImage));
+    memset(this->fifos, 0, sizeof(this->fifos));
+    this->files = NULL;
+    this->fileNum = 0;
+
+    memset(this->funcSlot, 0, sizeof(this->funcSlot));
+    memset(this->userFuncs, 0, sizeof(this->userFuncs));
+
+#if RTU_MONITOR_ENABLE
+    this->mon.mode = RTU_MONITOR_OFF;
+    this->mon.head = 0;
+    this->mon.tail = 0;
+    this->mon.dropped = 0;
+#endif
+
+#if RTU_SHM_ENABLE
+    RTUSlave_ShmDetach();
+#endif
+
+    this->g_frame.ready = false;
+    this->g_frame.len = 0;
+}
+
+/* Registration APIs */
+RTU_Sta_t RTUSlave_RegisterCoils(RTU_RegisterMap_t *Map, size_t regNum)
+{
+#if RTU_COILS_ENABLE
+    return rtu_register_list(&this->coils, Map, regNum, RTU_MAX_COILS, false);
+#else
+    (void)Map;
+    (void)regNum;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RegisterHoldReg(RTU_RegisterMap_t *Map, size_t regNum)
+{
+#if RTU_HOLD_REGS_ENABLE
+    return rtu_register_list(&this->holdingRegs, Map, regNum, RTU_MAX_HOLD_REGS, false);
+#else
+    (void)Map;
+    (void)regNum;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RegisterInputReg(RTU_RegisterMap_t *Map, size_t regNum)
+{
+#if RTU_INPUT_REGS_ENABLE
+    /* nodes get read-only permission; the caller's map is left untouched */
+    return rtu_register_list(&this->inputRegs, Map, regNum, RTU_MAX_INPUT_REGS, true);
+#else
+    (void)Map;
+    (void)regNum;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RegisterDiscreteInput(RTU_RegisterMap_t *Map, size_t regNum)
+{
+#if RTU_DISCRETE_INPUTS_ENABLE
+    return rtu_register_list(&this->discreteInputs, Map, regNum, RTU_MAX_DISCRETE_INPUTS, true);
+#else
+    (void)Map;
+    (void)regNum;
+    return RTU_ERR;
+#endif
+}
+
+static RTU_RegList_t *rtu_class_list(RTU_RegClass_t cls)
+{
+    switch (cls)
+    {
+#if RTU_COILS_ENABLE
+    case RTU_CLASS_COILS:
+        return &this->coils;
+#endif
+#if RTU_DISCRETE_INPUTS_ENABLE
+    case RTU_CLASS_DISCRETE_INPUTS:
+        return &this->discreteInputs;
+#endif
+#if RTU_HOLD_REGS_ENABLE
+    case RTU_CLASS_HOLDING_REGS:
+        return &this->holdingRegs;
+#endif
+#if RTU_INPUT_REGS_ENABLE
+    case RTU_CLASS_INPUT_REGS:
+        return &this->inputRegs;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+RTU_Sta_t RTUSlave_RegisterTable(RTU_RegClass_t cls, const RTU_Register_t *table, size_t regNum)
+{
+    RTU_RegList_t *list = rtu_class_list(cls);
+    if (list == NULL || table == NULL || regNum == 0)
+        return RTU_ERR;
+
+#if RTU_DIRTY_TRACKING
+    RTU_DirtySet_t *set = rtu_dirty_set(list);
+    if (set != NULL && regNum > set->capacity)
+        return RTU_ERR;
+#endif
+
+    /* must be strictly ascending (typed values not overlapping) and chained in array order */
+    for (size_t i = 0; i < regNum; i++)
+    {
+        const RTU_Register_t *expect_next = (i + 1 < regNum) ? &table[i + 1] : NULL;
+        if (table[i].next != expect_next)
+            return RTU_ERR;
+        if (i > 0 && (uint32_t)table[i].address < (uint32_t)table[i - 1].address + RTU_NODE_WORDS(&table[i - 1]))
+            return RTU_ERR;
+#if RTU_TYPED_REGS
+        if (!rtu_type_valid(list, table[i].type, table[i].address))
+            return RTU_ERR;
+#endif
+    }
+
+    /* the table is only ever read; const is dropped to share the node type */
+    RTU_RegList_t served = {.head = (RTU_Register_t *)table, .num = regNum, .sorted = true, .owner = RTU_MEM_CALLER};
+
+#if RTU_HOT_SWAP
+    size_t c = rtu_swap_class(list);
+    RTU_Sta_t ret = RTU_ERR;
+
+    rtu_swap_lock();
+    RTU_SwapSlot_t *slot = rtu_swap_slot(c);
+    if (slot != NULL)
+    {
+        slot->list = served;
+        rtu_swap_publish(c, slot);
+        ret = RTU_OK;
+    }
+    RTU_UNLOCK(&this->arenaLock);
+
+    return ret;
+#else
+    rtufree_register_list(list);
+    *list = served;
+
+    return RTU_OK;
+#endif
+}
+
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS && RTU_HOT_SWAP
+/* edit the newest map: adopt what other threads published, keep them out meanwhile */
+#define RTU_DYN_BEGIN() (rtu_swap_lock(), rtu_swap_take())
+#define RTU_DYN_END() RTU_UNLOCK(&this->arenaLock)
+#else
+#define RTU_DYN_BEGIN() ((void)0)
+#define RTU_DYN_END() ((void)0)
+#endif
+
+RTU_Sta_t RTUSlave_InsertRegs(RTU_RegClass_t cls, const RTU_RegisterMap_t *Map, size_t regNum)
+{
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS
+    RTU_RegList_t *list = rtu_class_list(cls);
+    if (list == NULL || Map == NULL || regNum == 0)
+        return RTU_ERR;
+
+    RTU_DYN_BEGIN();
+    RTU_Sta_t ret = rtu_dyn_insert(list, Map, regNum);
+    RTU_DYN_END();
+    return ret;
+#else
+    (void)cls;
+    (void)Map;
+    (void)regNum;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RemoveRegs(RTU_RegClass_t cls, uint16_t startAddr, uint16_t count)
+{
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS
+    RTU_RegList_t *list = rtu_class_list(cls);
+    if (list == NULL || count == 0)
+        return RTU_ERR;
+
+    RTU_DYN_BEGIN();
+    RTU_Sta_t ret = rtu_dyn_remove_range(list, startAddr, count);
+    RTU_DYN_END();
+    return ret;
+#else
+    (void)cls;
+    (void)startAddr;
+    (void)count;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RebindRegs(RTU_RegClass_t cls, const RTU_RegisterMap_t *Map, size_t regNum)
+{
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS
+    RTU_RegList_t *list = rtu_class_list(cls);
+    if (list == NULL || Map == NULL || regNum == 0)
+        return RTU_ERR;
+
+    RTU_DYN_BEGIN();
+    RTU_Sta_t ret = rtu_dyn_rebind(list, Map, regNum);
+    RTU_DYN_END();
+    return ret;
+#else
+    (void)cls;
+    (void)Map;
+    (void)regNum;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RegisterDiscreteBitmap(uint16_t startAddr, uint16_t count, const uint8_t *bitmap)
+{
+#if RTU_DISCRETE_INPUTS_ENABLE
+    if (bitmap == NULL || count == 0 || (uint32_t)startAddr + count > 0x10000UL)
+        return RTU_ERR;
+
+    this->discreteImage.bits = NULL;
+    this->discreteImage.start = startAddr;
+    this->discreteImage.count = count;
+    this->discreteImage.bits = bitmap;
+
+    return RTU_OK;
+#else
+    (void)startAddr;
+    (void)count;
+    (void)bitmap;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_PublishDiscreteBitmap(const uint8_t *bitmap)
+{
+    if (bitmap == NULL || this->discreteImage.bits == NULL)
+        return RTU_ERR;
+
+    RTU_STORE_RELEASE(&this->discreteImage.bits, bitmap); // contents visible before the pointer
+    return RTU_OK;
+}
+
+RTU_Sta_t RTUSlave_RegisterFifo(RTU_Fifo_t *fifo, uint16_t addr)
+{
+#if RTU_FIFO_ENABLE
+    if (fifo == NULL)
+        return RTU_ERR;
+
+    size_t slot = RTU_MAX_FIFOS;
+    for (size_t i = 0; i < RTU_MAX_FIFOS; i++)
+    {
+        if (this->fifos[i] != NULL && this->fifos[i]->address == addr)
+        {
+            slot = i; // replace queue with same address
+            break;
+        }
+        if (this->fifos[i] == NULL && slot == RTU_MAX_FIFOS)
+            slot = i;
+    }
+
+    if (slot == RTU_MAX_FIFOS)
+        return RTU_ERR;
+
+    fifo->address = addr;
+    fifo->head = 0;
+    fifo->tail = 0;
+    fifo->dropped = 0;
+    this->fifos[slot] = fifo;
+
+    return RTU_OK;
+#else
+    (void)fifo;
+    (void)addr;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_FifoPush(RTU_Fifo_t *fifo, uint16_t value)
+{
+    if (fifo == NULL)
+        return RTU_ERR;
+
+    uint16_t head = fifo->head;
+    uint16_t tail = RTU_LOAD_ACQUIRE(&fifo->tail);
+    if ((uint16_t)(head - tail) >= RTU_FIFO_DEPTH)
+    {
+        fifo->dropped++;
+        return RTU_ERR;
+    }
+
+    fifo->buf[head & (RTU_FIFO_DEPTH - 1U)] = value;
+    RTU_STORE_RELEASE(&fifo->head, (uint16_t)(head + 1U)); // publish after the value
+    return RTU_OK;
+}
+
+RTU_Sta_t RTUSlave_RegisterFileRecord(RTU_FileRecordMap_t *Map, size_t fileNum)
+{
+#if RTU_FILE_RECORD_ENABLE
+    if (Map == NULL || fileNum == 0 || fileNum > RTU_MAX_FILES)
+        return RTU_ERR;
+
+    for (size_t i = 0; i < fileNum; i++)
+    {
+        if (Map[i].file == 0 || Map[i].records == 0 || Map[i].records > RTU_FILE_MAX_RECORD + 1U)
+            return RTU_ERR;
+        if (Map[i].data == NULL && Map[i].callback == NULL)
+            return RTU_ERR;
+    }
+
+    this->files = Map;
+    this->fileNum = fileNum;
+
+    return RTU_OK;
+#else
+    (void)Map;
+    (void)fileNum;
+    return RTU_ERR;
+#endif
+}
+
+void RTUSlave_GroupWriteBegin(RTU_RegGroup_t *group)
+{
+    group->seq = group->seq | 1u; // odd: readers retry (stays odd after a writer died mid-update)
+    RTU_FENCE_RELEASE();
+}
+
+void RTUSlave_GroupWriteEnd(RTU_RegGroup_t *group)
+{
+    RTU_STORE_RELEASE(&group->seq, group->seq + 1u); // even: snapshot complete
+    RTU_VERSION_TOUCH(&this->holdingRegs); // the group's class is unknown
+    RTU_VERSION_TOUCH(&this->inputRegs);
+}
+
+RTU_Sta_t RTUSlave_RegisterFuncHandler(uint8_t func, RTUSlave_FuncHandler_t handler)
+{
+    if (func == 0 || func >= 0x80)
+        return RTU_ERR;
+
+    /* re-registering a code reuses its slot */
+    if (this->funcSlot[func] != 0)
+    {
+        this->userFuncs[this->funcSlot[func] - 1] = handler;
+        return RTU_OK;
+    }
+
+    if (handler == NULL)
+        return RTU_OK;
+
+    for (size_t i = 0; i < RTU_MAX_USER_FUNCS; i++)
+    {
+        bool used = false;
+        for (size_t f = 1; f < 0x80 && !used; f++)
+            used = (this->funcSlot[f] == i + 1);
+
+        if (!used)
+        {
+            this->userFuncs[i] = handler;
+            this->funcSlot[func] = (uint8_t)(i + 1);
+            return RTU_OK;
+        }
+    }
+
+    return RTU_ERR;
+}
+
+size_t RTUSlave_FetchDirty(RTU_RegClass_t cls, uint16_t *addrs, size_t max)
+{
+#if RTU_DIRTY_TRACKING
+    RTU_SWAP_ADOPT(); // queued indices belong to the map being served
+
+    RTU_RegList_t *list = rtu_class_list(cls);
+    RTU_DirtySet_t *set = (list != NULL) ? rtu_dirty_set(list) : NULL;
+    if (set == NULL || addrs == NULL)
+        return 0;
+
+    size_t n = 0;
+    while (n < max && set->count > 0)
+    {
+        uint16_t idx = set->queue[--set->count];
+        set->mark[idx >> 5] &= ~(1UL << (idx & 31U));
+        addrs[n++] = list->head[idx].address;
+    }
+    return n;
+#else
+    (void)cls;
+    (void)addrs;
+    (void)max;
+    return 0;
+#endif
+}
+
+RTU_Sta_t RTUSlave_CompletePending(void)
+{
+#if RTU_PENDING_MAX
+    RTU_Sta_t ret = RTU_NOACTIVE;
+    for (uint8_t i = 0; i < RTU_PENDING_MAX; i++)
+    {
+        if (this->pending[i].state == RTU_PEND_WAIT)
+        {
+            this->pending[i].state = RTU_PEND_READY;
+            ret = RTU_OK;
+        }
+    }
+    return ret;
+#else
+    return RTU_ERR;
+#endif
+}
+
+size_t RTUSlave_PendingCount(void)
+{
+#if RTU_PENDING_MAX
+    size_t n = 0;
+    for (uint8_t i = 0; i < RTU_PENDING_MAX; i++)
+        n += (this->pending[i].state != RTU_PEND_FREE);
+    return n;
+#else
+    return 0;
+#endif
+}
+
+RTU_Sta_t RTUSlave_PersistOpen(const char *path)
+{
+#if RTU_PERSIST_ENABLE
+    RTU_SWAP_ADOPT(); // the store follows the map being served
+
+    RTU_Persist_t *p = &this->persist;
+    if (path == NULL || p->map != NULL || this->holdingRegs.num == 0)
+        return RTU_ERR;
+
+    uint32_t layout;
+    size_t words = rtu_persist_layout(&layout);
+
+    p->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (p->fd < 0)
+        return RTU_ERR;
+
+    bool fresh;
+    if (rtu_persist_map(words, &fresh) != RTU_OK)
+    {
+        close(p->fd);
+        memset(p, 0, sizeof(*p));
+        return RTU_ERR;
+    }
+
+    /* newest checkpoint with a valid checksum, if the file matches this map */
+    rtu_persist_hdr_t *hdr = (rtu_persist_hdr_t *)p->map;
+    int best = -1;
+    if (!fresh && hdr->magic == RTU_PERSIST_MAGIC && hdr->format == RTU_PERSIST_FORMAT &&
+        hdr->words == words && hdr->layout == layout)
+    {
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            rtu_persist_slot_t *slot = rtu_persist_slot(i);
+            if (slot->sum != rtu_persist_sum(slot, words))
+                continue;
+            if (best < 0 || (int32_t)(slot->seq - rtu_persist_slot((uint8_t)best)->seq) > 0)
+                best = i;
+        }
+    }
+
+    if (best < 0)
+    {
+        /* new file or changed map: start from the current values */
+        if (rtu_persist_start(layout) != RTU_OK)
+            return RTU_ERR;
+    }
+    else
+    {
+        /* restore straight from the mapping, callbacks are not run */
+        rtu_persist_slot_t *slot = rtu_persist_slot((uint8_t)best);
+        const uint16_t *img = (const uint16_t *)(slot + 1);
+        for (const RTU_Register_t *node = rtu_first_node(&this->holdingRegs); node != NULL; node = node->next)
+        {
+            uint16_t n = RTU_NODE_WORDS(node);
+            if (node->value != NULL)
+                memcpy(node->value, img, n * sizeof(uint16_t));
+            img += n;
+        }
+        p->seq = slot->seq;
+        p->active = (uint8_t)best;
+        p->unsynced = false;
+        RTU_VERSION_TOUCH(&this->holdingRegs);
+        p->savedVersion = this->holdVersion;
+        p->waiting = false;
+    }
+
+    return RTU_OK;
+#else
+    (void)path;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_PersistFlush(void)
+{
+#if RTU_PERSIST_ENABLE
+    if (this->persist.map == NULL)
+        return RTU_ERR;
+    if (this->holdVersion == this->persist.savedVersion)
+        return this->persist.unsynced ? rtu_persist_settle() : RTU_NOACTIVE;
+
+    return rtu_persist_checkpoint(MS_SYNC);
+#else
+    return RTU_ERR;
+#endif
+}
+
+void RTUSlave_PersistClose(void)
+{
+#if RTU_PERSIST_ENABLE
+    rtu_persist_close();
+#endif
+}
+
+RTU_ShmImage_t *RTUSlave_ShmAttach(const char *name, size_t blocks)
+{
+#if RTU_SHM_ENABLE
+    if (name == NULL || this->shm != NULL || blocks > 0xFFFFU)
+        return NULL;
+
+    int fd = shm_open(name, O_RDWR | (blocks != 0 ? O_CREAT : 0), 0660);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    /* blocks != 0 creates the image, or attaches to one of exactly that geometry */
+    bool fresh = (blocks != 0 && st.st_size == 0);
+    size_t size = (blocks != 0) ? sizeof(RTU_ShmImage_t) + blocks * sizeof(RTU_ShmBlock_t) : (size_t)st.st_size;
+    if ((fresh && ftruncate(fd, (off_t)size) != 0) || (!fresh && (size_t)st.st_size != size) ||
+        size < sizeof(RTU_ShmImage_t))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    RTU_ShmImage_t *img = (RTU_ShmImage_t *)map;
+    if (fresh)
+    {
+        /* ftruncate zero-filled the blocks: every seqlock starts even */
+        img->format = RTU_SHM_FORMAT;
+        img->blocks = (uint32_t)blocks;
+        img->blockRegs = RTU_SHM_BLOCK_REGS;
+        RTU_STORE_RELEASE(&img->magic, RTU_SHM_MAGIC);
+    }
+    else if (RTU_LOAD_ACQUIRE(&img->magic) != RTU_SHM_MAGIC || img->format != RTU_SHM_FORMAT ||
+             img->blockRegs != RTU_SHM_BLOCK_REGS ||
+             size != sizeof(RTU_ShmImage_t) + (size_t)img->blocks * sizeof(RTU_ShmBlock_t))
+    {
+        munmap(map, size);
+        return NULL;
+    }
+
+    this->shm = img;
+    this->shmSize = size;
+    return img;
+#else
+    (void)name;
+    (void)blocks;
+    return NULL;
+#endif
+}
+
+void RTUSlave_ShmDetach(void)
+{
+#if RTU_SHM_ENABLE
+    if (this->shm == NULL)
+        return;
+
+    munmap(this->shm, this->shmSize);
+    this->shm = NULL;
+    this->shmSize = 0;
+#endif
+}
+
+RTU_Sta_t RTUSlave_ShmFillMap(RTU_RegisterMap_t *Map, size_t regNum, uint16_t startAddr, size_t firstReg, RTU_Permiss_t permiss)
+{
+#if RTU_SHM_ENABLE
+    RTU_ShmImage_t *img = this->shm;
+    if (img == NULL || Map == NULL || regNum == 0 || (size_t)startAddr + regNum - 1U > 0xFFFFU ||
+        firstReg + regNum > (size_t)img->blocks * RTU_SHM_BLOCK_REGS)
+        return RTU_ERR;
+
+    for (size_t i = 0; i < regNum; i++)
+    {
+        RTU_ShmBlock_t *blk = RTU_SHM_BLOCK(img, (firstReg + i) / RTU_SHM_BLOCK_REGS);
+        memset(&Map[i], 0, sizeof(Map[i]));
+        Map[i].addr = (uint16_t)(startAddr + i);
+        Map[i].permiss = permiss;
+        Map[i].data = &blk->regs[(firstReg + i) % RTU_SHM_BLOCK_REGS];
+        Map[i].group = &blk->group;
+    }
+    return RTU_OK;
+#else
+    (void)Map;
+    (void)regNum;
+    (void)startAddr;
+    (void)firstReg;
+    (void)permiss;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_ShmReadBlock(size_t block, uint16_t *out)
+{
+#if RTU_SHM_ENABLE
+    if (this->shm == NULL || out == NULL || block >= this->shm->blocks)
+        return RTU_ERR;
+
+    RTU_ShmBlock_t *blk = RTU_SHM_BLOCK(this->shm, block);
+    for (uint8_t attempt = 0; attempt < RTU_SEQLOCK_RETRIES; attempt++)
+    {
+        uint32_t seq = RTU_LOAD_ACQUIRE(&blk->group.seq);
+        if (seq & 1u)
+            continue;
+
+        for (size_t i = 0; i < RTU_SHM_BLOCK_REGS; i++)
+            out[i] = *(volatile uint16_t *)&blk->regs[i];
+
+        RTU_FENCE_ACQUIRE();
+        if (blk->group.seq == seq)
+            return RTU_OK;
+    }
+    return RTU_NOACTIVE;
+#else
+    (void)block;
+    (void)out;
+    return RTU_ERR;
+#endif
+}
+
+RTU_Sta_t RTUSlave_RegsChanged(RTU_RegClass_t cls)
+{
+    RTU_RegList_t *list = rtu_class_list(cls);
+    if (list == NULL)
+        return RTU_ERR;
+
+    RTU_VERSION_TOUCH(list);
+    return RTU_OK;
+}
+
+RTU_Sta_t RTUSlave_SetMonitor(RTU_MonitorMode_t mode)
+{
+#if RTU_MONITOR_ENABLE
+    if (mode != RTU_MONITOR_OFF && mode != RTU_MONITOR_PASSIVE && mode != RTU_MONITOR_PROMISC)
+        return RTU_ERR;
+
+    this->mon.mode = mode;
+    return RTU_OK;
+#else
+    (void)mode;
+    return RTU_ERR;
+#endif
+}
+
+size_t RTUSlave_MonitorRead(uint8_t *out, size_t max)
+{
+#if RTU_MONITOR_ENABLE
+    if (out == NULL)
+        return 0;
+
+    RTU_Monitor_t *mon = &this->mon;
+    uint32_t tail = mon->tail;
+    uint32_t head = RTU_LOAD_ACQUIRE(&mon->head);
+    size_t copied = 0;
+
+    while (head - tail >= RTU_MON_HDR_SIZE)
+    {
+        uint8_t hdr[RTU_MON_HDR_SIZE];
+        rtu_mon_get(tail, hdr, RTU_MON_HDR_SIZE);
+
+        size_t rec = RTU_MON_HDR_SIZE + ((size_t)hdr[2] | ((size_t)hdr[3] << 8));
+        if (rec > max - copied)
+            break;
+
+        rtu_mon_get(tail, &out[copied], rec);
+        copied += rec;
+        tail += (uint32_t)rec;
+    }
+
+    RTU_STORE_RELEASE(&mon->tail, tail); // release the space after copying
+    return copied;
+#else
+    (void)out;
+    (void)max;
+    return 0;
+#endif
+}
+
+uint32_t RTUSlave_MonitorDropped(void)
+{
+#if RTU_MONITOR_ENABLE
+    return this->mon.dropped;
+#else
+    return 0;
+#endif
+}
+
+/* Receive callback: only copy bytes into internal buffer and mark ready.
+ * IMPORTANT: This function does NOT parse or respond; parsing happens in TimerHandler().
+ *
+ * If incoming len > buf_size, the data is truncated and frame_ready becomes true.
+ *
+ * Concurrency note:
+ * - Current implementation uses volatile g_frame flags. If ReceiveCallback is called
+ *   from ISR and TimerHandler runs in task, it's acceptable in many embedded targets.
+ * - For strict atomicity you may disable interrupts around ReceiveCallback or use
+ *   a small mutex/critical section.
+ */
+void RTUSlave_ReceiveCallback(uint8_t *data, size_t len)
+{
+    if (data == NULL || len == 0 || len > sizeof(this->buf))
+        return;
+
+    size_t copy_len = len;
+    if (copy_len > sizeof(this->buf))
+        copy_len = sizeof(this->buf);
+
+    /* copy first, then publish length+ready */
+    memcpy(this->buf, data, copy_len);
+#if RTU_MONITOR_ENABLE
+    if (this->mon.mode != RTU_MONITOR_OFF)
+        this->g_frame.time = RTU_MonitorTime();
+#endif
+    this->g_frame.len = copy_len;
+    this->g_frame.ready = true;
+}
+
+#if RTU_NEED_FIND_NODE
+/* Helper: find node with address in a register class.
+ * Sorted lists are binary searched; unsorted maps are walked. */
+static RTU_Register_t *rtu_find_node(const RTU_RegList_t *list, uint16_t addr)
+{
+#if RTU_DYNAMIC_REGS && RTU_NEED_REG_LISTS
+    if (list->capacity != 0)
+    {
+        uint16_t slot = rtu_dyn_near(list, addr, true);
+        return (slot != RTU_DYN_NIL && list->head[slot].address == addr) ? &list->head[slot] : NULL;
+    }
+#endif
+
+    if (list->sorted)
+    {
+        size_t lo = 0;
+        size_t hi = list->num;
+        while (lo < hi)
+        {
+            size_t mid = lo + ((hi - lo) >> 1);
+            if (list->head[mid].address < addr)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return (lo < list->num && list->head[lo].address == addr) ? &list->head[lo] : NULL;
+    }
+
+    RTU_Register_t *cur = list->head;
+    while (cur)
+    {
+        if (cur->address == addr)
+            return cur;
+        cur = cur->next;
+    }
+    return NULL;
+}
+#endif
+
+#if RTU_NEED_READ_REGS
+/* Seqlock reader side: begin fails while a writer is active, end fails if one ran meanwhile */
+static bool rtu_group_read_begin(RTU_RegGroup_t *group, uint32_t *seq)
+{
+    *seq = RTU_LOAD_ACQUIRE(&group->seq);
+    return (*seq & 1u) == 0;
+}
+#endif
+
+#if RTU_NEED_READ_REGS
+static bool rtu_group_read_end(RTU_RegGroup_t *group, uint32_t seq)
+{
+    RTU_FENCE_ACQUIRE();
+    return group->seq == seq;
+}
+#endif
+
+#if RTU_TYPED_REGS && (RTU_NEED_READ_REGS || RTU_NEED_WRITE_REGS)
+/* Helper: current value of a typed node as raw bits (float/double bit pattern) */
+static uint64_t rtu_typed_load(const RTU_Register_t *node, uint16_t words)
+{
+    if (words == 2)
+    {
+        uint32_t v32;
+        memcpy(&v32, node->value, sizeof(v32));
+        return v32;
+    }
+
+    uint64_t v64;
+    memcpy(&v64, node->value, sizeof(v64));
+    return v64;
+}
+
+#if RTU_NEED_WRITE_REGS
+static void rtu_typed_store(const RTU_Register_t *node, uint16_t words, uint64_t bits)
+{
+    if (words == 2)
+    {
+        uint32_t v32 = (uint32_t)bits;
+        memcpy(node->value, &v32, sizeof(v32));
+    }
+    else
+    {
+        memcpy(node->value, &bits, sizeof(bits));
+    }
+}
+
+#endif
+
+#if RTU_NEED_READ_REGS
+/* Helper: raw bits -> registers on the wire, in the node's word order */
+static void rtu_typed_encode(uint8_t type, uint16_t words, uint64_t bits, uint8_t *out)
+{
+    uint8_t order = type >> 4;
+    bool reverse = (order == RTU_ORDER_CDAB || order == RTU_ORDER_DCBA);
+    bool swap = (order == RTU_ORDER_BADC || order == RTU_ORDER_DCBA);
+
+    for (uint16_t k = 0; k < words; k++)
+    {
+        uint16_t w = (uint16_t)(bits >> (16U * (words - 1U - k))); // most significant first
+        uint8_t *dst = &out[(size_t)(reverse ? (words - 1U - k) : k) * 2];
+        dst[0] = swap ? (uint8_t)(w & 0xFF) : (uint8_t)(w >> 8);
+        dst[1] = swap ? (uint8_t)(w >> 8) : (uint8_t)(w & 0xFF);
+    }
+}
+
+#endif
+
+/* Helper: registers on the wire -> raw bits */
+static uint64_t rtu_typed_decode(uint8_t type, uint16_t words, const uint8_t *in)
+{
+    uint8_t order = type >> 4;
+    bool reverse = (order == RTU_ORDER_CDAB || order == RTU_ORDER_DCBA);
+    bool swap = (order == RTU_ORDER_BADC || order == RTU_ORDER_DCBA);
+    uint64_t bits = 0;
+
+    for (uint16_t k = 0; k < words; k++)
+    {
+        const uint8_t *src = &in[(size_t)(reverse ? (words - 1U - k) : k) * 2];
+        uint16_t w = swap ? (uint16_t)(((uint16_t)src[1] << 8) | src[0]) : (uint16_t)(((uint16_t)src[0] << 8) | src[1]);
+        bits = (bits << 16) | w;
+    }
+    return bits;
+}
+#endif
+
+#if RTU_NEED_READ_REGS && RTU_SIMD_ENABLE
+/* Helper: length (at most max) of the array-backed register run starting at
+ * node: single-word registers at consecutive addresses whose values are
+ * consecutive uint16_t of one array, all in node's seqlock group. *last gets
+ * the run's last node; callbacks and shared values are or-ed into the flags. */
+static uint16_t rtu_reg_run(RTU_Register_t *node, uint16_t max, RTU_Register_t **last, bool *has_callback, bool *shared)
+{
+    uint16_t len = 1;
+    *has_callback |= (node->callback != NULL);
+    *shared |= RTU_SHM_OWNS(node->value);
+
+    for (RTU_Register_t *next = node->next; len < max && next != NULL; next = next->next, len++)
+    {
+        if (next->address != node->address + 1 || next->value != (uint16_t *)node->value + 1 ||
+            next->group != node->group || RTU_NODE_WORDS(next) != 1)
+            break;
+
+        node = next;
+        *has_callback |= (node->callback != NULL);
+        *shared |= RTU_SHM_OWNS(node->value);
+    }
+
+    *last = node;
+    return len;
+}
+#endif
+
+#if RTU_NEED_READ_REGS
+/* Helper: encode num contiguous registers starting at addr into out (big-endian).
+ * Registers of a seqlock group are copied as one snapshot (retried while the
+ * group is updated); read callbacks run afterwards, *hooked (optional) tells
+ * whether there were any or a value came from the shared image, i.e. whether
+ * the response must not be cached. Returns RTU_EX_NONE on success. */
+static RTU_ExceptionCode_t rtu_read_regs(const RTU_RegList_t *list, uint16_t addr, uint16_t num, uint8_t *out, bool *hooked)
+{
+    RTU_Ctx_t rtu_ctx = {0};
+    RTU_Register_t *first = rtu_find_node(list, addr);
+    if (first == NULL)
+        return RTU_EX_ILLEGAL_ADDR;
+
+    bool has_callback = false;
+    bool shared = false;
+    bool torn = true;
+    for (uint8_t attempt = 0; torn; attempt++)
+    {
+        if (attempt >= RTU_SEQLOCK_RETRIES)
+            return RTU_EX_SLAVE_BUSY;
+
+        RTU_Register_t *node = first;
+        RTU_RegGroup_t *group = NULL;
+        uint32_t seq = 0;
+        torn = false;
+
+        for (uint16_t i = 0, words = 1; i < num; i += words)
+        {
+            uint16_t expect_addr = addr + i;
+            if (node == NULL || node->address != expect_addr)
+                return RTU_EX_ILLEGAL_VALUE;
+
+            if (node->value == NULL)
+                return RTU_EX_SLAVE_FAILURE;
+
+            words = RTU_NODE_WORDS(node);
+            if (words > num - i)
+                return RTU_EX_ILLEGAL_ADDR; // would end inside a typed value
+
+            if (node->group != group)
+            {
+                if ((group != NULL && !rtu_group_read_end(group, seq)) ||
+                    (node->group != NULL && !rtu_group_read_begin(node->group, &seq)))
+                {
+                    torn = true;
+                    break;
+                }
+                group = node->group;
+            }
+
+#if RTU_SIMD_ENABLE
+            if (words == 1)
+            {
+                /* array-backed run: one byte-swap copy instead of a node at a time */
+                RTU_Register_t *last = node;
+                words = rtu_reg_run(node, num - i, &last, &has_callback, &shared);
+                RTUKernel_BswapStore16(&out[(size_t)i * 2], (const uint16_t *)node->value, words);
+                node = last->next;
+                continue;
+            }
+#endif
+
+#if RTU_TYPED_REGS
+            if (words > 1)
+            {
+                rtu_typed_encode(node->type, words, rtu_typed_load(node, words), &out[(size_t)i * 2]);
+            }
+            else
+#endif
+            {
+                uint16_t val = *((volatile uint16_t *)node->value);
+                out[(size_t)i * 2 + 0] = (uint8_t)((val >> 8) & 0xFF);
+                out[(size_t)i * 2 + 1] = (uint8_t)(val & 0xFF);
+            }
+
+            has_callback |= (node->callback != NULL);
+            shared |= RTU_SHM_OWNS(node->value);
+            node = node->next;
+        }
+
+        if (!torn && group != NULL && !rtu_group_read_end(group, seq))
+            torn = true;
+    }
+
+    if (hooked != NULL)
+        *hooked = has_callback || shared;
+    if (!has_callback)
+        return RTU_EX_NONE;
+
+    RTU_Register_t *node = first;
+    for (uint16_t i = 0; i < num; i += RTU_NODE_WORDS(node), node = node->next)
+    {
+        if (node->callback == NULL)
+            continue;
+
+        rtu_ctx.addr = node->address;
+        rtu_ctx.op = RTU_RW_READ;
+        rtu_ctx.value = ((uint16_t)out[(size_t)i * 2] << 8) | out[(size_t)i * 2 + 1];
+#if RTU_TYPED_REGS
+        rtu_ctx.wide = rtu_typed_decode(node->type, RTU_NODE_WORDS(node), &out[(size_t)i * 2]);
+#endif
+        RTU_ExceptionCode_t ex = node->callback(&rtu_ctx);
+        if (ex != RTU_EX_NONE)
+            return ex;
+    }
+
+    return RTU_EX_NONE;
+}
+#endif
+
+#if RTU_RESP_CACHE_SIZE && (RTU_FC_READ_HOLD_REGS_ENABLE || RTU_FC_READ_INPUT_REGS_ENABLE)
+/* Helper: answer a read from the cache, false when not cached or stale */
+static bool rtu_cache_reply(uint8_t func, uint16_t addr, uint16_t num, uint32_t version)
+{
+    for (uint8_t i = 0; i < RTU_RESP_CACHE_SIZE; i++)
+    {
+        const RTU_RespCache_t *c = &this->respCache[i];
+        if (c->func == func && c->addr == addr && c->num == num && c->version == version)
+        {
+            rtu_reply((uint8_t *)c->frame, 5U + (size_t)num * 2U);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Helper: keep the response just built in buf, replacing the same request or the oldest entry */
+static void rtu_cache_store(uint8_t func, uint16_t addr, uint16_t num, uint32_t version)
+{
+    if (num > RTU_RESP_CACHE_REGS)
+        return;
+
+    RTU_RespCache_t *c = NULL;
+    for (uint8_t i = 0; i < RTU_RESP_CACHE_SIZE && c == NULL; i++)
+    {
+        if (this->respCache[i].func == func && this->respCache[i].addr == addr && this->respCache[i].num == num)
+            c = &this->respCache[i];
+    }
+
+    if (c == NULL)
+    {
+        c = &this->respCache[this->respCacheNext];
+        this->respCacheNext = (uint8_t)((this->respCacheNext + 1U) % RTU_RESP_CACHE_SIZE);
+    }
+
+    c->func = func;
+    c->addr = addr;
+    c->num = num;
+    c->version = version;
+    memcpy(c->frame, this->buf, 5U + (size_t)num * 2U);
+}
+#endif
+
+#if RTU_NEED_WRITE_REGS
+/* Helper: write num contiguous registers starting at addr from big-endian data.
+ * Address continuity and permissions are checked for the whole block first;
+ * write callbacks run per register right before it is stored, or all before
+ * the first store with RTU_STAGED_WRITES. */
+static RTU_ExceptionCode_t rtu_write_regs(const RTU_RegList_t *list, uint16_t addr, uint16_t num, const uint8_t *data)
+{
+    RTU_Ctx_t rtu_ctx = {0};
+    RTU_Register_t *node = rtu_find_node(list, addr);
+    if (node == NULL)
+        return RTU_EX_ILLEGAL_ADDR;
+
+    /* check register's continuity and read write permiss */
+    RTU_Register_t *check = node;
+    for (uint16_t i = 0; i < num; i += RTU_NODE_WORDS(check), check = check->next)
+    {
+        uint16_t expect_addr = addr + i;
+        if (check == NULL || check->address != expect_addr || check->permiss == RTU_PERMISS_OR)
+            return RTU_EX_ILLEGAL_VALUE;
+        if (check->value == NULL)
+            return RTU_EX_SLAVE_FAILURE;
+        if (RTU_NODE_WORDS(check) > (uint32_t)(num - i))
+            return RTU_EX_ILLEGAL_ADDR; // would end inside a typed value
+    }
+
+#if RTU_STAGED_WRITES
+    /* stage: validate the whole block against the request data (the shadow
+     * copy) before anything is stored */
+    check = node;
+    for (uint16_t i = 0; i < num; i += RTU_NODE_WORDS(check), check = check->next)
+    {
+        if (check->callback != NULL)
+        {
+            rtu_ctx.addr = check->address;
+            rtu_ctx.op = RTU_RW_WRITE;
+            rtu_ctx.value = ((uint16_t)data[(size_t)i * 2] << 8) | data[(size_t)i * 2 + 1];
+#if RTU_TYPED_REGS
+            rtu_ctx.wide = rtu_typed_decode(check->type, RTU_NODE_WORDS(check), &data[(size_t)i * 2]);
+#endif
+            RTU_ExceptionCode_t ex = check->callback(&rtu_ctx);
+            if (ex != RTU_EX_NONE)
+                return ex;
+        }
+    }
+#endif
+
+    /* grouped registers are stored inside the group's seqlock */
+    RTU_RegGroup_t *group = NULL;
+    RTU_ExceptionCode_t ex = RTU_EX_NONE;
+    uint16_t stored = RTU_RESUME_FROM();
+    for (uint16_t i = 0, words = 1; i < num && ex == RTU_EX_NONE; i += words)
+    {
+        uint16_t value = ((uint16_t)data[(size_t)i * 2] << 8) | data[(size_t)i * 2 + 1];
+        words = RTU_NODE_WORDS(node);
+        if (i < stored)
+        {
+            node = node->next; // stored before the request was parked
+            continue;
+        }
+#if RTU_TYPED_REGS
+        uint64_t bits = (words > 1) ? rtu_typed_decode(node->type, words, &data[(size_t)i * 2]) : value;
+#endif
+
+#if !RTU_STAGED_WRITES
+        if (node->callback != NULL)
+        {
+            rtu_ctx.addr = node->address;
+            rtu_ctx.op = RTU_RW_WRITE;
+            rtu_ctx.value = value;
+#if RTU_TYPED_REGS
+            rtu_ctx.wide = bits;
+#endif
+            ex = node->callback(&rtu_ctx);
+            if (ex != RTU_EX_NONE)
+            {
+                RTU_RESUME_AT(i);
+                break;
+            }
+        }
+#endif
+
+        if (node->group != group)
+        {
+            if (group != NULL)
+                RTUSlave_GroupWriteEnd(group);
+            group = node->group;
+            if (group != NULL)
+                RTUSlave_GroupWriteBegin(group);
+        }
+
+#if RTU_TYPED_REGS
+        if (words > 1)
+        {
+            uint64_t old = rtu_typed_load(node, words);
+            rtu_typed_store(node, words, bits);
+            if (old != bits)
+                RTU_MARK_DIRTY(list, node);
+            node = node->next;
+            continue;
+        }
+#endif
+
+        volatile uint16_t *reg = (volatile uint16_t *)node->value;
+        uint16_t old = *reg;
+        *reg = value;
+        if (old != value)
+            RTU_MARK_DIRTY(list, node);
+        node = node->next;
+    }
+
+    if (group != NULL)
+        RTUSlave_GroupWriteEnd(group);
+
+    RTU_VERSION_TOUCH(list);
+    return ex;
+}
+#endif
+
+#if RTU_FILE_RECORD_ENABLE
+/* Helper: find file entry by file number */
+static RTU_FileRecordMap_t *rtu_find_file(uint16_t file)
+{
+    for (size_t i = 0; i < this->fileNum; i++)
+    {
+        if (this->files[i].file == file)
+            return &this->files[i];
+    }
+    return NULL;
+}
+#endif
+
+#if RTU_FILE_RECORD_ENABLE
+/* Helper: validate one file sub-request; returns RTU_EX_NONE when it can be served */
+static RTU_ExceptionCode_t rtu_check_file_subreq(const uint8_t *sub, RTU_FileRecordMap_t **filep)
+{
+    uint16_t file = ((uint16_t)sub[1] << 8) | sub[2];
+    uint16_t record = ((uint16_t)sub[3] << 8) | sub[4];
+    uint16_t len = ((uint16_t)sub[5] << 8) | sub[6];
+
+    if (sub[0] != RTU_FILE_REF_TYPE || len == 0)
+        return RTU_EX_ILLEGAL_VALUE;
+
+    RTU_FileRecordMap_t *f = rtu_find_file(file);
+    if (f == NULL || record > RTU_FILE_MAX_RECORD || (uint32_t)record + len > f->records)
+        return RTU_EX_ILLEGAL_ADDR;
+
+    *filep = f;
+    return RTU_EX_NONE;
+}
+#endif
+
+#if RTU_SIMD_ENABLE && (RTU_FC_READ_COILS_ENABLE || RTU_FC_READ_DISCRETE_INPUTS_ENABLE || \
+                        (RTU_FC_WRITE_MULTIPLE_COILS_ENABLE && !RTU_DIRTY_TRACKING))
+/* Helper: length (at most max) of the array-backed bit run starting at node:
+ * consecutive addresses whose values are consecutive bytes of one array. With
+ * plain set the run ends before the first node with a callback. *last gets
+ * the run's last node, *hooked whether any of them has a callback. */
+static uint16_t rtu_bit_run(RTU_Register_t *node, uint16_t max, bool plain, bool *hooked, RTU_Register_t **last)
+{
+    if (node->value == NULL || (plain && node->callback != NULL))
+        return 0;
+
+    uint16_t len = 1;
+    *hooked = (node->callback != NULL);
+    for (RTU_Register_t *next = node->next; len < max && next != NULL; next = next->next, len++)
+    {
+        if (next->address != node->address + 1 || next->value != (uint8_t *)node->value + 1 ||
+            (plain && next->callback != NULL))
+            break;
+
+        node = next;
+        *hooked |= (node->callback != NULL);
+    }
+
+    *last = node;
+    return len;
+}
+#endif
+
+#if RTU_SIMD_ENABLE && (RTU_FC_READ_COILS_ENABLE || RTU_FC_READ_DISCRETE_INPUTS_ENABLE)
+/* Helper: pack the array-backed run at *node (request bit i, byte aligned)
+ * into out with one kernel call, then run its read callbacks in address
+ * order. *run gets the bits done (0: unaligned or no run, go node by node)
+ * and *node moves past them. */
+static RTU_ExceptionCode_t rtu_pack_run(RTU_Register_t **node, uint16_t i, uint16_t max, uint8_t *out, uint16_t *run)
+{
+    bool hooked = false;
+    RTU_Register_t *last = NULL;
+    RTU_Ctx_t rtu_ctx = {0};
+
+    *run = ((i & 0x07) == 0) ? rtu_bit_run(*node, max, false, &hooked, &last) : 0;
+    if (*run == 0)
+        return RTU_EX_NONE;
+
+    RTUKernel_PackBits(&out[i >> 3], (const uint8_t *)(*node)->value, *run);
+
+    for (RTU_Register_t *n = *node; hooked && n != last->next; n = n->next, i++)
+    {
+        if (n->callback == NULL)
+            continue;
+
+        rtu_ctx.addr = n->address;
+        rtu_ctx.op = RTU_RW_READ;
+        rtu_ctx.value = (out[i >> 3] >> (i & 0x07)) & 0x01;
+        RTU_ExceptionCode_t ex = n->callback(&rtu_ctx);
+        if (ex != RTU_EX_NONE)
+            return ex;
+    }
 
-        for (uint16_t i = 0; i < reqNum; ++i)
-        {
-            uint16_t expect_addr = regAddr + i;
-            if (node == NULL || node->address != expect_addr)
-            {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_ERR;
-            }
+    *node = last->next;
+    return RTU_EX_NONE;
+}
+#endif
 
-            uint16_t val = 0;
-            if (node->value)
-            {
-                val = *((uint16_t *)node->value);
+#if RTU_FC_READ_COILS_ENABLE
+/* 0x01 Read Coils */
+static RTU_Sta_t rtu_fc_read_coils(uint8_t func, uint8_t *frame, size_t size)
+{
+    (void)frame;
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
+    RTU_Ctx_t rtu_ctx = {0};
+    size_t resp_len = 0;
+    (void)size;
 
-                if (node->callback != NULL)
-                {
-                    rtu_ctx.addr = node->address;
-                    rtu_ctx.op = RTU_RW_READ;
-                    rtu_ctx.value = val;
-                    CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
-                }
-            }
-            else
-            {
-                rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
-                return RTU_ERR;
-            }
+    if (reqNum == 0 || reqNum > 2000)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
 
-            size_t off = 3 + i * 2;
-            this->buf[off + 0] = (uint8_t)((val >> 8) & 0xFF);
-            this->buf[off + 1] = (uint8_t)(val & 0xFF);
+    size_t byte_count = (reqNum + 7) / 8;
+    size_t needed = 1 + 1 + 1 + byte_count + 2; /* id + func + bytecount + data + crc */
+    if (needed > sizeof(this->buf))
+    {
+        rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
+        return RTU_ERR;
+    }
 
-            node = node->next;
-        }
+    memset(this->buf, 0, sizeof(this->buf));
 
-        size_t crc_pos = 3 + byte_count;
-        uint16_t crc = CRC16(this->buf, crc_pos);
-        this->buf[crc_pos + 0] = (uint8_t)(crc & 0x00FF);
-        this->buf[crc_pos + 1] = (uint8_t)((crc >> 8) & 0x00FF);
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_READ_COILS;
+    this->buf[2] = (uint8_t)byte_count;
 
-        resp_len = crc_pos + 2;
-        RTU_Transmit(this->buf, resp_len);
-        ret = RTU_READ_HOLD_REG;
-        break;
+    RTU_Register_t *node = rtu_find_node(&this->coils, regAddr);
+    if (node == NULL)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+        return RTU_ERR;
     }
 
-    case RTU_FUNC_WRITE_SINGLE_REG: // write single register
+    for (uint16_t i = 0; i < reqNum; ++i)
     {
-        RTU_Register_t *node = rtu_find_node(this->holdingRegs, regAddr);
-        if (node == NULL)
+        uint16_t expect_addr = regAddr + i;
+        if (node == NULL || node->address != expect_addr)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
             return RTU_ERR;
         }
 
-        if (size < 8)
-            return RTU_ERR;
-
-        if (node->permiss == RTU_PERMISS_OR)
+#if RTU_SIMD_ENABLE
+        uint16_t run = 0;
+        CHECK_CALLBACK_EX(rtu_pack_run(&node, i, reqNum - i, &this->buf[3], &run));
+        if (run != 0)
         {
-            return RTU_PERMISS_ERR;
+            i += run - 1;
+            continue;
         }
-        uint16_t value = ((uint16_t)frame[4] << 8) | frame[5];
+#endif
+
+        uint8_t bit = 0;
         if (node->value)
         {
+            bit = ((*((uint8_t *)node->value)) != 0) ? 1u : 0u;
+
             if (node->callback != NULL)
             {
                 rtu_ctx.addr = node->address;
-                rtu_ctx.op = RTU_RW_WRITE;
-                rtu_ctx.value = value;
+                rtu_ctx.op = RTU_RW_READ;
+                rtu_ctx.value = bit;
                 CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
             }
-
-            *((uint16_t *)node->value) = value;
         }
         else
         {
@@ -478,182 +2865,538 @@ RTU_Sta_t RTUSlave_TimerHandler(void)
             return RTU_ERR;
         }
 
-        /* echo back request as response (per Modbus) */
-        RTU_Transmit(frame, size);
-        resp_len = size;
-        ret = RTU_WRITE_HOLD_REG;
-        break;
+        size_t byte_index = 3 + (i >> 3);
+        size_t bit_index = i & 0x07;
+        this->buf[byte_index] |= (uint8_t)(bit << bit_index);
+
+        node = node->next;
     }
 
-    case RTU_FUNC_MULTIPLE_WRITE_REG: // write mulitple hold register
+    size_t crc_pos = 3 + byte_count;
+    uint16_t crc = CRC16(this->buf, crc_pos);
+    this->buf[crc_pos + 0] = (uint8_t)(crc & 0x00FF);
+    this->buf[crc_pos + 1] = (uint8_t)((crc >> 8) & 0x00FF);
+
+    resp_len = crc_pos + 2;
+    rtu_reply(this->buf, resp_len);
+
+    return RTU_READ_COIL;
+}
+#endif
+
+#if RTU_FC_READ_HOLD_REGS_ENABLE
+/* 0x03 Read Holding Registers */
+static RTU_Sta_t rtu_fc_read_hold_regs(uint8_t func, uint8_t *frame, size_t size)
+{
+    (void)frame;
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
+    size_t resp_len = 0;
+    (void)size;
+
+    if (reqNum == 0 || reqNum > 125)
     {
-        RTU_Register_t *node = rtu_find_node(this->holdingRegs, regAddr);
-        RTU_Register_t *permiss = rtu_find_node(this->holdingRegs, regAddr);
-        if (node == NULL)
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+#if RTU_RESP_CACHE_SIZE
+    /* unchanged registers since the last identical poll: resend that frame */
+    uint32_t version = this->holdVersion;
+    if (rtu_cache_reply(func, regAddr, reqNum, version))
+        return RTU_READ_HOLD_REG;
+#endif
+
+    size_t byte_count = reqNum * 2;
+    size_t needed = 1 + 1 + 1 + byte_count + 2;
+    if (needed > sizeof(this->buf))
+        return RTU_ERR;
+
+    memset(this->buf, 0, sizeof(this->buf));
+
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_READ_HOLD_REGS;
+    this->buf[2] = (uint8_t)byte_count;
+
+    bool hooked = false;
+    CHECK_CALLBACK_EX(rtu_read_regs(&this->holdingRegs, regAddr, reqNum, &this->buf[3], &hooked));
+
+    size_t crc_pos = 3 + byte_count;
+    uint16_t crc = CRC16(this->buf, crc_pos);
+    this->buf[crc_pos + 0] = (uint8_t)(crc & 0x00FF);
+    this->buf[crc_pos + 1] = (uint8_t)((crc >> 8) & 0x00FF);
+
+    resp_len = crc_pos + 2;
+#if RTU_RESP_CACHE_SIZE
+    if (!hooked)
+        rtu_cache_store(func, regAddr, reqNum, version);
+#else
+    (void)hooked;
+#endif
+    rtu_reply(this->buf, resp_len);
+    return RTU_READ_HOLD_REG;
+}
+#endif
+
+#if RTU_FC_WRITE_SINGLE_REG_ENABLE
+/* 0x06 Write Single Register */
+static RTU_Sta_t rtu_fc_write_single_reg(uint8_t func, uint8_t *frame, size_t size)
+{
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+
+    RTU_Register_t *node = rtu_find_node(&this->holdingRegs, regAddr);
+    if (node == NULL)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+        return RTU_ERR;
+    }
+
+    if (size < 8)
+        return RTU_ERR;
+
+    if (node->permiss == RTU_PERMISS_OR)
+    {
+        return RTU_PERMISS_ERR;
+    }
+
+    /* value at frame[4..5] is stored like a one-register 0x10 write */
+    CHECK_CALLBACK_EX(rtu_write_regs(&this->holdingRegs, regAddr, 1, &frame[4]));
+
+    /* echo back request as response (per Modbus) */
+    rtu_reply(frame, size);
+    return RTU_WRITE_HOLD_REG;
+}
+#endif
+
+#if RTU_FC_WRITE_MULTIPLE_REGS_ENABLE
+/* 0x10 Write Multiple Registers */
+static RTU_Sta_t rtu_fc_write_multiple_regs(uint8_t func, uint8_t *frame, size_t size)
+{
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
+    size_t resp_len = 0;
+
+    if (reqNum == 0 || reqNum > 123)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    /* full length check before accessing data: byte count at frame[6] and all data */
+    if (size < (9 + (size_t)reqNum * 2))
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    CHECK_CALLBACK_EX(rtu_write_regs(&this->holdingRegs, regAddr, reqNum, &frame[7]));
+
+    /* build response: address + qty written (8 bytes total) */
+    resp_len = 8;
+    memset(this->buf, 0, sizeof(this->buf));
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_MULTIPLE_WRITE_REG;
+    this->buf[2] = (uint8_t)((regAddr & 0XFF00) >> 8);
+    this->buf[3] = (uint8_t)(regAddr & 0x00FF);
+    this->buf[4] = (uint8_t)((reqNum & 0XFF00) >> 8);
+    this->buf[5] = (uint8_t)(reqNum & 0x00FF);
+    uint16_t crc = CRC16(this->buf, resp_len - 2);
+    this->buf[6] = (uint8_t)(crc & 0x00FF);
+    this->buf[7] = (uint8_t)((crc & 0XFF00) >> 8);
+    rtu_reply(this->buf, resp_len);
+
+    return RTU_WRITE_HOLD_REG;
+}
+#endif
+
+#if RTU_FC_WRITE_MULTIPLE_COILS_ENABLE
+/* 0x0F Write Multiple Coils */
+static RTU_Sta_t rtu_fc_write_multiple_coils(uint8_t func, uint8_t *frame, size_t size)
+{
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
+    RTU_Ctx_t rtu_ctx = {0};
+    size_t resp_len = 0;
+
+    /*
+    请求帧结构：
+    [id][func=0x0F][addr_hi][addr_lo][qty_hi][qty_lo][byte_count][data...][crc_lo][crc_hi]
+
+    响应帧结构：
+    [id][func=0x0F][addr_hi][addr_lo][qty_hi][qty_lo][crc_lo][crc_hi]
+    */
+
+    if (reqNum == 0 || reqNum > 1968) // Modbus标准最大1968 bits
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    if (size < 9)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    uint8_t byte_count = frame[6];
+    if (byte_count != (reqNum + 7) / 8)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    if (size < (7 + byte_count + 2))
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    RTU_Register_t *node = rtu_find_node(&this->coils, regAddr);
+    if (node == NULL)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+        return RTU_ERR;
+    }
+
+    /* ---------- 第一阶段：权限检查（RTU_STAGED_WRITES 时同时执行回调校验） ---------- */
+    RTU_Register_t *check = node;
+    for (uint16_t i = 0; i < reqNum; i++)
+    {
+        uint16_t expect_addr = regAddr + i;
+
+        if (check == NULL || check->address != expect_addr)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
-            return RTU_ERR;
+            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+            return RTU_PERMISS_ERR;
         }
 
-        /* ensure payload length present in frame: byte count at frame[6] and all data */
-        if (size < 9)
+        if (check->permiss == RTU_PERMISS_OR)
         {
             rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
+            return RTU_PERMISS_ERR;
         }
 
-        /* full length check before accessing data */
-        if (size < (9 + (size_t)reqNum * 2))
+        if (check->value == NULL)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+            rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
             return RTU_ERR;
         }
 
-        /* check register's read write permiss */
-        for (int i = 0; i < reqNum; i++)
+#if RTU_STAGED_WRITES
+        /* staged: every callback validates its bit before anything is stored */
+        if (check->callback != NULL)
         {
-            if (node->permiss == RTU_PERMISS_OR)
-            {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_PERMISS_ERR;
-            }
+            rtu_ctx.addr = check->address;
+            rtu_ctx.op = RTU_RW_WRITE;
+            rtu_ctx.value = (frame[7 + (i >> 3)] >> (i & 0x07)) & 0x01;
+            CHECK_CALLBACK_EX(check->callback(&rtu_ctx));
+        }
+#endif
 
-            permiss = permiss->next;
+        check = check->next;
+    }
+
+    /* ---------- 第二阶段：执行写入（挂起后重新执行时从挂起的线圈继续） ---------- */
+    uint16_t stored = RTU_RESUME_FROM();
+    for (uint16_t i = 0; i < reqNum; i++)
+    {
+        if (i < stored)
+        {
+            node = node->next;
+            continue;
         }
 
-        for (uint16_t i = 0; i < reqNum; ++i)
+#if RTU_SIMD_ENABLE && !RTU_DIRTY_TRACKING
+        /* array-backed run with no write callback left to call: unpack it in one go */
+        bool hooked = false;
+        RTU_Register_t *last = NULL;
+        uint16_t run = ((i & 0x07) == 0) ? rtu_bit_run(node, reqNum - i, !RTU_STAGED_WRITES, &hooked, &last) : 0;
+        if (run != 0)
         {
-            uint16_t expect_addr = regAddr + i;
-            if (node == NULL || node->address != expect_addr)
-            {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_ERR;
-            }
+            RTUKernel_UnpackBits((uint8_t *)node->value, &frame[7 + (i >> 3)], run);
+            i += run - 1;
+            node = last->next;
+            continue;
+        }
+#endif
 
-            uint16_t value = ((uint16_t)frame[7 + i * 2] << 8) | frame[8 + i * 2];
+        uint8_t byte_index = i >> 3;
+        uint8_t bit_index = i & 0x07;
 
-            if (node->value)
-            {
-                if (node->callback != NULL)
-                {
-                    rtu_ctx.addr = node->address;
-                    rtu_ctx.op = RTU_RW_WRITE;
-                    rtu_ctx.value = value;
-                    CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
-                }
+        uint8_t bit = (frame[7 + byte_index] >> bit_index) & 0x01;
 
-                *((uint16_t *)node->value) = value;
-            }
-            else
+#if !RTU_STAGED_WRITES
+        if (node->callback != NULL)
+        {
+            rtu_ctx.addr = node->address;
+            rtu_ctx.op = RTU_RW_WRITE;
+            rtu_ctx.value = bit;
+            RTU_ExceptionCode_t ex = node->callback(&rtu_ctx);
+            if (ex != RTU_EX_NONE)
             {
-                rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
-                return RTU_ERR;
+                RTU_RESUME_AT(i);
+                rtu_send_exception(func, ex);
+                return RTU_ExCEPT_ACTIVE;
             }
-
-            node = node->next;
         }
+#endif
 
-        /* build response: address + qty written (8 bytes total) */
-        resp_len = 8;
-        memset(this->buf, 0, sizeof(this->buf));
-        this->buf[0] = this->id;
-        this->buf[1] = RTU_FUNC_MULTIPLE_WRITE_REG;
-        this->buf[2] = (uint8_t)((regAddr & 0XFF00) >> 8);
-        this->buf[3] = (uint8_t)(regAddr & 0x00FF);
-        this->buf[4] = (uint8_t)((reqNum & 0XFF00) >> 8);
-        this->buf[5] = (uint8_t)(reqNum & 0x00FF);
-        uint16_t crc = CRC16(this->buf, resp_len - 2);
-        this->buf[6] = (uint8_t)(crc & 0x00FF);
-        this->buf[7] = (uint8_t)((crc & 0XFF00) >> 8);
-        RTU_Transmit(this->buf, resp_len);
+        uint8_t *coil = (uint8_t *)node->value;
+        uint8_t old = *coil;
+        *coil = bit;
+        if ((old != 0) != bit)
+            RTU_MARK_DIRTY(&this->coils, node);
+
+        node = node->next;
+    }
+
+    /* ---------- 构造响应帧 ---------- */
+    resp_len = 8;
+    memset(this->buf, 0, sizeof(this->buf));
+
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_MULTIPLE_WRITE_COILS;
+    this->buf[2] = (uint8_t)(regAddr >> 8);
+    this->buf[3] = (uint8_t)(regAddr & 0xFF);
+    this->buf[4] = (uint8_t)(reqNum >> 8);
+    this->buf[5] = (uint8_t)(reqNum & 0xFF);
+
+    uint16_t crc = CRC16(this->buf, 6);
+    this->buf[6] = (uint8_t)(crc & 0xFF);
+    this->buf[7] = (uint8_t)(crc >> 8);
+
+    rtu_reply(this->buf, resp_len);
+
+    return RTU_WRITE_COIL;
+}
+#endif
+
+#if RTU_FC_WRITE_SINGLE_COIL_ENABLE
+/* 0x05 Write Single Coil */
+static RTU_Sta_t rtu_fc_write_single_coil(uint8_t func, uint8_t *frame, size_t size)
+{
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    RTU_Ctx_t rtu_ctx = {0};
+
+    /*
+    请求帧：
+    [id][func=0x05][addr_hi][addr_lo][value_hi][value_lo][crc]
+
+    value:
+    0xFF00 = ON
+    0x0000 = OFF
+
+    响应帧：
+    完全回显请求帧
+    */
+
+    if (size < 8)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
 
-        ret = RTU_WRITE_HOLD_REG;
-        break;
+    RTU_Register_t *node = rtu_find_node(&this->coils, regAddr);
+    if (node == NULL)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+        return RTU_ERR;
     }
 
-    case RTU_FUNC_MULTIPLE_WRITE_COILS:
+    if (node->permiss == RTU_PERMISS_OR)
     {
-        /*
-        请求帧结构：
-        [id][func=0x0F][addr_hi][addr_lo][qty_hi][qty_lo][byte_count][data...][crc_lo][crc_hi]
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_PERMISS_ERR;
+    }
 
-        响应帧结构：
-        [id][func=0x0F][addr_hi][addr_lo][qty_hi][qty_lo][crc_lo][crc_hi]
-        */
+    uint16_t value = ((uint16_t)frame[4] << 8) | frame[5];
 
-        if (reqNum == 0 || reqNum > 1968) // Modbus标准最大1968 bits
-        {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
-        }
+    uint8_t bit = (value == 0xFF00) ? 1 : 0;
 
-        if (size < 9)
+    if (node->value)
+    {
+        if (node->callback != NULL)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
+            rtu_ctx.addr = node->address;
+            rtu_ctx.op = RTU_RW_WRITE;
+            rtu_ctx.value = bit;
+            CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
         }
 
-        uint8_t byte_count = frame[6];
-        if (byte_count != (reqNum + 7) / 8)
-        {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
-        }
+        uint8_t old = *((uint8_t *)node->value);
+        *((uint8_t *)node->value) = bit;
+        if ((old != 0) != bit)
+            RTU_MARK_DIRTY(&this->coils, node);
+    }
+    else
+    {
+        rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
+        return RTU_ERR;
+    }
+
+    /* 回显 */
+    rtu_reply(frame, size);
+
+    return RTU_WRITE_COIL;
+}
+#endif
+
+#if RTU_FC_READ_INPUT_REGS_ENABLE
+/* 0x04 Read Input Registers */
+static RTU_Sta_t rtu_fc_read_input_regs(uint8_t func, uint8_t *frame, size_t size)
+{
+    (void)frame;
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
+    size_t resp_len = 0;
+    (void)size;
+
+    /*
+    请求帧：
+    [id][func=0x04][addr_hi][addr_lo][qty_hi][qty_lo][crc]
+
+    响应帧：
+    [id][func=0x04][byte_count][data_hi][data_lo]...[crc]
+    */
+
+    if (reqNum == 0 || reqNum > 125)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+#if RTU_RESP_CACHE_SIZE
+    /* unchanged registers since the last identical poll: resend that frame */
+    uint32_t version = this->inputVersion;
+    if (rtu_cache_reply(func, regAddr, reqNum, version))
+        return RTU_READ_INPUT_REG;
+#endif
+
+    size_t byte_count = reqNum * 2;
+    size_t needed = 1 + 1 + 1 + byte_count + 2;
+
+    if (needed > sizeof(this->buf))
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    memset(this->buf, 0, sizeof(this->buf));
+
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_READ_INPUT_REG;
+    this->buf[2] = (uint8_t)byte_count;
+
+    bool hooked = false;
+    CHECK_CALLBACK_EX(rtu_read_regs(&this->inputRegs, regAddr, reqNum, &this->buf[3], &hooked));
+
+    size_t crc_pos = 3 + byte_count;
+    uint16_t crc = CRC16(this->buf, crc_pos);
+
+    this->buf[crc_pos] = (uint8_t)(crc & 0xFF);
+    this->buf[crc_pos + 1] = (uint8_t)(crc >> 8);
+
+    resp_len = crc_pos + 2;
+#if RTU_RESP_CACHE_SIZE
+    if (!hooked)
+        rtu_cache_store(func, regAddr, reqNum, version);
+#else
+    (void)hooked;
+#endif
+    rtu_reply(this->buf, resp_len);
+
+    return RTU_READ_INPUT_REG;
+}
+#endif
+
+#if RTU_FC_READ_DISCRETE_INPUTS_ENABLE
+/* 0x02 Read Discrete Inputs */
+static RTU_Sta_t rtu_fc_read_discrete_inputs(uint8_t func, uint8_t *frame, size_t size)
+{
+    (void)frame;
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    uint16_t reqNum = ((uint16_t)frame[4] << 8) | frame[5];
+    RTU_Ctx_t rtu_ctx = {0};
+    size_t resp_len = 0;
+    (void)size;
+
+    /*
+    请求帧：
+    [id][func=0x02][addr_hi][addr_lo][qty_hi][qty_lo][crc]
+
+    响应帧：
+    [id][func=0x02][byte_count][input_bytes...][crc]
+    */
+
+    if (reqNum == 0 || reqNum > 2000)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    size_t byte_count = (reqNum + 7) / 8;
+    size_t needed = 1 + 1 + 1 + byte_count + 2;
+    if (needed > sizeof(this->buf))
+    {
+        rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
+        return RTU_ERR;
+    }
+
+    memset(this->buf, 0, sizeof(this->buf));
 
-        if (size < (7 + byte_count + 2))
-        {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-            return RTU_ERR;
-        }
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_READ_DISCRETE_INPUTS;
+    this->buf[2] = (uint8_t)byte_count;
+
+    /* snapshot the published bitmap once so the whole reply comes from one image */
+    const uint8_t *bits = RTU_LOAD_ACQUIRE(&this->discreteImage.bits);
+    uint32_t img_start = this->discreteImage.start;
+    uint32_t img_end = img_start + this->discreteImage.count;
 
-        RTU_Register_t *node = rtu_find_node(this->coils, regAddr);
+    if (bits != NULL && regAddr >= img_start && (uint32_t)regAddr + reqNum <= img_end)
+    {
+        rtu_copy_bits(&this->buf[3], bits, regAddr - img_start, reqNum);
+    }
+    else
+    {
+        RTU_Register_t *node = rtu_find_node(&this->discreteInputs, regAddr);
         if (node == NULL)
         {
             rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
             return RTU_ERR;
         }
 
-        /* ---------- 第一阶段：权限检查 ---------- */
-        RTU_Register_t *check = node;
-        for (uint16_t i = 0; i < reqNum; i++)
+        for (uint16_t i = 0; i < reqNum; ++i)
         {
             uint16_t expect_addr = regAddr + i;
-
-            if (check == NULL || check->address != expect_addr)
+            if (node == NULL || node->address != expect_addr)
             {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_PERMISS_ERR;
+                rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+                return RTU_ERR;
             }
 
-            if (check->permiss == RTU_PERMISS_OR)
+#if RTU_SIMD_ENABLE
+            uint16_t run = 0;
+            CHECK_CALLBACK_EX(rtu_pack_run(&node, i, reqNum - i, &this->buf[3], &run));
+            if (run != 0)
             {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_PERMISS_ERR;
+                i += run - 1;
+                continue;
             }
+#endif
 
-            check = check->next;
-        }
-
-        /* ---------- 第二阶段：执行写入 ---------- */
-        for (uint16_t i = 0; i < reqNum; i++)
-        {
-            uint8_t byte_index = i >> 3;
-            uint8_t bit_index = i & 0x07;
-
-            uint8_t bit = (frame[7 + byte_index] >> bit_index) & 0x01;
-
+            uint8_t bit = 0;
             if (node->value)
             {
+                bit = ((*((uint8_t *)node->value)) != 0) ? 1u : 0u;
 
                 if (node->callback != NULL)
                 {
                     rtu_ctx.addr = node->address;
-                    rtu_ctx.op = RTU_RW_WRITE;
+                    rtu_ctx.op = RTU_RW_READ;
                     rtu_ctx.value = bit;
                     CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
                 }
-
-                *((uint8_t *)node->value) = bit ? 1 : 0;
             }
             else
             {
@@ -661,191 +3404,619 @@ RTU_Sta_t RTUSlave_TimerHandler(void)
                 return RTU_ERR;
             }
 
+            this->buf[3 + (i >> 3)] |= (uint8_t)(bit << (i & 0x07));
+
             node = node->next;
         }
+    }
 
-        /* ---------- 构造响应帧 ---------- */
-        resp_len = 8;
-        memset(this->buf, 0, sizeof(this->buf));
+    size_t crc_pos = 3 + byte_count;
+    uint16_t crc = CRC16(this->buf, crc_pos);
+    this->buf[crc_pos + 0] = (uint8_t)(crc & 0x00FF);
+    this->buf[crc_pos + 1] = (uint8_t)((crc >> 8) & 0x00FF);
 
-        this->buf[0] = this->id;
-        this->buf[1] = RTU_FUNC_MULTIPLE_WRITE_COILS;
-        this->buf[2] = (uint8_t)(regAddr >> 8);
-        this->buf[3] = (uint8_t)(regAddr & 0xFF);
-        this->buf[4] = (uint8_t)(reqNum >> 8);
-        this->buf[5] = (uint8_t)(reqNum & 0xFF);
+    resp_len = crc_pos + 2;
+    rtu_reply(this->buf, resp_len);
+
+    return RTU_READ_DISCRETE_INPUT;
+}
+#endif
+
+#if RTU_FIFO_ENABLE
+/* 0x18 Read FIFO Queue */
+static RTU_Sta_t rtu_fc_read_fifo(uint8_t func, uint8_t *frame, size_t size)
+{
+    (void)frame;
+    uint16_t regAddr = ((uint16_t)frame[2] << 8) | frame[3];
+    size_t resp_len = 0;
+    (void)size;
+
+    /*
+    请求帧：
+    [id][func=0x18][ptr_hi][ptr_lo][crc]
+
+    响应帧：
+    [id][func=0x18][byte_count_hi][byte_count_lo][fifo_count_hi][fifo_count_lo][data_hi][data_lo]...[crc]
+    byte_count = 2 + fifo_count * 2
+
+    每次最多取出 31 个值，剩余的留给下一次请求。
+    */
+
+    RTU_Fifo_t *fifo = NULL;
+    for (size_t i = 0; i < RTU_MAX_FIFOS; i++)
+    {
+        if (this->fifos[i] != NULL && this->fifos[i]->address == regAddr)
+        {
+            fifo = this->fifos[i];
+            break;
+        }
+    }
+
+    if (fifo == NULL)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+        return RTU_ERR;
+    }
+
+    uint16_t tail = fifo->tail;
+    uint16_t count = (uint16_t)(RTU_LOAD_ACQUIRE(&fifo->head) - tail);
+    if (count > RTU_FIFO_MAX_READ)
+        count = RTU_FIFO_MAX_READ;
+
+    size_t byte_count = 2 + (size_t)count * 2;
+    size_t needed = 1 + 1 + 2 + byte_count + 2;
+    if (needed > sizeof(this->buf))
+    {
+        rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
+        return RTU_ERR;
+    }
+
+    memset(this->buf, 0, sizeof(this->buf));
+
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_READ_FIFO_QUEUE;
+    this->buf[2] = (uint8_t)(byte_count >> 8);
+    this->buf[3] = (uint8_t)(byte_count & 0xFF);
+    this->buf[4] = (uint8_t)(count >> 8);
+    this->buf[5] = (uint8_t)(count & 0xFF);
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        uint16_t val = fifo->buf[(uint16_t)(tail + i) & (RTU_FIFO_DEPTH - 1U)];
+        size_t off = 6 + (size_t)i * 2;
+        this->buf[off] = (uint8_t)(val >> 8);
+        this->buf[off + 1] = (uint8_t)(val & 0xFF);
+    }
+
+    /* release the slots only after the values are copied out */
+    RTU_STORE_RELEASE(&fifo->tail, (uint16_t)(tail + count));
+
+    size_t crc_pos = 4 + byte_count;
+    uint16_t crc = CRC16(this->buf, crc_pos);
+    this->buf[crc_pos] = (uint8_t)(crc & 0xFF);
+    this->buf[crc_pos + 1] = (uint8_t)(crc >> 8);
+
+    resp_len = crc_pos + 2;
+    rtu_reply(this->buf, resp_len);
 
-        uint16_t crc = CRC16(this->buf, 6);
-        this->buf[6] = (uint8_t)(crc & 0xFF);
-        this->buf[7] = (uint8_t)(crc >> 8);
+    return RTU_READ_FIFO;
+}
+#endif
+
+#if RTU_FILE_RECORD_ENABLE
+/* 0x14 Read File Record */
+static RTU_Sta_t rtu_fc_read_file_record(uint8_t func, uint8_t *frame, size_t size)
+{
+    size_t resp_len = 0;
+
+    /*
+    请求帧：
+    [id][func=0x14][byte_count]{[ref=6][file_hi][file_lo][rec_hi][rec_lo][len_hi][len_lo]}...[crc]
+
+    响应帧：
+    [id][func=0x14][resp_len]{[sub_len=1+len*2][ref=6][data_hi][data_lo]...}...[crc]
+
+    请求与响应共用 this->buf，因此先把所有子请求解析到栈上再组帧。
+    */
+
+    uint8_t byte_count = frame[2];
+    if (byte_count < 7 || byte_count > 0xF5 || (byte_count % 7) != 0 || size != (size_t)byte_count + 5)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
+
+    size_t sub_num = byte_count / 7;
+    RTU_FileRecordMap_t *files[RTU_FILE_MAX_SUBREQ];
+    uint16_t records[RTU_FILE_MAX_SUBREQ];
+    uint16_t lens[RTU_FILE_MAX_SUBREQ];
+    size_t resp_data = 0;
+
+    for (size_t n = 0; n < sub_num; n++)
+    {
+        const uint8_t *sub = &frame[3 + n * 7];
+        RTU_ExceptionCode_t ex = rtu_check_file_subreq(sub, &files[n]);
+        if (ex != RTU_EX_NONE)
+        {
+            rtu_send_exception(func, ex);
+            return RTU_ERR;
+        }
 
-        RTU_Transmit(this->buf, resp_len);
+        records[n] = ((uint16_t)sub[3] << 8) | sub[4];
+        lens[n] = ((uint16_t)sub[5] << 8) | sub[6];
+        resp_data += 2 + (size_t)lens[n] * 2;
+    }
 
-        ret = RTU_WRITE_COIL;
-        break;
+    if (resp_data > 0xF5 || 3 + resp_data + 2 > sizeof(this->buf))
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
     }
 
-    case RTU_FUNC_WRITE_SINGLE_COILS:
+    memset(this->buf, 0, sizeof(this->buf));
+
+    this->buf[0] = this->id;
+    this->buf[1] = RTU_FUNC_READ_FILE_RECORD;
+    this->buf[2] = (uint8_t)resp_data;
+
+    size_t off = 3;
+    uint16_t regs[0xF5 / 2];
+    RTU_FileCtx_t file_ctx = {0};
+    for (size_t n = 0; n < sub_num; n++)
     {
-        /*
-        请求帧：
-        [id][func=0x05][addr_hi][addr_lo][value_hi][value_lo][crc]
+        RTU_FileRecordMap_t *f = files[n];
+
+        if (f->data)
+            memcpy(regs, &f->data[records[n]], (size_t)lens[n] * sizeof(uint16_t));
+
+        if (f->callback != NULL)
+        {
+            file_ctx.file = f->file;
+            file_ctx.record = records[n];
+            file_ctx.op = RTU_RW_READ;
+            file_ctx.regs = regs;
+            file_ctx.count = lens[n];
+            CHECK_CALLBACK_EX(f->callback(&file_ctx));
+        }
+
+        this->buf[off++] = (uint8_t)(1 + lens[n] * 2);
+        this->buf[off++] = RTU_FILE_REF_TYPE;
+        for (uint16_t i = 0; i < lens[n]; i++)
+        {
+            this->buf[off++] = (uint8_t)(regs[i] >> 8);
+            this->buf[off++] = (uint8_t)(regs[i] & 0xFF);
+        }
+    }
+
+    uint16_t crc = CRC16(this->buf, off);
+    this->buf[off] = (uint8_t)(crc & 0xFF);
+    this->buf[off + 1] = (uint8_t)(crc >> 8);
 
-        value:
-        0xFF00 = ON
-        0x0000 = OFF
+    resp_len = off + 2;
+    rtu_reply(this->buf, resp_len);
 
-        响应帧：
-        完全回显请求帧
-        */
+    return RTU_READ_FILE;
+}
+#endif
+
+#if RTU_FILE_RECORD_ENABLE
+/* 0x15 Write File Record */
+static RTU_Sta_t rtu_fc_write_file_record(uint8_t func, uint8_t *frame, size_t size)
+{
+    /*
+    请求帧：
+    [id][func=0x15][byte_count]{[ref=6][file_hi][file_lo][rec_hi][rec_lo][len_hi][len_lo][data...]}...[crc]
+
+    响应帧：
+    完全回显请求帧
+    */
+
+    uint8_t byte_count = frame[2];
+    if (byte_count < 9 || byte_count > 0xFB || size != (size_t)byte_count + 5)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
 
-        if (size < 8)
+    /* ---------- 第一阶段：检查所有子请求 ---------- */
+    size_t end = 3 + (size_t)byte_count;
+    size_t off = 3;
+    while (off < end)
+    {
+        RTU_FileRecordMap_t *f = NULL;
+        if (off + 7 > end)
         {
             rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
             return RTU_ERR;
         }
 
-        RTU_Register_t *node = rtu_find_node(this->coils, regAddr);
-        if (node == NULL)
+        RTU_ExceptionCode_t ex = rtu_check_file_subreq(&frame[off], &f);
+        if (ex != RTU_EX_NONE)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_ADDR);
+            rtu_send_exception(func, ex);
             return RTU_ERR;
         }
 
-        if (node->permiss == RTU_PERMISS_OR)
+        if (f->permiss == RTU_PERMISS_OR)
         {
             rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
             return RTU_PERMISS_ERR;
         }
 
-        uint16_t value = ((uint16_t)frame[4] << 8) | frame[5];
+        uint16_t len = ((uint16_t)frame[off + 5] << 8) | frame[off + 6];
+        off += 7 + (size_t)len * 2;
+    }
 
-        uint8_t bit = (value == 0xFF00) ? 1 : 0;
+    if (off != end)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
 
-        if (node->value)
-        {
+    /* ---------- 第二阶段：执行写入 ---------- */
+    uint16_t regs[0xFB / 2];
+    RTU_FileCtx_t file_ctx = {0};
+    off = 3;
+    while (off < end)
+    {
+        const uint8_t *sub = &frame[off];
+        RTU_FileRecordMap_t *f = rtu_find_file(((uint16_t)sub[1] << 8) | sub[2]);
+        uint16_t record = ((uint16_t)sub[3] << 8) | sub[4];
+        uint16_t len = ((uint16_t)sub[5] << 8) | sub[6];
 
-            if (node->callback != NULL)
-            {
-                rtu_ctx.addr = node->address;
-                rtu_ctx.op = RTU_RW_WRITE;
-                rtu_ctx.value = bit;
-                CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
-            }
+        for (uint16_t i = 0; i < len; i++)
+            regs[i] = ((uint16_t)sub[7 + i * 2] << 8) | sub[8 + i * 2];
 
-            *((uint8_t *)node->value) = bit;
-        }
-        else
+        if (f->callback != NULL)
         {
-            rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
-            return RTU_ERR;
+            file_ctx.file = f->file;
+            file_ctx.record = record;
+            file_ctx.op = RTU_RW_WRITE;
+            file_ctx.regs = regs;
+            file_ctx.count = len;
+            CHECK_CALLBACK_EX(f->callback(&file_ctx));
         }
 
-        /* 回显 */
-        RTU_Transmit(frame, size);
-        resp_len = size;
+        if (f->data)
+            memcpy(&f->data[record], regs, (size_t)len * sizeof(uint16_t));
 
-        ret = RTU_WRITE_COIL;
-        break;
+        off += 7 + (size_t)len * 2;
     }
 
-    case RTU_FUNC_READ_INPUT_REG:
+    /* 回显 */
+    rtu_reply(frame, size);
+
+    return RTU_WRITE_FILE;
+}
+#endif
+
+#if RTU_EXT_FRAME_ENABLE
+/* RTU_EXT_FUNC_CODE extended large-frame access */
+static RTU_Sta_t rtu_fc_extended(uint8_t func, uint8_t *frame, size_t size)
+{
+    size_t resp_len = 0;
+
+    /*
+    请求帧（读）：
+    [id][func][sub=0x03/0x04][addr_hi][addr_lo][qty_hi][qty_lo][crc]
+    请求帧（写）：
+    [id][func][sub=0x10][addr_hi][addr_lo][qty_hi][qty_lo][byte_count_hi][byte_count_lo][data...][crc]
+
+    响应帧（读）：
+    [id][func][sub][byte_count_hi][byte_count_lo][data...][crc]
+    响应帧（写）：
+    [id][func][sub][addr_hi][addr_lo][qty_hi][qty_lo][crc]
+    */
+
+    if (size < 9)
     {
-        /*
-        请求帧：
-        [id][func=0x04][addr_hi][addr_lo][qty_hi][qty_lo][crc]
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
 
-        响应帧：
-        [id][func=0x04][byte_count][data_hi][data_lo]...[crc]
-        */
+    uint8_t sub = frame[2];
+    uint16_t extAddr = ((uint16_t)frame[3] << 8) | frame[4];
+    uint16_t extNum = ((uint16_t)frame[5] << 8) | frame[6];
+    size_t byte_count = (size_t)extNum * 2;
+
+    if (extNum == 0 || extNum > RTU_EXT_MAX_REGS)
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+        return RTU_ERR;
+    }
 
-        if (reqNum == 0 || reqNum > 125)
+    if (sub == RTU_FUNC_READ_HOLD_REGS || sub == RTU_FUNC_READ_INPUT_REG)
+    {
+        if (5 + byte_count + 2 > sizeof(this->buf))
         {
             rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
             return RTU_ERR;
         }
 
-        size_t byte_count = reqNum * 2;
-        size_t needed = 1 + 1 + 1 + byte_count + 2;
+        const RTU_RegList_t *list = (sub == RTU_FUNC_READ_HOLD_REGS) ? &this->holdingRegs : &this->inputRegs;
+
+        this->buf[0] = this->id;
+        this->buf[1] = func;
+        this->buf[2] = sub;
+        this->buf[3] = (uint8_t)(byte_count >> 8);
+        this->buf[4] = (uint8_t)(byte_count & 0xFF);
+
+        CHECK_CALLBACK_EX(rtu_read_regs(list, extAddr, extNum, &this->buf[5], NULL));
+
+        size_t crc_pos = 5 + byte_count;
+        uint16_t crc = CRC16(this->buf, crc_pos);
+        this->buf[crc_pos] = (uint8_t)(crc & 0xFF);
+        this->buf[crc_pos + 1] = (uint8_t)(crc >> 8);
+
+        resp_len = crc_pos + 2;
+        rtu_reply(this->buf, resp_len);
 
-        if (needed > sizeof(this->buf))
+        return (sub == RTU_FUNC_READ_HOLD_REGS) ? RTU_READ_HOLD_REG : RTU_READ_INPUT_REG;
+    }
+    else if (sub == RTU_FUNC_MULTIPLE_WRITE_REG)
+    {
+        uint16_t data_len = ((uint16_t)frame[7] << 8) | frame[8];
+        if (data_len != byte_count || size != 9 + byte_count + 2)
         {
             rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
             return RTU_ERR;
         }
 
-        memset(this->buf, 0, sizeof(this->buf));
+        CHECK_CALLBACK_EX(rtu_write_regs(&this->holdingRegs, extAddr, extNum, &frame[9]));
+
+        /* response reuses the request header */
+        uint16_t crc = CRC16(this->buf, 7);
+        this->buf[7] = (uint8_t)(crc & 0xFF);
+        this->buf[8] = (uint8_t)(crc >> 8);
+
+        resp_len = 9;
+        rtu_reply(this->buf, resp_len);
+
+        return RTU_WRITE_HOLD_REG;
+    }
+    else
+    {
+        rtu_send_exception(func, RTU_EX_ILLEGAL_FUNC);
+        return RTU_ERR;
+    }
+}
+#endif
+
+typedef RTU_Sta_t (*rtu_builtin_func_t)(uint8_t func, uint8_t *frame, size_t size);
+
+/* Built-in handlers indexed by function code, NULL = not supported.
+ * Code 0 is never valid and keeps the initializer non-empty when every
+ * function code is configured out. */
+static const rtu_builtin_func_t rtu_builtin_funcs[256] = {
+    [0] = NULL,
+#if RTU_FC_READ_COILS_ENABLE
+    [RTU_FUNC_READ_COILS] = rtu_fc_read_coils,
+#endif
+#if RTU_FC_READ_DISCRETE_INPUTS_ENABLE
+    [RTU_FUNC_READ_DISCRETE_INPUTS] = rtu_fc_read_discrete_inputs,
+#endif
+#if RTU_FC_READ_HOLD_REGS_ENABLE
+    [RTU_FUNC_READ_HOLD_REGS] = rtu_fc_read_hold_regs,
+#endif
+#if RTU_FC_READ_INPUT_REGS_ENABLE
+    [RTU_FUNC_READ_INPUT_REG] = rtu_fc_read_input_regs,
+#endif
+#if RTU_FC_WRITE_SINGLE_COIL_ENABLE
+    [RTU_FUNC_WRITE_SINGLE_COILS] = rtu_fc_write_single_coil,
+#endif
+#if RTU_FC_WRITE_SINGLE_REG_ENABLE
+    [RTU_FUNC_WRITE_SINGLE_REG] = rtu_fc_write_single_reg,
+#endif
+#if RTU_FC_WRITE_MULTIPLE_COILS_ENABLE
+    [RTU_FUNC_MULTIPLE_WRITE_COILS] = rtu_fc_write_multiple_coils,
+#endif
+#if RTU_FC_WRITE_MULTIPLE_REGS_ENABLE
+    [RTU_FUNC_MULTIPLE_WRITE_REG] = rtu_fc_write_multiple_regs,
+#endif
+#if RTU_FILE_RECORD_ENABLE
+    [RTU_FUNC_READ_FILE_RECORD] = rtu_fc_read_file_record,
+#endif
+#if RTU_FILE_RECORD_ENABLE
+    [RTU_FUNC_WRITE_FILE_RECORD] = rtu_fc_write_file_record,
+#endif
+#if RTU_FIFO_ENABLE
+    [RTU_FUNC_READ_FIFO_QUEUE] = rtu_fc_read_fifo,
+#endif
+#if RTU_EXT_FRAME_ENABLE
+    [RTU_EXT_FUNC_CODE] = rtu_fc_extended,
+#endif
+};
+
+/* Helper: run a registered handler on the frame and send its reply */
+static RTU_Sta_t rtu_call_user_func(RTUSlave_FuncHandler_t handler, uint8_t func, uint8_t *frame, size_t size)
+{
+    RTU_FuncCtx_t ctx = {0};
+    ctx.func = func;
+    ctx.req = frame;
+    ctx.reqLen = size - 2;
+    ctx.resp = this->buf;
+    ctx.respMax = sizeof(this->buf) - 2;
+
+    RTU_ExceptionCode_t ex = handler(&ctx);
+    if (ex != RTU_EX_NONE)
+    {
+        rtu_send_exception(func, ex);
+        return RTU_ExCEPT_ACTIVE;
+    }
+
+    if (ctx.respLen > ctx.respMax)
+    {
+        rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
+        return RTU_ERR;
+    }
+
+    if (ctx.respLen != 0)
+    {
+        if (ctx.respLen < 2)
+            ctx.respLen = 2;
 
         this->buf[0] = this->id;
-        this->buf[1] = RTU_FUNC_READ_INPUT_REG;
-        this->buf[2] = (uint8_t)byte_count;
+        this->buf[1] = func;
+        uint16_t crc = CRC16(this->buf, ctx.respLen);
+        this->buf[ctx.respLen] = (uint8_t)(crc & 0xFF);
+        this->buf[ctx.respLen + 1] = (uint8_t)(crc >> 8);
+        rtu_reply(this->buf, ctx.respLen + 2);
+    }
 
-        RTU_Register_t *node = rtu_find_node(this->inputRegs, regAddr);
+    return RTU_USER_FUNC;
+}
 
-        if (node == NULL)
+/* Helper: run a validated request through the user or built-in handler */
+static RTU_Sta_t rtu_dispatch(uint8_t *frame, size_t size)
+{
+    uint8_t func = frame[1];
+    RTU_Sta_t ret;
+
+    /* user handlers take precedence over the built-in table */
+    uint8_t slot = this->funcSlot[func];
+    if (slot != 0 && this->userFuncs[slot - 1] != NULL)
+    {
+        ret = rtu_call_user_func(this->userFuncs[slot - 1], func, frame, size);
+    }
+    else
+    {
+        rtu_builtin_func_t handler = rtu_builtin_funcs[func];
+        if (handler == NULL)
         {
-            rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
+            rtu_send_exception(func, RTU_EX_ILLEGAL_FUNC);
             return RTU_ERR;
         }
 
-        for (uint16_t i = 0; i < reqNum; i++)
-        {
-            uint16_t expect_addr = regAddr + i;
+        /* 0x18 is the only 6-byte built-in request */
+        if (size < ((func == RTU_FUNC_READ_FIFO_QUEUE) ? 6U : 8U))
+            return RTU_ERR;
 
-            if (node == NULL || node->address != expect_addr)
-            {
-                rtu_send_exception(func, RTU_EX_ILLEGAL_VALUE);
-                return RTU_ERR;
-            }
+        if (this->broadcast && func != RTU_FUNC_WRITE_SINGLE_COILS && func != RTU_FUNC_WRITE_SINGLE_REG &&
+            func != RTU_FUNC_MULTIPLE_WRITE_COILS && func != RTU_FUNC_MULTIPLE_WRITE_REG)
+            return RTU_ERR;
 
-            uint16_t val = 0;
+        ret = handler(func, frame, size);
+    }
 
-            if (node->value)
-            {
-                val = *((uint16_t *)node->value);
+    /* clear internal buffer after processing (optional) */
+    memset(this->buf, 0, sizeof(this->buf));
 
-                if (node->callback != NULL)
-                {
-                    rtu_ctx.addr = node->address;
-                    rtu_ctx.op = RTU_RW_READ;
-                    rtu_ctx.value = val;
-                    CHECK_CALLBACK_EX(node->callback(&rtu_ctx));
-                }
-            }
-            else
-            {
-                rtu_send_exception(func, RTU_EX_SLAVE_FAILURE);
-                return RTU_ERR;
-            }
+#if RTU_PENDING_MAX
+    if (this->deferred)
+    {
+        this->deferred = false;
+        return RTU_PENDING;
+    }
+#endif
+    return ret;
+}
 
-            size_t off = 3 + i * 2;
-            this->buf[off] = (uint8_t)(val >> 8);
-            this->buf[off + 1] = (uint8_t)(val & 0xFF);
+#if RTU_PENDING_MAX
+/* Helper: run the first request released by RTUSlave_CompletePending() */
+static RTU_Sta_t rtu_resume_pending(void)
+{
+    for (uint8_t i = 0; i < RTU_PENDING_MAX; i++)
+    {
+        RTU_Pending_t *p = &this->pending[i];
+        if (p->state != RTU_PEND_READY)
+            continue;
+
+        memcpy(this->buf, p->frame, p->len);
+        this->broadcast = p->silent;
+        this->curSlot = i + 1;
+        this->resumeFrom = p->resume;
+        p->state = RTU_PEND_FREE; // parked again if a callback is still pending
+
+        RTU_Sta_t ret = rtu_dispatch(this->buf, p->len);
+        this->curSlot = 0;
+        return ret;
+    }
 
-            node = node->next;
-        }
+    return RTU_NOACTIVE;
+}
+#endif
 
-        size_t crc_pos = 3 + byte_count;
-        uint16_t crc = CRC16(this->buf, crc_pos);
+/* The periodic handler: when a frame is ready, process it. */
+RTU_Sta_t RTUSlave_TimerHandler(void)
+{
+    /* between two requests: switch to maps registered meanwhile */
+    RTU_SWAP_ADOPT();
 
-        this->buf[crc_pos] = (uint8_t)(crc & 0xFF);
-        this->buf[crc_pos + 1] = (uint8_t)(crc >> 8);
+    if (!this->g_frame.ready)
+    {
+#if RTU_PERSIST_ENABLE
+        rtu_persist_poll();
+#endif
+#if RTU_PENDING_MAX
+        /* bus idle: answer a completed deferred request */
+        return rtu_resume_pending();
+#else
+        return RTU_NOACTIVE;
+#endif
+    }
 
-        resp_len = crc_pos + 2;
-        RTU_Transmit(this->buf, resp_len);
+    /* snapshot frame pointer and len, then clear ready to allow next receive */
+    uint8_t *frame = this->buf;
+    size_t size = this->g_frame.len;
+#if RTU_MONITOR_ENABLE
+    uint32_t rx_time = this->g_frame.time;
+#endif
+
+    /* clear ready early so ReceiveCallback can overwrite buffer while we process */
+    this->g_frame.ready = false;
+    this->g_frame.len = 0;
+
+#if RTU_MONITOR_ENABLE
+    /* capture every frame on the line before the id filter, noise and fragments included */
+    if (this->mon.mode != RTU_MONITOR_OFF)
+    {
+        uint8_t flags = 0U; // too short to carry a CRC
+        if (size > 2)
+        {
+            uint16_t mon_crc = (uint16_t)frame[size - 2] | ((uint16_t)frame[size - 1] << 8);
+            flags = (mon_crc == CRC16(frame, size - 2)) ? RTU_MON_FLAG_CRC_OK : 0U;
+        }
+        rtu_mon_log(frame, size, rx_time, flags);
 
-        ret = RTU_READ_INPUT_REG;
-        break;
+        if (this->mon.mode == RTU_MONITOR_PASSIVE)
+            return RTU_OK;
     }
+#endif
 
-    default:
-        rtu_send_exception(func, RTU_EX_ILLEGAL_FUNC);
+    /* Basic validation: id + func + crc; built-in codes check their own minimum below */
+    if (size < 4)
+        return RTU_ERR;
+
+    /* id 0 is a broadcast: accepted for writes only and never answered */
+    this->broadcast = (frame[0] == RTU_BROADCAST_ID);
+    if (frame[0] != this->id && !this->broadcast)
+        return RTU_ERR;
+
+    uint16_t recv_crc = (uint16_t)frame[size - 2] | ((uint16_t)frame[size - 1] << 8);
+    if (recv_crc != CRC16(frame, size - 2))
+    {
         return RTU_ERR;
     }
 
-    /* clear internal buffer after processing (optional) */
-    memset(this->buf, 0, sizeof(this->buf));
-    return ret;
+#if RTU_PENDING_MAX
+    if (!this->broadcast)
+    {
+        /* the master gave up on any parked unicast request: finish those without a reply */
+        for (uint8_t i = 0; i < RTU_PENDING_MAX; i++)
+        {
+            if (this->pending[i].state != RTU_PEND_FREE && this->pending[i].frame[0] != RTU_BROADCAST_ID)
+                this->pending[i].silent = true;
+        }
+    }
+
+    /* keep the request as received, handlers reuse buf for the response */
+    this->reqLen = (size <= RTU_PENDING_FRAME_SIZE) ? (uint16_t)size : 0U;
+    this->resumeFrom = 0;
+    if (this->reqLen != 0)
+        memcpy(this->reqCopy, frame, size);
+#endif
+
+    return rtu_dispatch(frame, size);
 }
 
 /* Modify id (single param) */
@@ -855,9 +4026,20 @@ RTU_Sta_t RTUSlave_Modifyid(uint8_t id)
         return RTU_ERR;
 
     this->id = id;
+#if RTU_RESP_CACHE_SIZE
+    rtu_cache_clear();
+#endif
     return RTU_OK;
 }
 
+#if RTU_MONITOR_ENABLE
+/* Default weak monitor time source (user may override) */
+uint32_t __attribute__((weak)) RTU_MonitorTime(void)
+{
+    return 0;
+}
+#endif
+
 /* Default weak transmit function (user may override) */
 int __attribute__((weak)) RTU_Transmit(uint8_t *data, size_t size)
 {
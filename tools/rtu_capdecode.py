@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""
+rtu_capdecode.py - offline decoder for RtuSlave bus monitor captures
+
+Reads the records produced by RTUSlave_MonitorRead() (concatenated, e.g. as
+written to a file or streamed over a debug port), lists every frame and
+prints per-slave turnaround and bus utilisation statistics.
+
+Record layout (little endian):
+    [0xA5][flags][len (2)][time (4)][frame (len)]
+    flags: 0x01 CRC valid, 0x02 sent by the capturing slave
+
+Received frames are stamped at the end of the frame, transmitted frames at
+their start; the decoder converts both to start/end times using the line
+speed (--baud), so turnaround is measured from the end of the request to the
+start of the response.
+
+Usage:
+    python3 tools/rtu_capdecode.py capture.bin --baud 19200
+    python3 tools/rtu_capdecode.py capture.bin --baud 115200 --tick-us 1 --summary
+"""
+
+import argparse
+import struct
+import sys
+
+SYNC = 0xA5
+HDR = struct.Struct("<BBHI")
+FLAG_CRC_OK = 0x01
+FLAG_TX = 0x02
+
+EXCEPTIONS = {
+    0x01: "illegal function",
+    0x02: "illegal address",
+    0x03: "illegal value",
+    0x04: "slave failure",
+    0x06: "slave busy",
+}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def read_records(blob):
+    """Yield (flags, time, frame); skips garbage until the next sync byte."""
+    pos = 0
+    skipped = 0
+    while pos + HDR.size <= len(blob):
+        sync, flags, length, time = HDR.unpack_from(blob, pos)
+        end = pos + HDR.size + length
+        if sync != SYNC or end > len(blob) or flags & ~(FLAG_CRC_OK | FLAG_TX):
+            pos += 1
+            skipped += 1
+            continue
+        yield flags, time, blob[pos + HDR.size:end]
+        pos = end
+    if skipped or pos != len(blob):
+        sys.stderr.write("rtu_capdecode: skipped %d byte(s) of garbage/trailing data\n"
+                         % (skipped + len(blob) - pos))
+
+
+def u16(frame, off):
+    return (frame[off] << 8) | frame[off + 1] if len(frame) >= off + 2 else None
+
+
+def frame_kind(frame):
+    """'req' or 'resp' when the length of a valid frame tells them apart, else None.
+
+    A master retry repeats the id and function code of the unanswered
+    request, so only the shape separates it from a response.
+    """
+    func, n = frame[1], len(frame)
+    if func & 0x80:
+        return "resp"
+    if func in (0x01, 0x02, 0x03, 0x04):
+        req, resp = n == 8, n >= 5 and n == 5 + frame[2]
+        return None if req == resp else ("req" if req else "resp")
+    if func in (0x0F, 0x10):
+        if n == 8:
+            return "resp"
+        if n >= 9 and n == 9 + frame[6]:
+            return "req"
+    return None  # 0x05 / 0x06 echo the request: same shape both ways
+
+
+def describe(frame, is_response):
+    """One-line summary of the PDU of a valid frame."""
+    func = frame[1]
+    if func & 0x80:
+        code = frame[2] if len(frame) > 4 else None
+        return "exception 0x%02X (%s)" % (code, EXCEPTIONS.get(code, "?")) if code is not None else "exception"
+
+    pdu = frame[:-2]
+    if func in (0x01, 0x02, 0x03, 0x04) and is_response:
+        return "%d data byte(s)" % frame[2]
+    addr, val = u16(pdu, 2), u16(pdu, 4)
+    if addr is None or val is None:
+        return "%d byte(s)" % (len(frame) - 4)  # too short for its function code
+    if func in (0x05, 0x06):
+        return "addr=0x%04X value=0x%04X" % (addr, val)
+    if func in (0x01, 0x02, 0x03, 0x04, 0x0F, 0x10):
+        return "addr=0x%04X qty=%d" % (addr, val)
+    return "%d byte(s)" % (len(frame) - 4)
+
+
+def percentile(values, p):
+    values = sorted(values)
+    k = min(len(values) - 1, max(0, int(round(p / 100.0 * (len(values) - 1)))))
+    return values[k]
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode RtuSlave bus monitor captures")
+    ap.add_argument("capture", help="capture file (RTUSlave_MonitorRead() output)")
+    ap.add_argument("--baud", type=int, default=0, help="line speed, enables airtime and utilisation")
+    ap.add_argument("--bits-per-char", type=int, default=11, help="bits per character on the line (default 11)")
+    ap.add_argument("--tick-us", type=float, default=1.0, help="RTU_MonitorTime() tick in microseconds")
+    ap.add_argument("--summary", action="store_true", help="statistics only, no frame listing")
+    args = ap.parse_args()
+
+    try:
+        with open(args.capture, "rb") as f:
+            blob = f.read()
+    except OSError as e:
+        sys.exit("rtu_capdecode: %s" % e)
+
+    char_us = args.bits_per_char * 1e6 / args.baud if args.baud else 0.0
+
+    frames = []
+    wrap = 0
+    last_raw = None
+    for flags, raw, frame in read_records(blob):
+        if last_raw is not None and raw < last_raw and last_raw - raw > 0x80000000:
+            wrap += 1 << 32  # 32-bit timestamp wrapped
+        last_raw = raw
+        t = (raw + wrap) * args.tick_us
+        air = len(frame) * char_us
+        start, end = (t, t + air) if flags & FLAG_TX else (t - air, t)
+        ok = len(frame) >= 4 and crc16(frame[:-2]) == (frame[-2] | (frame[-1] << 8))
+        frames.append({"start": start, "end": end, "air": air, "tx": bool(flags & FLAG_TX),
+                       "ok": ok, "frame": frame})
+
+    if not frames:
+        sys.exit("rtu_capdecode: no records in %s" % args.capture)
+
+    t0 = frames[0]["start"]
+    stats = {}
+    pending = None
+    crc_errors = exceptions = 0
+
+    for fr in frames:
+        frame = fr["frame"]
+        kind = "bad"
+        if fr["ok"]:
+            sid, func = frame[0], frame[1]
+            s = stats.setdefault(sid, {"req": 0, "resp": 0, "exc": 0, "timeout": 0, "turn": []})
+            answers = pending is not None and pending["frame"][0] == sid and \
+                (func & 0x7F) == pending["frame"][1]
+            kind = frame_kind(frame)
+            if fr["tx"]:
+                kind = "resp"
+            elif kind is None:
+                kind = "resp" if answers else "req"
+            if kind == "resp":
+                s["resp"] += 1
+                if func & 0x80:
+                    s["exc"] += 1
+                    exceptions += 1
+                if answers:
+                    s["turn"].append(fr["start"] - pending["end"])
+                    pending = None
+            else:
+                s["req"] += 1
+                if pending is not None:
+                    stats[pending["frame"][0]]["timeout"] += 1
+                pending = fr if sid != 0 else None  # broadcasts are never answered
+        else:
+            crc_errors += 1
+
+        if not args.summary:
+            head = "%12.3f ms  %s" % ((fr["start"] - t0) / 1000.0, "TX" if fr["tx"] else "RX")
+            if kind == "bad":
+                print("%s  CRC error  %s" % (head, frame.hex(" ")))
+            else:
+                print("%s  id=%-3d fc=0x%02X %-4s %s" % (head, frame[0], frame[1], kind,
+                                                         describe(frame, kind == "resp")))
+
+    span = frames[-1]["end"] - t0
+    print()
+    print("frames %d, CRC errors %d, exceptions %d, span %.3f ms"
+          % (len(frames), crc_errors, exceptions, span / 1000.0))
+    if args.baud and span > 0:
+        busy = sum(fr["air"] for fr in frames)
+        print("bus utilisation %.1f %% at %d baud" % (100.0 * busy / span, args.baud))
+    elif not args.baud:
+        print("(pass --baud for airtime-corrected turnaround and bus utilisation)")
+
+    print()
+    print("%5s %6s %6s %5s %8s %10s %10s %10s %10s" %
+          ("slave", "req", "resp", "exc", "no-resp", "min ms", "avg ms", "p99 ms", "max ms"))
+    for sid in sorted(stats):
+        s = stats[sid]
+        turn = [t / 1000.0 for t in s["turn"]]
+        if turn:
+            cols = (min(turn), sum(turn) / len(turn), percentile(turn, 99), max(turn))
+            tt = "%10.3f %10.3f %10.3f %10.3f" % cols
+        else:
+            tt = "%10s %10s %10s %10s" % ("-", "-", "-", "-")
+        print("%5d %6d %6d %5d %8d %s" % (sid, s["req"], s["resp"], s["exc"], s["timeout"], tt))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+rtu_footprint.py - code size and cycle report for slave build configurations
+
+Compiles src/RtuSlave.c once per configuration and prints the section sizes
+(text/data/bss). With a host compiler it also links a small driver that
+serves a 0x04 (Read Input Registers) request in a loop and reports the cost
+per request (TSC cycles on x86, nanoseconds everywhere).
+
+Configurations:
+    full      every function code and register class (library default)
+    minimal   input registers only (0x04), as for a read-only sensor
+    custom    any -D flags given with --define
+
+Usage:
+    python3 tools/rtu_footprint.py
+    python3 tools/rtu_footprint.py --cc arm-none-eabi-gcc --cflags "-mcpu=cortex-m3 -mthumb -Os"
+    python3 tools/rtu_footprint.py --define RTU_FC_WRITE_SINGLE_REG_ENABLE=0
+"""
+
+import argparse
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+MINIMAL = [
+    "RTU_COILS_ENABLE=0",
+    "RTU_DISCRETE_INPUTS_ENABLE=0",
+    "RTU_HOLD_REGS_ENABLE=0",
+    "RTU_FIFO_ENABLE=0",
+    "RTU_FILE_RECORD_ENABLE=0",
+]
+
+DRIVER = r"""
+#include "RtuSlave.h"
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define REGS 16
+#define LOOPS 200000
+
+static uint16_t values[REGS];
+static RTU_RegisterMap_t map[REGS];
+static size_t tx_len;
+
+int RTU_Transmit(uint8_t *data, size_t size)
+{
+    (void)data;
+    tx_len = size;
+    return 0;
+}
+
+int main(void)
+{
+    /* 01 04 0000 0010 (read 16 input registers) */
+    uint8_t req[8] = {0x01, 0x04, 0x00, 0x00, 0x00, REGS, 0xF1, 0xC6};
+
+    RTUSlave_Init();
+    for (int i = 0; i < REGS; i++)
+    {
+        values[i] = (uint16_t)i;
+        map[i].addr = (uint16_t)i;
+        map[i].permiss = RTU_PERMISS_OR;
+        map[i].data = &values[i];
+    }
+    if (RTUSlave_RegisterInputReg(map, REGS) != RTU_OK)
+        return 1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+#ifdef HAVE_TSC
+    unsigned long long c0 = __rdtsc();
+#endif
+    for (long i = 0; i < LOOPS; i++)
+    {
+        RTUSlave_ReceiveCallback(req, sizeof(req));
+        if (RTUSlave_TimerHandler() != RTU_READ_INPUT_REG || tx_len != 5 + REGS * 2)
+            return 2;
+    }
+#ifdef HAVE_TSC
+    unsigned long long c1 = __rdtsc();
+    printf("%.1f", (double)(c1 - c0) / LOOPS);
+#else
+    printf("-");
+#endif
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+    printf(" %.1f\n", ns / LOOPS);
+    return 0;
+}
+"""
+
+
+def run(cmd):
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if res.returncode != 0:
+        raise RuntimeError("%s\n%s" % (" ".join(cmd), res.stderr.strip()))
+    return res.stdout
+
+
+def sizes(size_tool, obj):
+    # berkeley format: text data bss dec hex filename
+    line = run([size_tool, obj]).splitlines()[1].split()
+    return int(line[0]), int(line[1]), int(line[2])
+
+
+def measure(args, name, defines, includes, tmp):
+    dflags = ["-D" + d for d in defines]
+    obj = os.path.join(tmp, name + ".o")
+    run([args.cc] + shlex.split(args.cflags) + dflags + includes +
+        ["-c", os.path.join(ROOT, "src", "RtuSlave.c"), "-o", obj])
+    text, data, bss = sizes(args.size, obj)
+
+    cycles = ns = "-"
+    if not args.no_run:
+        drv = os.path.join(tmp, "driver.c")
+        exe = os.path.join(tmp, name)
+        with open(drv, "w") as f:
+            f.write(DRIVER)
+        try:
+            run([args.cc] + shlex.split(args.cflags) + dflags + includes + [drv, obj, "-o", exe])
+            cycles, ns = run([exe]).split()
+        except (RuntimeError, OSError):
+            pass  # cross compiler: the driver cannot be linked or run on this host
+
+    return [name, text, data, bss, cycles, ns]
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Size and cycle report for RtuSlave.c configurations")
+    ap.add_argument("--cc", default=os.environ.get("CC", "cc"), help="compiler (default: $CC or cc)")
+    ap.add_argument("--size", default=None, help="size tool (default: derived from --cc)")
+    ap.add_argument("--cflags", default="-Os", help="compiler flags (default: -Os)")
+    ap.add_argument("--define", action="append", default=[], help="extra NAME=VALUE for a 'custom' configuration")
+    ap.add_argument("--no-run", action="store_true", help="only report sizes")
+    args = ap.parse_args()
+
+    if args.size is None:
+        cc = os.path.basename(args.cc)
+        args.size = cc[:-3] + "size" if cc.endswith("-gcc") else "size"
+    for tool in (args.cc, args.size):
+        if shutil.which(tool) is None:
+            sys.exit("rtu_footprint: '%s' not found" % tool)
+
+    configs = [("full", []), ("minimal", MINIMAL)]
+    if args.define:
+        configs.append(("custom", args.define))
+
+    tmp = tempfile.mkdtemp(prefix="rtu_footprint_")
+    try:
+        includes = ["-I" + os.path.join(ROOT, "include")]
+        rows = [measure(args, name, defs, includes, tmp) for name, defs in configs]
+    except RuntimeError as e:
+        sys.exit("rtu_footprint: %s" % e)
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+    print("%s %s, 0x04 x16 registers per request" % (args.cc, args.cflags))
+    print("%-8s %8s %6s %6s %12s %10s" % ("config", "text", "data", "bss", "cycles/req", "ns/req"))
+    for r in rows:
+        print("%-8s %8d %6d %6d %12s %10s" % tuple(r))
+
+
+if __name__ == "__main__":
+    main()
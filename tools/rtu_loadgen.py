@@ -0,0 +1,405 @@
+#!/usr/bin/env python3
+"""
+rtu_loadgen.py - end-to-end load generator for a slave built from RtuSlave.c
+
+Builds a small host slave (src/RtuSlave.c plus a termios driver that frames
+requests on the t3.5 silence), connects it to a pseudo-terminal pair and
+acts as the master: it sends a weighted mix of requests back to back and
+reports throughput, turnaround latency percentiles and exception rates per
+baud rate.
+
+A pty moves bytes without pacing them, so the figures are the cost of the
+tty stack, the t3.5 framing and the slave itself. The "wire" column is the
+throughput a real line of that speed would allow for the same mix; the
+slave keeps up as long as tx/s stays close to it. With --port the master
+runs against a real serial device instead (the slave is then external).
+
+Mix entries are fc:qty:weight[:addr] (fc in hex, addr defaults to random
+within the --regs registers the slave maps for every class), e.g.
+    03:10:60,04:16:30,06:1:5,10:8:5     (default)
+    03:10:90,03:4:10:0x200              (10 % illegal-address exceptions)
+
+Usage:
+    python3 tools/rtu_loadgen.py
+    python3 tools/rtu_loadgen.py --baud 9600,19200,115200 --count 5000
+    python3 tools/rtu_loadgen.py --define RTU_RESP_CACHE_SIZE=4 --mix 04:16:1
+    python3 tools/rtu_loadgen.py --port /dev/ttyUSB0 --baud 19200 --id 3
+"""
+
+import argparse
+import os
+import random
+import select
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+import termios
+import time
+import tty
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SLAVE = r"""
+#include "RtuSlave.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+
+static uint16_t hold[REGS], input[REGS];
+static uint8_t coils[REGS], discrete[REGS];
+static RTU_RegisterMap_t hmap[REGS], imap[REGS], cmap[REGS], dmap[REGS];
+static int fd = -1;
+
+int RTU_Transmit(uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+static void map(RTU_RegisterMap_t *m, void *base, size_t width, RTU_Permiss_t permiss)
+{
+    for (int i = 0; i < REGS; i++)
+    {
+        m[i].addr = (uint16_t)i;
+        m[i].permiss = permiss;
+        m[i].data = (uint8_t *)base + (size_t)i * width;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 5)
+        return 2;
+
+    long gap_us = atol(argv[4]);
+    fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return 3;
+
+    struct termios t;
+    if (tcgetattr(fd, &t) == 0)
+    {
+        cfmakeraw(&t);
+        tcsetattr(fd, TCSANOW, &t);
+    }
+
+    RTUSlave_Init();
+    RTUSlave_Modifyid((uint8_t)atoi(argv[3]));
+    for (int i = 0; i < REGS; i++)
+    {
+        hold[i] = (uint16_t)i;
+        input[i] = (uint16_t)(0x1000 + i);
+        discrete[i] = (uint8_t)(i & 1);
+    }
+    map(hmap, hold, sizeof(hold[0]), RTU_PERMISS_RW);
+    map(imap, input, sizeof(input[0]), RTU_PERMISS_OR);
+    map(cmap, coils, sizeof(coils[0]), RTU_PERMISS_RW);
+    map(dmap, discrete, sizeof(discrete[0]), RTU_PERMISS_OR);
+    if (RTUSlave_RegisterHoldReg(hmap, REGS) != RTU_OK || RTUSlave_RegisterInputReg(imap, REGS) != RTU_OK ||
+        RTUSlave_RegisterCoils(cmap, REGS) != RTU_OK || RTUSlave_RegisterDiscreteInput(dmap, REGS) != RTU_OK)
+        return 4;
+
+    /* a frame ends after gap_us of silence (t3.5) */
+    uint8_t frame[256];
+    size_t len = 0;
+    for (;;)
+    {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(fd, &rd);
+        struct timeval tv = {gap_us / 1000000, gap_us % 1000000};
+        int r = select(fd + 1, &rd, NULL, NULL, len ? &tv : NULL);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            return 5;
+
+        if (r == 0 || len == sizeof(frame))
+        {
+            RTUSlave_ReceiveCallback(frame, len);
+            RTUSlave_TimerHandler();
+            len = 0;
+            continue;
+        }
+
+        ssize_t n = read(fd, &frame[len], sizeof(frame) - len);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+            return 0; /* master closed the pty */
+        len += (size_t)n;
+    }
+}
+"""
+
+DEFAULT_MIX = "03:10:60,04:16:30,06:1:5,10:8:5"
+SUPPORTED = (0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x0F, 0x10)
+BITS_PER_CHAR = 11
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def with_crc(pdu):
+    crc = crc16(pdu)
+    return bytes(pdu) + bytes((crc & 0xFF, crc >> 8))
+
+
+def parse_mix(text, regs):
+    mix = []
+    for item in text.split(","):
+        parts = item.strip().split(":")
+        if len(parts) not in (3, 4):
+            raise ValueError("bad mix entry '%s' (fc:qty:weight[:addr])" % item)
+        fc, qty, weight = int(parts[0], 16), int(parts[1], 0), float(parts[2])
+        addr = int(parts[3], 0) if len(parts) == 4 else None
+        if fc not in SUPPORTED:
+            raise ValueError("function code 0x%02X is not supported" % fc)
+        limit = {0x01: 2000, 0x02: 2000, 0x03: 125, 0x04: 125, 0x05: 1, 0x06: 1, 0x0F: 1968, 0x10: 123}[fc]
+        if not 1 <= qty <= limit:
+            raise ValueError("quantity %d out of range for 0x%02X" % (qty, fc))
+        if addr is None and qty > regs:
+            raise ValueError("quantity %d exceeds --regs %d" % (qty, regs))
+        if weight <= 0:
+            raise ValueError("weight must be positive")
+        mix.append((fc, qty, weight, addr))
+    return mix
+
+
+def build_request(sid, fc, qty, addr, rnd):
+    """Return (request, expected normal response length)."""
+    pdu = bytearray((sid, fc, addr >> 8, addr & 0xFF))
+    if fc in (0x01, 0x02):
+        pdu += bytes((qty >> 8, qty & 0xFF))
+        resp = 5 + (qty + 7) // 8
+    elif fc in (0x03, 0x04):
+        pdu += bytes((qty >> 8, qty & 0xFF))
+        resp = 5 + qty * 2
+    elif fc == 0x05:
+        pdu += bytes((0xFF, 0x00) if rnd.random() < 0.5 else (0x00, 0x00))
+        resp = 8
+    elif fc == 0x06:
+        v = rnd.randrange(0x10000)
+        pdu += bytes((v >> 8, v & 0xFF))
+        resp = 8
+    elif fc == 0x0F:
+        nbytes = (qty + 7) // 8
+        pdu += bytes((qty >> 8, qty & 0xFF, nbytes)) + bytes(rnd.randrange(256) for _ in range(nbytes))
+        resp = 8
+    else:
+        pdu += bytes((qty >> 8, qty & 0xFF, qty * 2)) + bytes(rnd.randrange(256) for _ in range(qty * 2))
+        resp = 8
+    return with_crc(pdu), resp
+
+
+def t35_us(baud):
+    # Modbus over serial line 2.5.1.1: fixed 1750 us above 19200 baud
+    return 1750 if baud > 19200 else int(3.5 * BITS_PER_CHAR * 1e6 / baud)
+
+
+def set_speed(fd, baud):
+    attr = termios.tcgetattr(fd)
+    speed = getattr(termios, "B%d" % baud, None)
+    if speed is None:
+        raise ValueError("baud rate %d is not supported by termios" % baud)
+    attr[4] = attr[5] = speed
+    termios.tcsetattr(fd, termios.TCSANOW, attr)
+
+
+def transact(fd, req, expect, timeout):
+    """Send req, return (latency_s, response) or (None, partial) on timeout."""
+    os.write(fd, req)
+    t0 = time.perf_counter()
+    deadline = t0 + timeout
+    resp = b""
+    while True:
+        if len(resp) >= 2 and resp[1] & 0x80:
+            expect = 5
+        if len(resp) >= expect:
+            return time.perf_counter() - t0, resp
+        left = deadline - time.perf_counter()
+        if left <= 0 or not select.select([fd], [], [], left)[0]:
+            return None, resp
+        resp += os.read(fd, 512)
+
+
+def percentile(values, p):
+    # nearest rank
+    k = max(0, min(len(values) - 1, int(-(-p * len(values) // 100)) - 1))
+    return values[k]
+
+
+def run(fd, args, mix, baud, rnd):
+    # t3.5 after the last response: a real master waits for it too
+    gap = t35_us(baud) / 1e6
+    weights = [m[2] for m in mix]
+    lat, wire = [], 0.0
+    per_fc = {}
+    exc = timeouts = crc_err = done = 0
+
+    for _ in range(args.warmup):
+        fc, qty, _w, addr = mix[0]
+        req, expect = build_request(args.id, fc, qty, addr if addr is not None else 0, rnd)
+        transact(fd, req, expect, args.timeout)
+        time.sleep(gap)
+
+    start = time.perf_counter()
+    while done < args.count and time.perf_counter() - start < args.duration:
+        fc, qty, _w, addr = rnd.choices(mix, weights)[0]
+        if addr is None:
+            addr = rnd.randrange(args.regs - qty + 1)
+        req, expect = build_request(args.id, fc, qty, addr, rnd)
+        s = per_fc.setdefault(fc, [0, 0])
+        s[0] += 1
+        done += 1
+
+        latency, resp = transact(fd, req, expect, args.timeout)
+        if latency is None:
+            timeouts += 1
+            termios.tcflush(fd, termios.TCIFLUSH)
+        elif crc16(resp[:-2]) != (resp[-2] | (resp[-1] << 8)) or resp[0] != args.id:
+            crc_err += 1
+        else:
+            lat.append(latency)
+            wire += (len(req) + len(resp)) * BITS_PER_CHAR / baud + 2 * gap
+            if resp[1] & 0x80:
+                exc += 1
+                s[1] += 1
+        time.sleep(gap)
+
+    elapsed = time.perf_counter() - start
+    return {"baud": baud, "done": done, "elapsed": elapsed, "lat": sorted(lat), "wire": wire,
+            "exc": exc, "timeouts": timeouts, "crc": crc_err, "per_fc": per_fc}
+
+
+def report(r):
+    lat = [v * 1000.0 for v in r["lat"]]
+    ok = len(lat)
+    tps = r["done"] / r["elapsed"] if r["elapsed"] > 0 else 0.0
+    wire_tps = ok / r["wire"] if r["wire"] > 0 else 0.0
+    if lat:
+        pct = "%8.3f %8.3f %8.3f %8.3f" % (percentile(lat, 50), percentile(lat, 99), percentile(lat, 99.9), lat[-1])
+    else:
+        pct = "%8s %8s %8s %8s" % ("-", "-", "-", "-")
+    print("%7d %7d %9.1f %9.1f %s %7.2f %6d %5d" % (r["baud"], r["done"], tps, wire_tps, pct,
+                                                   100.0 * r["exc"] / max(1, r["done"]), r["timeouts"], r["crc"]))
+
+
+def build_slave(args, tmp):
+    drv = os.path.join(tmp, "slave.c")
+    exe = os.path.join(tmp, "slave")
+    with open(drv, "w") as f:
+        f.write(SLAVE)
+    cmd = ([args.cc] + shlex.split(args.cflags) + ["-D" + d for d in args.define] +
+           ["-DREGS=%d" % args.regs, "-I" + os.path.join(ROOT, "include"),
+            drv, os.path.join(ROOT, "src", "RtuSlave.c"), os.path.join(ROOT, "src", "RtuKernels.c"),
+            "-o", exe])
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if res.returncode != 0:
+        raise RuntimeError("%s\n%s" % (" ".join(cmd), res.stderr.strip()))
+    return exe
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Drive an RtuSlave.c slave over a pty and measure it")
+    ap.add_argument("--baud", default="19200,115200", help="comma separated baud rates (default 19200,115200)")
+    ap.add_argument("--mix", default=DEFAULT_MIX, help="fc:qty:weight[:addr],... (default %s)" % DEFAULT_MIX)
+    ap.add_argument("--count", type=int, default=2000, help="transactions per baud rate (default 2000)")
+    ap.add_argument("--duration", type=float, default=60.0, help="time limit per baud rate in s (default 60)")
+    ap.add_argument("--warmup", type=int, default=20, help="untimed transactions first (default 20)")
+    ap.add_argument("--timeout", type=float, default=0.5, help="response timeout in s (default 0.5)")
+    ap.add_argument("--id", type=int, default=1, help="slave id (default 1)")
+    ap.add_argument("--regs", type=int, default=100, help="registers the slave maps per class (default 100, max 128)")
+    ap.add_argument("--seed", type=int, default=1, help="random seed (default 1)")
+    ap.add_argument("--gap-us", type=int, default=None, help="slave frame gap, default t3.5 of the baud rate")
+    ap.add_argument("--port", default=None, help="real serial device; no slave is built or started")
+    ap.add_argument("--cc", default=os.environ.get("CC", "cc"), help="compiler (default: $CC or cc)")
+    ap.add_argument("--cflags", default="-O2", help="compiler flags (default: -O2)")
+    ap.add_argument("--define", action="append", default=[], help="NAME=VALUE for the slave build")
+    args = ap.parse_args()
+
+    try:
+        bauds = [int(b) for b in args.baud.split(",")]
+        if not 1 <= args.regs <= 128 or not 1 <= args.id <= 247:
+            raise ValueError("--regs must be 1..128 and --id 1..247")
+        mix = parse_mix(args.mix, args.regs)
+    except ValueError as e:
+        sys.exit("rtu_loadgen: %s" % e)
+
+    tmp = tempfile.mkdtemp(prefix="rtu_loadgen_")
+    results = []
+    try:
+        exe = None
+        if args.port is None:
+            if shutil.which(args.cc) is None:
+                sys.exit("rtu_loadgen: '%s' not found" % args.cc)
+            exe = build_slave(args, tmp)
+
+        for baud in bauds:
+            rnd = random.Random(args.seed)
+            if args.port is not None:
+                fd = os.open(args.port, os.O_RDWR | os.O_NOCTTY)
+                tty.setraw(fd)
+                set_speed(fd, baud)
+                try:
+                    results.append(run(fd, args, mix, baud, rnd))
+                finally:
+                    os.close(fd)
+                continue
+
+            master, slave = os.openpty()
+            tty.setraw(master)
+            set_speed(slave, baud)
+            gap = args.gap_us if args.gap_us is not None else t35_us(baud)
+            proc = subprocess.Popen([exe, os.ttyname(slave), str(baud), str(args.id), str(gap)])
+            try:
+                results.append(run(master, args, mix, baud, rnd))
+            finally:
+                os.close(master)
+                os.close(slave)
+                try:
+                    proc.wait(timeout=2)
+                except subprocess.TimeoutExpired:
+                    proc.kill()
+    except (RuntimeError, OSError, ValueError) as e:
+        sys.exit("rtu_loadgen: %s" % e)
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+    print("mix %s, %s" % (args.mix, "port " + args.port if args.port else "pty, " + " ".join([args.cflags] + args.define)))
+    print("%7s %7s %9s %9s %8s %8s %8s %8s %7s %6s %5s" % ("baud", "trans", "tx/s", "wire tx/s", "p50 ms",
+                                                          "p99 ms", "p99.9 ms", "max ms", "exc %", "t/o", "crc"))
+    for r in results:
+        report(r)
+
+    print()
+    print("exceptions by function code:")
+    for r in results:
+        row = ", ".join("0x%02X %d/%d" % (fc, s[1], s[0]) for fc, s in sorted(r["per_fc"].items()))
+        print("%7d  %s" % (r["baud"], row))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,253 @@
+#!/usr/bin/env python3
+"""
+rtu_mapgen.py - Modbus RTU register map generator
+
+Turns a CSV or JSON register description into a C source/header pair with
+const, address-sorted RTU_Register_t tables (flash resident, registered with
+RTUSlave_RegisterTable()), the backing variables and typed accessors.
+
+Columns / keys:
+    class     coil | discrete | holding | input
+    address   register address (decimal or 0x hex)
+    name      C identifier of the backing variable
+    type      u16 | i16 | bit         (default: bit for coil/discrete, u16 otherwise)
+              u32 | i32 | f32 | u64 | i64 | f64   (holding/input, 2 or 4 registers,
+              needs RTU_TYPED_REGS)
+    access    ro | rw                 (default: rw for coil/holding, ro otherwise)
+    callback  optional RTUSlave_Func_t implemented by the application
+    group     optional seqlock group name (RTU_RegGroup_t)
+    default   optional initial value
+    order     abcd | cdab | badc | dcba   word order of 32/64-bit types (default abcd)
+
+Usage:
+    python3 tools/rtu_mapgen.py regmap.csv -o build/regmap --prefix dev
+    -> build/regmap.h, build/regmap.c
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import sys
+
+CLASSES = {
+    # name: (RTU_RegClass_t, table suffix)
+    "coil": ("RTU_CLASS_COILS", "coils"),
+    "discrete": ("RTU_CLASS_DISCRETE_INPUTS", "discrete_inputs"),
+    "holding": ("RTU_CLASS_HOLDING_REGS", "holding_regs"),
+    "input": ("RTU_CLASS_INPUT_REGS", "input_regs"),
+}
+
+TYPES = {"u16": "uint16_t", "i16": "int16_t", "bit": "uint8_t",
+         "u32": "uint32_t", "i32": "int32_t", "f32": "float",
+         "u64": "uint64_t", "i64": "int64_t", "f64": "double"}
+
+# registers covered by one entry, RTU_RegType_t of the typed ones
+WORDS = {"u32": 2, "i32": 2, "f32": 2, "u64": 4, "i64": 4, "f64": 4}
+REG_TYPES = {"u32": "RTU_TYPE_U32", "i32": "RTU_TYPE_I32", "f32": "RTU_TYPE_F32",
+             "u64": "RTU_TYPE_U64", "i64": "RTU_TYPE_I64", "f64": "RTU_TYPE_F64"}
+ORDERS = ("abcd", "cdab", "badc", "dcba")
+
+IDENT = re.compile(r"^[A-Za-z_][A-Za-z0-9_]*$")
+
+
+class MapError(Exception):
+    pass
+
+
+def load_rows(path):
+    with open(path, newline="", encoding="utf-8") as f:
+        if path.lower().endswith(".json"):
+            data = json.load(f)
+            if isinstance(data, dict):
+                data = data.get("registers", [])
+            return [{k: ("" if v is None else str(v)) for k, v in row.items()} for row in data]
+
+        lines = [line for line in f if line.strip() and not line.lstrip().startswith("#")]
+        return list(csv.DictReader(lines))
+
+
+def parse_row(row, lineno):
+    def field(key, default=""):
+        return (row.get(key) or default).strip()
+
+    cls = field("class").lower()
+    if cls not in CLASSES:
+        raise MapError("entry %d: unknown class '%s'" % (lineno, cls))
+
+    try:
+        address = int(field("address"), 0)
+    except ValueError:
+        raise MapError("entry %d: bad address '%s'" % (lineno, field("address")))
+    if not 0 <= address <= 0xFFFF:
+        raise MapError("entry %d: address out of range" % lineno)
+
+    name = field("name")
+    if not IDENT.match(name):
+        raise MapError("entry %d: bad name '%s'" % (lineno, name))
+
+    bit_class = cls in ("coil", "discrete")
+    ctype = field("type", "bit" if bit_class else "u16").lower()
+    if ctype not in TYPES or (ctype == "bit") != bit_class:
+        raise MapError("entry %d: type '%s' does not fit class '%s'" % (lineno, ctype, cls))
+    if address + WORDS.get(ctype, 1) - 1 > 0xFFFF:
+        raise MapError("entry %d: %s value runs past address 0xFFFF" % (lineno, ctype))
+
+    order = field("order", "abcd").lower()
+    if order not in ORDERS:
+        raise MapError("entry %d: bad order '%s'" % (lineno, order))
+
+    access = field("access", "rw" if cls in ("coil", "holding") else "ro").lower()
+    if access not in ("ro", "rw"):
+        raise MapError("entry %d: bad access '%s'" % (lineno, access))
+    if cls in ("discrete", "input"):
+        access = "ro"
+
+    callback = field("callback")
+    group = field("group")
+    for ident in (callback, group):
+        if ident and not IDENT.match(ident):
+            raise MapError("entry %d: bad identifier '%s'" % (lineno, ident))
+
+    default = field("default", "0")
+    try:
+        if ctype in ("f32", "f64"):
+            float(default)
+        else:
+            int(default, 0)
+    except ValueError:
+        raise MapError("entry %d: bad default '%s'" % (lineno, default))
+
+    return {
+        "class": cls, "address": address, "name": name, "type": ctype,
+        "access": access, "callback": callback, "group": group, "default": default,
+        "order": order,
+    }
+
+
+def build(rows):
+    regs = [parse_row(row, i + 1) for i, row in enumerate(rows)]
+
+    names = set()
+    for r in regs:
+        if r["name"] in names:
+            raise MapError("duplicate name '%s'" % r["name"])
+        names.add(r["name"])
+
+    tables = {}
+    for cls in CLASSES:
+        entries = sorted((r for r in regs if r["class"] == cls), key=lambda r: r["address"])
+        for a, b in zip(entries, entries[1:]):
+            if a["address"] == b["address"]:
+                raise MapError("duplicate %s address 0x%04X" % (cls, a["address"]))
+            if a["address"] + WORDS.get(a["type"], 1) > b["address"]:
+                raise MapError("%s '%s' at 0x%04X overlaps '%s'" % (a["type"], a["name"], a["address"], b["name"]))
+        tables[cls] = entries
+    return regs, tables
+
+
+def emit(regs, tables, prefix, header_name, source):
+    guard = re.sub(r"[^A-Za-z0-9]", "_", header_name).upper()
+    groups = sorted({r["group"] for r in regs if r["group"]})
+    callbacks = sorted({r["callback"] for r in regs if r["callback"]})
+    banner = "/* Generated by tools/rtu_mapgen.py from %s. Do not edit. */\n" % os.path.basename(source)
+
+    h = [banner, "#ifndef %s" % guard, "#define %s" % guard, "", '#include "RtuSlave.h"', ""]
+    if any(r["type"] in WORDS for r in regs):
+        h += ["#if !RTU_TYPED_REGS", '#error "32/64-bit register entries need RTU_TYPED_REGS"', "#endif", ""]
+    h += ["#ifdef __cplusplus", 'extern "C" {', "#endif", ""]
+
+    for cls, entries in tables.items():
+        if entries:
+            h.append("#define %s_%s_NUM (%dU)" % (prefix.upper(), CLASSES[cls][1].upper(), len(entries)))
+    h.append("")
+
+    for g in groups:
+        h.append("extern RTU_RegGroup_t %s_%s;" % (prefix, g))
+    for r in regs:
+        h.append("extern %s %s_%s;" % (TYPES[r["type"]], prefix, r["name"]))
+    h.append("")
+
+    for cls, entries in tables.items():
+        if entries:
+            h.append("extern const RTU_Register_t %s_%s[%d];" % (prefix, CLASSES[cls][1], len(entries)))
+    h.append("")
+
+    if callbacks:
+        h.append("/* implemented by the application */")
+        for cb in callbacks:
+            h.append("extern RTU_ExceptionCode_t %s(RTU_Ctx_t *ctx);" % cb)
+        h.append("")
+
+    for r in regs:
+        ct = TYPES[r["type"]]
+        var = "%s_%s" % (prefix, r["name"])
+        h.append("static inline %s %s_get_%s(void) { return *(volatile %s *)&%s; }" % (ct, prefix, r["name"], ct, var))
+        h.append("static inline void %s_set_%s(%s v) { *(volatile %s *)&%s = v; }" % (prefix, r["name"], ct, ct, var))
+    h.append("")
+
+    h += ["/* Register every generated table with RTUSlave_RegisterTable() */",
+          "extern RTU_Sta_t %s_RegisterMap(void);" % prefix, "",
+          "#ifdef __cplusplus", "}", "#endif", "", "#endif /* %s */" % guard, ""]
+
+    c = [banner, '#include "%s"' % header_name, ""]
+    for g in groups:
+        c.append("RTU_RegGroup_t %s_%s;" % (prefix, g))
+    for r in regs:
+        c.append("%s %s_%s = %s;" % (TYPES[r["type"]], prefix, r["name"], r["default"]))
+    c.append("")
+
+    for cls, entries in tables.items():
+        if not entries:
+            continue
+        table = "%s_%s" % (prefix, CLASSES[cls][1])
+        c.append("const RTU_Register_t %s[%d] = {" % (table, len(entries)))
+        for i, r in enumerate(entries):
+            nxt = "(RTU_Register_t *)&%s[%d]" % (table, i + 1) if i + 1 < len(entries) else "NULL"
+            typed = ""
+            if r["type"] in WORDS:
+                typed = " .type = RTU_REG_TYPE(%s, RTU_ORDER_%s)," % (REG_TYPES[r["type"]], r["order"].upper())
+            c.append("    { .address = 0x%04X, .permiss = %s,%s .callback = %s, .value = &%s_%s, .group = %s, .next = %s },"
+                     % (r["address"], "RTU_PERMISS_RW" if r["access"] == "rw" else "RTU_PERMISS_OR", typed,
+                        r["callback"] or "NULL", prefix, r["name"],
+                        "&%s_%s" % (prefix, r["group"]) if r["group"] else "NULL", nxt))
+        c += ["};", ""]
+
+    c += ["RTU_Sta_t %s_RegisterMap(void)" % prefix, "{"]
+    for cls, entries in tables.items():
+        if entries:
+            c.append("    if (RTUSlave_RegisterTable(%s, %s_%s, %d) != RTU_OK)"
+                     % (CLASSES[cls][0], prefix, CLASSES[cls][1], len(entries)))
+            c.append("        return RTU_ERR;")
+    c += ["", "    return RTU_OK;", "}", ""]
+
+    return "\n".join(h), "\n".join(c)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Generate const Modbus RTU register tables")
+    ap.add_argument("input", help="register description (.csv or .json)")
+    ap.add_argument("-o", "--output", required=True, help="output path without extension")
+    ap.add_argument("--prefix", default="rtu_map", help="C identifier prefix (default: rtu_map)")
+    args = ap.parse_args()
+
+    if not IDENT.match(args.prefix):
+        sys.exit("rtu_mapgen: bad prefix '%s'" % args.prefix)
+
+    try:
+        regs, tables = build(load_rows(args.input))
+    except (MapError, OSError, ValueError) as e:
+        sys.exit("rtu_mapgen: %s" % e)
+
+    header_name = os.path.basename(args.output) + ".h"
+    header, source = emit(regs, tables, args.prefix, header_name, args.input)
+
+    with open(args.output + ".h", "w", encoding="utf-8") as f:
+        f.write(header)
+    with open(args.output + ".c", "w", encoding="utf-8") as f:
+        f.write(source)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,600 @@
+#!/usr/bin/env python3
+"""
+rtu_mastertest.py - self-checking tests of the non-blocking master
+
+Builds a host program around src/RtuMaster.c (included, so the static
+timer wheel can be driven directly) with a fake transmit function and a
+simulated microsecond clock, and runs it for several configurations:
+- fixed: default timing
+- adaptive: RTU_MASTER_ADAPTIVE=1, also checks the turnaround statistics
+- small-wheel: a 3-level wheel of 4 slots, so long timers are clamped and
+  cascade on every few ticks (wheel checks only)
+
+Checked:
+- wheel: randomized arm / stop / re-arm (also from callbacks) across the
+  wraparound of both the microsecond and the tick counter; every timer
+  fires exactly on its tick, and RTUMaster_NextTimeout() never overshoots
+- line: request frames, OK / exception / CRC / bad response / timeout /
+  transmit error / cancel results, broadcasts, re-submitting from the done
+  callback, and the t3.5 gap between transactions
+- adaptive: samples, mean, learned timeout, reset on timeout, draining a
+  late answer, RTUMaster_ResetStats()
+
+Exits with status 1 if any check fails.
+
+Usage:
+    python3 tools/rtu_mastertest.py
+    python3 tools/rtu_mastertest.py --seed 7 --iterations 1000000
+    python3 tools/rtu_mastertest.py --cflags "-O1 -fsanitize=address,undefined"
+"""
+
+import argparse
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+TEST = r"""
+#include "RtuMaster.c" /* white box: the wheel internals are static */
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned checks, fails;
+
+#define CHECK(c)                                                         \
+    do                                                                   \
+    {                                                                    \
+        checks++;                                                        \
+        if (!(c))                                                        \
+        {                                                                \
+            if (fails++ < 20)                                            \
+                printf("FAIL %s:%d: %s\n", __func__, __LINE__, #c);      \
+        }                                                                \
+    } while (0)
+
+static uint64_t rng = SEED;
+
+static uint32_t rnd(uint32_t n)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint32_t)(rng % n);
+}
+
+/* ------------------------------------------------------------ wheel */
+
+#define NTIMERS 64
+
+typedef struct
+{
+    RTU_Timer_t t; // first member: the callback casts back
+    uint32_t due;
+    int armed;
+} test_timer_t;
+
+static RTU_TimerWheel_t wheel;
+static test_timer_t timers[NTIMERS];
+static unsigned fired;
+
+static uint32_t rnd_ticks(void)
+{
+    switch (rnd(4))
+    {
+    case 0:
+        return rnd(3); // 0 means the next tick as well
+    case 1:
+        return rnd(RTU_WHEEL_SLOTS);
+    case 2:
+        return rnd(RTU_WHEEL_SLOTS * RTU_WHEEL_SLOTS);
+    default:
+        return rnd((uint32_t)RTU_WHEEL_SPAN + 8U); // past the span: clamped
+    }
+}
+
+static void arm(test_timer_t *x, uint32_t ticks)
+{
+    rtu_timer_start(&wheel, &x->t, ticks);
+    uint32_t d = (ticks == 0) ? 1U : (ticks >= RTU_WHEEL_SPAN) ? (uint32_t)RTU_WHEEL_SPAN - 1U : ticks;
+    x->due = wheel.now + d;
+    x->armed = 1;
+}
+
+static void disarm(test_timer_t *x)
+{
+    rtu_timer_stop(&wheel, &x->t);
+    x->armed = 0;
+}
+
+static void on_fire(RTU_Timer_t *t)
+{
+    test_timer_t *x = (test_timer_t *)t;
+    CHECK(x->armed && wheel.now == x->due);
+    x->armed = 0;
+    fired++;
+
+    /* callbacks may re-arm themselves and stop or re-arm any other timer,
+       including one due on this same tick */
+    if (rnd(3) == 0)
+        arm(x, rnd_ticks());
+    if (rnd(8) == 0)
+        disarm(&timers[rnd(NTIMERS)]);
+    if (rnd(8) == 0)
+        arm(&timers[rnd(NTIMERS)], rnd(4));
+}
+
+static void check_wheel(void)
+{
+    size_t armed = 0;
+    uint32_t nearest = UINT32_MAX;
+    for (size_t i = 0; i < NTIMERS; i++)
+    {
+        if (!timers[i].armed)
+            continue;
+        armed++;
+        uint32_t left = timers[i].due - wheel.now;
+        CHECK(left >= 1U && left < RTU_WHEEL_SPAN); // nothing overdue left behind
+        if (left < nearest)
+            nearest = left;
+    }
+    CHECK(wheel.armed == armed);
+
+    uint32_t next = RTUMaster_NextTimeout(&wheel);
+    if (armed == 0)
+        CHECK(next == UINT32_MAX);
+    else
+        CHECK(next >= RTU_MASTER_TICK_US && next % RTU_MASTER_TICK_US == 0 &&
+              next / RTU_MASTER_TICK_US <= nearest);
+}
+
+static void test_wheel(unsigned iterations)
+{
+    /* both counters wrap early in the run */
+    uint32_t us = UINT32_MAX - 1000U * RTU_MASTER_TICK_US;
+    RTUMaster_WheelInit(&wheel, us);
+    wheel.now = UINT32_MAX - 300U;
+    for (size_t i = 0; i < NTIMERS; i++)
+        timers[i].t.fire = on_fire;
+
+    for (unsigned it = 0; it < iterations; it++)
+    {
+        test_timer_t *x = &timers[rnd(NTIMERS)];
+        if (rnd(4) == 0)
+            disarm(x);
+        else
+            arm(x, rnd_ticks());
+        check_wheel();
+
+        /* sleep like an event loop: the full timeout, less, or idle time */
+        uint32_t next = RTUMaster_NextTimeout(&wheel);
+        if (next == UINT32_MAX)
+            us += rnd(1000000);
+        else
+            us += (rnd(4) == 0) ? rnd(next + 1U) : next;
+        RTUMaster_Tick(&wheel, us);
+        check_wheel();
+    }
+
+    for (unsigned guard = 0; wheel.armed != 0 && guard < 100000000U; guard++)
+    {
+        us += RTUMaster_NextTimeout(&wheel);
+        RTUMaster_Tick(&wheel, us);
+    }
+    check_wheel();
+    CHECK(fired > iterations / 4U);
+}
+
+#ifndef WHEEL_ONLY
+/* ------------------------------------------------------------- line */
+
+#define LINE_TIMEOUT_US 20000U
+
+static RTU_TimerWheel_t lineWheel;
+static RTU_Master_t line;
+static uint32_t nowUs;
+
+static uint8_t txFrame[RTU_MASTER_BUF_SIZE];
+static size_t txLen;
+static unsigned txCount;
+static uint32_t txAt;
+static int txFail;
+
+static unsigned doneCount;
+static uint32_t doneAt;
+
+static uint16_t crc16(const uint8_t *b, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t p = 0; p < len; p++)
+    {
+        crc ^= b[p];
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 1U) ? (uint16_t)((crc >> 1) ^ 0xA001U) : (uint16_t)(crc >> 1);
+    }
+    return crc;
+}
+
+static int fake_tx(void *user, const uint8_t *data, size_t len)
+{
+    (void)user;
+    memcpy(txFrame, data, len);
+    txLen = len;
+    txCount++;
+    txAt = nowUs;
+    return txFail ? -1 : 0;
+}
+
+static void on_done(RTU_MasterReq_t *req)
+{
+    (void)req;
+    doneCount++;
+    doneAt = nowUs;
+}
+
+/* Advance the clock in 50 us steps, like an event loop woken by the UART */
+static void run_for(uint32_t us)
+{
+    uint32_t end = nowUs + us;
+    while ((int32_t)(end - nowUs) > 0)
+    {
+        nowUs += ((end - nowUs) < 50U) ? (end - nowUs) : 50U;
+        RTUMaster_Tick(&lineWheel, nowUs);
+    }
+}
+
+static uint32_t air_us(uint32_t baud, size_t len)
+{
+    return (uint32_t)((len * 11U * 1000000ULL + baud - 1U) / baud);
+}
+
+/* Frame pdu with its CRC; corrupt flips a CRC bit */
+static size_t frame(uint8_t *f, const uint8_t *pdu, size_t len, int corrupt)
+{
+    memcpy(f, pdu, len);
+    uint16_t crc = crc16(f, len);
+    f[len] = (uint8_t)(crc & 0xFF);
+    f[len + 1] = (uint8_t)((crc >> 8) ^ (corrupt ? 1U : 0U));
+    return len + 2U;
+}
+
+/* Response in two chunks, the way a UART hands it over */
+static void reply(const uint8_t *pdu, size_t len, int corrupt)
+{
+    uint8_t f[RTU_MASTER_BUF_SIZE];
+    size_t n = frame(f, pdu, len, corrupt);
+    RTUMaster_RxBytes(&line, f, 3);
+    RTUMaster_RxBytes(&line, f + 3, n - 3U);
+}
+
+static void line_setup(uint32_t baud)
+{
+    nowUs = 0x7FFFFF00U;
+    RTUMaster_WheelInit(&lineWheel, nowUs);
+    CHECK(RTUMaster_Init(&line, &lineWheel, baud, fake_tx, NULL) == RTU_OK);
+    RTUMaster_SetTimeout(&line, LINE_TIMEOUT_US);
+    txCount = doneCount = 0;
+    txFail = 0;
+}
+
+static uint16_t regs[4];
+
+static RTU_MasterReq_t read_req(uint8_t id)
+{
+    RTU_MasterReq_t r = {.id = id, .func = RTU_FUNC_READ_HOLD_REGS, .addr = 0x0010, .num = 2,
+                         .data = regs, .done = on_done};
+    return r;
+}
+
+static void test_results(void)
+{
+    line_setup(19200);
+    RTU_MasterReq_t r = read_req(7);
+    static const uint8_t resp[] = {7, 0x03, 4, 0x12, 0x34, 0xAB, 0xCD};
+
+    /* OK: request frame on the wire, data stored */
+    uint8_t want[8];
+    frame(want, (const uint8_t[]){7, 0x03, 0x00, 0x10, 0x00, 0x02}, 6, 0);
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    CHECK(txCount == 1 && txLen == 8 && memcmp(txFrame, want, 8) == 0);
+    CHECK(RTUMaster_Outstanding(&line) == 1);
+    run_for(8000);
+    reply(resp, sizeof(resp), 0);
+    CHECK(doneCount == 1 && r.result == RTU_MRES_OK && regs[0] == 0x1234 && regs[1] == 0xABCD);
+    CHECK(RTUMaster_Outstanding(&line) == 0 && line.count.ok == 1);
+
+    /* exception */
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    run_for(8000);
+    reply((const uint8_t[]){7, 0x83, RTU_EX_ILLEGAL_ADDR}, 3, 0);
+    CHECK(doneCount == 2 && r.result == RTU_MRES_EXCEPTION && r.exception == RTU_EX_ILLEGAL_ADDR);
+    CHECK(line.count.exceptions == 1);
+
+    /* bad CRC */
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    run_for(8000);
+    reply(resp, sizeof(resp), 1);
+    CHECK(doneCount == 3 && r.result == RTU_MRES_CRC && line.count.crcErrors == 1);
+
+    /* valid frame from another slave */
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    run_for(8000);
+    reply((const uint8_t[]){8, 0x03, 4, 0, 0, 0, 0}, 7, 0);
+    CHECK(doneCount == 4 && r.result == RTU_MRES_BAD_RESPONSE && line.count.badResponses == 1);
+
+    /* timeout counted from the end of the request */
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    uint32_t sent = txAt;
+    run_for(air_us(19200, 8) + LINE_TIMEOUT_US - 500U);
+    CHECK(doneCount == 4);
+    run_for(air_us(19200, 9) + 1000U);
+    CHECK(doneCount == 5 && r.result == RTU_MRES_TIMEOUT && line.count.timeouts == 1);
+    CHECK(doneAt - sent >= air_us(19200, 8) + LINE_TIMEOUT_US);
+
+    /* a silent fragment ends on t3.5 and is no response */
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    run_for(8000);
+    RTUMaster_RxBytes(&line, resp, 3);
+    run_for(2500);
+    CHECK(doneCount == 6 && r.result == RTU_MRES_TIMEOUT);
+
+    /* transmit error */
+    run_for(3000);
+    txFail = 1;
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    CHECK(doneCount == 7 && r.result == RTU_MRES_TX_ERR);
+    txFail = 0;
+
+    /* invalid requests are refused */
+    RTU_MasterReq_t bad = read_req(7);
+    bad.num = 126;
+    CHECK(RTUMaster_Submit(&line, &bad) == RTU_ERR);
+    bad = read_req(RTU_BROADCAST_ID);
+    CHECK(RTUMaster_Submit(&line, &bad) == RTU_ERR);
+}
+
+static void test_writes(void)
+{
+    line_setup(19200);
+
+    /* 0x10: big endian values, echo of address and quantity */
+    uint16_t vals[2] = {0x0102, 0xA0B0};
+    RTU_MasterReq_t w = {.id = 5, .func = RTU_FUNC_MULTIPLE_WRITE_REG, .addr = 0x0020, .num = 2,
+                         .data = vals, .done = on_done};
+    uint8_t want[13];
+    frame(want, (const uint8_t[]){5, 0x10, 0x00, 0x20, 0x00, 0x02, 4, 0x01, 0x02, 0xA0, 0xB0}, 11, 0);
+    CHECK(RTUMaster_Submit(&line, &w) == RTU_OK);
+    CHECK(txLen == 13 && memcmp(txFrame, want, 13) == 0);
+    run_for(10000);
+    reply((const uint8_t[]){5, 0x10, 0x00, 0x20, 0x00, 0x02}, 6, 0);
+    CHECK(doneCount == 1 && w.result == RTU_MRES_OK);
+
+    /* 0x06 with a wrong echo */
+    uint16_t one = 0x1234;
+    RTU_MasterReq_t s = {.id = 5, .func = RTU_FUNC_WRITE_SINGLE_REG, .addr = 0x0001, .data = &one, .done = on_done};
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &s) == RTU_OK);
+    run_for(8000);
+    reply((const uint8_t[]){5, 0x06, 0x00, 0x01, 0x12, 0x35}, 6, 0);
+    CHECK(doneCount == 2 && s.result == RTU_MRES_BAD_RESPONSE);
+
+    /* broadcast: no answer, done after the broadcast delay */
+    s.id = RTU_BROADCAST_ID;
+    run_for(3000);
+    CHECK(RTUMaster_Submit(&line, &s) == RTU_OK);
+    uint32_t sent = txAt;
+    run_for(air_us(19200, 8) + RTU_MASTER_BCAST_DELAY_MS * 1000U - 500U);
+    CHECK(doneCount == 2);
+    run_for(1000);
+    CHECK(doneCount == 3 && s.result == RTU_MRES_OK);
+    CHECK(doneAt - sent >= RTU_MASTER_BCAST_DELAY_MS * 1000U);
+}
+
+static unsigned chain;
+
+static void on_chain(RTU_MasterReq_t *req)
+{
+    on_done(req);
+    if (req->result == RTU_MRES_OK && ++chain < 5)
+        CHECK(RTUMaster_Submit(&line, req) == RTU_OK); // keep the poll cycle going
+}
+
+static void test_queue(void)
+{
+    line_setup(115200);
+
+    /* requests queue in order and wait for the t3.5 gap between transactions */
+    RTU_MasterReq_t a = read_req(1), b = read_req(2), c = read_req(3);
+    CHECK(RTUMaster_Submit(&line, &a) == RTU_OK);
+    CHECK(RTUMaster_Submit(&line, &b) == RTU_OK);
+    CHECK(RTUMaster_Submit(&line, &c) == RTU_OK);
+    CHECK(txCount == 1 && txFrame[0] == 1 && RTUMaster_Outstanding(&line) == 3);
+
+    CHECK(RTUMaster_Cancel(&line, &b) == RTU_OK && b.result == RTU_MRES_CANCELLED);
+    CHECK(RTUMaster_Cancel(&line, &a) == RTU_NOACTIVE); // already sent
+    CHECK(RTUMaster_Outstanding(&line) == 2);
+
+    run_for(2000);
+    reply((const uint8_t[]){1, 0x03, 4, 0, 1, 0, 2}, 7, 0);
+    uint32_t end = nowUs;
+    CHECK(a.result == RTU_MRES_OK && txCount == 1);
+
+#if RTU_MASTER_EXACT_GAP
+    uint32_t gap = (38500000U + 115200U - 1U) / 115200U;
+#else
+    uint32_t gap = 1750U; // fixed t3.5 above 19200 baud
+#endif
+    run_for(gap + 2U * RTU_MASTER_TICK_US + 50U);
+    CHECK(txCount == 2 && txFrame[0] == 3);
+    CHECK(txAt - end >= gap && txAt - end < gap + 2U * RTU_MASTER_TICK_US + 50U);
+
+    /* done callbacks may submit again */
+    run_for(2000);
+    reply((const uint8_t[]){3, 0x03, 4, 0, 1, 0, 2}, 7, 0);
+    RTU_MasterReq_t p = read_req(4);
+    p.done = on_chain;
+    chain = 0;
+    CHECK(RTUMaster_Submit(&line, &p) == RTU_OK);
+    for (int i = 0; i < 10 && RTUMaster_Outstanding(&line) != 0; i++)
+    {
+        run_for(3000);
+        reply((const uint8_t[]){4, 0x03, 4, 0, 1, 0, 2}, 7, 0);
+    }
+    CHECK(chain == 5 && RTUMaster_Outstanding(&line) == 0);
+}
+
+static void test_adaptive(void)
+{
+    RTU_MasterSlaveStats_t st;
+    line_setup(19200);
+#if RTU_MASTER_ADAPTIVE
+    const uint32_t lineTimeout = 100000U, turn = 5000U;
+    RTUMaster_SetTimeout(&line, lineTimeout);
+    CHECK(RTUMaster_SlaveStats(&line, 3, &st) == RTU_NOACTIVE);
+
+    uint8_t f[16];
+    size_t n = frame(f, (const uint8_t[]){3, 0x03, 4, 0, 1, 0, 2}, 7, 0);
+    RTU_MasterReq_t r = read_req(3);
+    for (unsigned i = 0; i < RTU_MASTER_ADAPT_SAMPLES + 8U; i++)
+    {
+        if (i == RTU_MASTER_ADAPT_SAMPLES - 1U)
+        {
+            CHECK(RTUMaster_SlaveStats(&line, 3, &st) == RTU_OK);
+            CHECK(st.samples == i && st.timeoutUs == lineTimeout); // not learned yet
+        }
+        CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+        run_for(air_us(19200, 8) + turn + air_us(19200, n));
+        RTUMaster_RxFrame(&line, f, n);
+        CHECK(r.result == RTU_MRES_OK);
+        run_for(3000);
+    }
+
+    CHECK(RTUMaster_SlaveStats(&line, 3, &st) == RTU_OK);
+    CHECK(st.samples == RTU_MASTER_ADAPT_SAMPLES + 8U && st.timeouts == 0);
+    CHECK(st.meanUs + 2U * RTU_MASTER_TICK_US + 100U >= turn && st.meanUs <= turn + 2U * RTU_MASTER_TICK_US + 100U);
+    CHECK(st.minUs <= st.meanUs && st.meanUs <= st.maxUs);
+    CHECK(st.timeoutUs >= RTU_MASTER_ADAPT_FLOOR_US && st.timeoutUs >= st.meanUs && st.timeoutUs < lineTimeout);
+
+    /* a learned timeout runs out well before the line timeout */
+    uint32_t learned = st.timeoutUs;
+    unsigned before = doneCount;
+    CHECK(RTUMaster_Submit(&line, &r) == RTU_OK);
+    uint32_t sent = txAt;
+    for (int i = 0; i < 4000 && doneCount == before; i++)
+        run_for(50);
+    CHECK(r.result == RTU_MRES_TIMEOUT);
+    CHECK(doneAt - sent < learned + air_us(19200, 8) + air_us(19200, n) + 2U * RTU_MASTER_TICK_US + 100U);
+
+    CHECK(RTUMaster_SlaveStats(&line, 3, &st) == RTU_OK);
+    CHECK(st.samples == 0 && st.timeouts == 1 && st.timeoutUs == lineTimeout);
+
+    /* the late answer is drained, the next request waits for it */
+    RTU_MasterReq_t next = read_req(3);
+    unsigned tx = txCount;
+    CHECK(RTUMaster_Submit(&line, &next) == RTU_OK);
+    run_for(500);
+    RTUMaster_RxBytes(&line, f, n);
+    CHECK(txCount == tx && line.count.stray == n);
+    run_for(learned + air_us(19200, n) + 2000U);
+    CHECK(txCount == tx + 1);
+    run_for(air_us(19200, 8) + turn);
+    RTUMaster_RxFrame(&line, f, n);
+    CHECK(next.result == RTU_MRES_OK);
+
+    RTUMaster_ResetStats(&line);
+    CHECK(RTUMaster_SlaveStats(&line, 3, &st) == RTU_NOACTIVE);
+    CHECK(RTUMaster_SlaveStats(&line, RTU_BROADCAST_ID, &st) == RTU_ERR);
+#else
+    CHECK(RTUMaster_SlaveStats(&line, 3, &st) == RTU_ERR);
+#endif
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    unsigned iterations = (argc > 1) ? (unsigned)strtoul(argv[1], NULL, 0) : 200000U;
+
+    test_wheel(iterations);
+#ifndef WHEEL_ONLY
+    test_results();
+    test_writes();
+    test_queue();
+    test_adaptive();
+#endif
+
+    printf("checks %u failed %u\n", checks, fails);
+    return fails != 0;
+}
+"""
+
+VARIANTS = (
+    ("fixed", []),
+    ("adaptive", ["RTU_MASTER_ADAPTIVE=1"]),
+    ("small-wheel", ["RTU_MASTER_WHEEL_BITS=2", "RTU_MASTER_WHEEL_LEVELS=3", "WHEEL_ONLY"]),
+)
+
+
+def build(args, tmp, name, defines):
+    drv = os.path.join(tmp, "mastertest.c")
+    if not os.path.exists(drv):
+        with open(drv, "w") as f:
+            f.write(TEST)
+
+    exe = os.path.join(tmp, "mastertest_" + name.replace("-", "_"))
+    cmd = ([args.cc] + shlex.split(args.cflags) + ["-DSEED=%dULL" % args.seed] +
+           ["-D" + d for d in defines + args.define] +
+           ["-I" + os.path.join(ROOT, "include"), "-I" + os.path.join(ROOT, "src"), drv,
+            os.path.join(ROOT, "src", "RtuKernels.c"), "-o", exe])
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if res.returncode != 0:
+        raise RuntimeError("%s\n%s" % (" ".join(cmd), res.stderr.strip()))
+    return exe
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Self-checking tests of the timer wheel and master line")
+    ap.add_argument("--cc", default=os.environ.get("CC", "cc"), help="compiler (default: $CC or cc)")
+    ap.add_argument("--cflags", default="-O2 -Wall", help="compiler flags (default: -O2 -Wall)")
+    ap.add_argument("--define", action="append", default=[], help="NAME=VALUE for every build")
+    ap.add_argument("--seed", type=int, default=1, help="seed of the randomized wheel test (default 1)")
+    ap.add_argument("--iterations", type=int, default=200000, help="wheel test operations (default 200000)")
+    args = ap.parse_args()
+
+    if args.seed == 0:
+        sys.exit("rtu_mastertest: --seed must not be 0")
+    if shutil.which(args.cc) is None:
+        sys.exit("rtu_mastertest: '%s' not found" % args.cc)
+
+    tmp = tempfile.mkdtemp(prefix="rtu_mastertest_")
+    failed = []
+    try:
+        for name, defines in VARIANTS:
+            exe = build(args, tmp, name, defines)
+            res = subprocess.run([exe, str(args.iterations)], stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                 universal_newlines=True, timeout=300)
+            out = (res.stdout + res.stderr).strip()
+            print("%-12s %s" % (name, out.splitlines()[-1] if out else "no output"))
+            if res.returncode != 0:
+                failed.append(name)
+                for ln in out.splitlines()[:-1]:
+                    print("    " + ln)
+    except (RuntimeError, OSError, subprocess.TimeoutExpired) as e:
+        sys.exit("rtu_mastertest: %s" % e)
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+    if failed:
+        sys.exit("rtu_mastertest: failed: %s" % ", ".join(failed))
+    print("all master checks passed")
+
+
+if __name__ == "__main__":
+    main()
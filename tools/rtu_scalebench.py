@@ -0,0 +1,347 @@
+#!/usr/bin/env python3
+"""
+rtu_scalebench.py - scaling benchmark for the multi-line master runtime
+
+Builds a host program from src/RtuMaster.c (RTU_MASTER_RUNTIME) and
+src/RtuSlave.c. For every line count it opens that many pseudo-terminal
+pairs, forks one RtuSlave.c slave per pty (framing requests on the t3.5
+silence) and lets one runtime poll all of them for --seconds. Meanwhile,
+--readers threads read the whole tag table without locks and check every
+value.
+
+Reported per line count: completed transactions per second, the same per
+line, the scaling efficiency against one line (100 % = linear), timeouts,
+reads per second and bad reads (must be 0). Each pty slave costs one
+process, so linear scaling needs as many free cores as lines for the
+slaves, plus cores for the runtime threads.
+
+Usage:
+    python3 tools/rtu_scalebench.py
+    python3 tools/rtu_scalebench.py --lines 1,4,16,32 --model sharded --shards 4 --cpus 0-3
+    python3 tools/rtu_scalebench.py --define RTU_MASTER_ADAPTIVE=1
+"""
+
+import argparse
+import os
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+BENCH = r"""
+#define _GNU_SOURCE /* posix_openpt() */
+#include "RtuMaster.h"
+#include "RtuSlave.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define REGS 100
+
+static int slave_fd = -1;
+static RTU_Runtime_t *rt;
+static RTU_TagConf_t *tags;
+static size_t tag_count;
+static volatile int done;
+static unsigned long reads[64], bad[64];
+
+int RTU_Transmit(uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = write(slave_fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        size -= (size_t)n;
+    }
+    return 0;
+}
+
+static void slave_main(int fd, long gap_us)
+{
+    static uint16_t hold[REGS];
+    static RTU_RegisterMap_t map[REGS];
+
+    slave_fd = fd;
+    RTUSlave_Init();
+    for (int i = 0; i < REGS; i++)
+    {
+        hold[i] = (uint16_t)i;
+        map[i].addr = (uint16_t)i;
+        map[i].permiss = RTU_PERMISS_OR;
+        map[i].data = &hold[i];
+    }
+    if (RTUSlave_RegisterHoldReg(map, REGS) != RTU_OK)
+        _exit(4);
+
+    uint8_t frame[256];
+    size_t len = 0;
+    for (;;)
+    {
+        fd_set rd;
+        FD_ZERO(&rd);
+        FD_SET(fd, &rd);
+        struct timeval tv = {gap_us / 1000000, gap_us % 1000000};
+        int r = select(fd + 1, &rd, NULL, NULL, len ? &tv : NULL);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            _exit(5);
+        if (r == 0 || len == sizeof(frame))
+        {
+            RTUSlave_ReceiveCallback(frame, len);
+            RTUSlave_TimerHandler();
+            len = 0;
+            continue;
+        }
+        ssize_t n = read(fd, &frame[len], sizeof(frame) - len);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+            _exit(0);
+        len += (size_t)n;
+    }
+}
+
+static void *reader_main(void *arg)
+{
+    size_t me = (size_t)arg;
+    uint16_t v[REGS];
+    while (!done)
+    {
+        for (size_t i = 0; i < tag_count; i++)
+        {
+            if (RTUMaster_TagRead(rt, i, v, NULL) != RTU_OK)
+                continue;
+            reads[me]++;
+            for (uint16_t k = 0; k < tags[i].num; k++)
+            {
+                if (v[k] != tags[i].addr + k)
+                {
+                    bad[me]++;
+                    break;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/* argv: lines model shards cpus(-|a,b,..) seconds tagsPerLine qty gap_us baud readers */
+int main(int argc, char **argv)
+{
+    if (argc != 11)
+        return 2;
+
+    size_t lines = (size_t)atoi(argv[1]);
+    double seconds = atof(argv[5]);
+    size_t per_line = (size_t)atoi(argv[6]);
+    uint16_t qty = (uint16_t)atoi(argv[7]);
+    long gap_us = atol(argv[8]);
+    uint32_t baud = (uint32_t)atol(argv[9]);
+    size_t readers = (size_t)atoi(argv[10]);
+    if (lines == 0 || per_line == 0 || qty == 0 || qty > REGS || readers > 64)
+        return 2;
+
+    int cpus[256];
+    size_t ncpu = 0;
+    for (char *p = strtok(argv[4], ","); p != NULL && strcmp(p, "-") != 0 && ncpu < 256; p = strtok(NULL, ","))
+        cpus[ncpu++] = atoi(p);
+
+    RTU_LineConf_t *lc = calloc(lines, sizeof(*lc));
+    pid_t *pids = calloc(lines, sizeof(*pids));
+    char (*paths)[64] = calloc(lines, sizeof(*paths));
+    tag_count = lines * per_line;
+    tags = calloc(tag_count, sizeof(*tags));
+
+    for (size_t i = 0; i < lines; i++)
+    {
+        int m = posix_openpt(O_RDWR | O_NOCTTY);
+        if (m < 0 || grantpt(m) != 0 || unlockpt(m) != 0)
+            return 3;
+        snprintf(paths[i], sizeof(paths[i]), "%s", ptsname(m));
+        pids[i] = fork();
+        if (pids[i] == 0)
+            slave_main(m, gap_us);
+        close(m);
+
+        lc[i].path = paths[i];
+        lc[i].baud = baud;
+        lc[i].parity = 'N';
+        lc[i].stopBits = 1;
+        lc[i].timeoutUs = 200000;
+        for (size_t k = 0; k < per_line; k++)
+        {
+            RTU_TagConf_t *t = &tags[i * per_line + k];
+            t->line = i;
+            t->id = 1;
+            t->func = RTU_FUNC_READ_HOLD_REGS;
+            t->addr = (uint16_t)((k * 7) % (REGS - qty + 1));
+            t->num = qty;
+        }
+    }
+
+    RTU_RuntimeConf_t conf = {
+        .model = strcmp(argv[2], "sharded") == 0 ? RTU_RT_SHARDED : RTU_RT_THREAD_PER_LINE,
+        .shards = (size_t)atoi(argv[3]),
+        .cpus = ncpu ? cpus : NULL,
+        .cpuCount = ncpu,
+    };
+    rt = RTUMaster_RuntimeCreate(&conf, lc, lines, tags, tag_count);
+    if (rt == NULL)
+        return 6;
+
+    pthread_t th[64];
+    for (size_t i = 0; i < readers; i++)
+        pthread_create(&th[i], NULL, reader_main, (void *)i);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (RTUMaster_RuntimeStart(rt) != RTU_OK)
+        return 7;
+    struct timespec d = {(time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9)};
+    nanosleep(&d, NULL);
+    RTUMaster_RuntimeStop(rt);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    done = 1;
+    for (size_t i = 0; i < readers; i++)
+        pthread_join(th[i], NULL);
+
+    unsigned long ok = 0, to = 0, err = 0, r = 0, b = 0;
+    for (size_t i = 0; i < lines; i++)
+    {
+        RTU_MasterCounters_t c;
+        RTUMaster_RuntimeCounters(rt, i, &c);
+        ok += c.ok;
+        to += c.timeouts;
+        err += c.crcErrors + c.badResponses + c.exceptions;
+    }
+    for (size_t i = 0; i < readers; i++)
+    {
+        r += reads[i];
+        b += bad[i];
+    }
+
+    RTUMaster_RuntimeDestroy(rt);
+    for (size_t i = 0; i < lines; i++)
+    {
+        kill(pids[i], SIGTERM);
+        waitpid(pids[i], NULL, 0);
+    }
+
+    free(tags);
+    free(paths);
+    free(pids);
+    free(lc);
+
+    double el = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%lu %lu %lu %lu %lu %.6f\n", ok, to, err, r, b, el);
+    return 0;
+}
+"""
+
+
+def parse_cpus(text):
+    if not text:
+        return "-"
+    cpus = []
+    for part in text.split(","):
+        if "-" in part:
+            lo, hi = part.split("-", 1)
+            cpus.extend(range(int(lo), int(hi) + 1))
+        else:
+            cpus.append(int(part))
+    return ",".join(str(c) for c in cpus)
+
+
+def build(args, tmp):
+    drv = os.path.join(tmp, "bench.c")
+    exe = os.path.join(tmp, "bench")
+    with open(drv, "w") as f:
+        f.write(BENCH)
+    cmd = ([args.cc] + shlex.split(args.cflags) + ["-DRTU_MASTER_RUNTIME=1"] + ["-D" + d for d in args.define] +
+           ["-I" + os.path.join(ROOT, "include"), drv,
+            os.path.join(ROOT, "src", "RtuMaster.c"), os.path.join(ROOT, "src", "RtuSlave.c"),
+            os.path.join(ROOT, "src", "RtuKernels.c"), "-o", exe, "-pthread"])
+    res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if res.returncode != 0:
+        raise RuntimeError("%s\n%s" % (" ".join(cmd), res.stderr.strip()))
+    return exe
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Measure how the master runtime scales with lines and cores")
+    ap.add_argument("--lines", default="1,2,4,8,16", help="comma separated line counts (default 1,2,4,8,16)")
+    ap.add_argument("--model", choices=("thread", "sharded"), default="thread",
+                    help="thread per line or sharded epoll (default thread)")
+    ap.add_argument("--shards", type=int, default=0, help="sharded: threads, 0 = one per online CPU")
+    ap.add_argument("--cpus", default="", help="CPU list for the runtime threads, e.g. 0-3,8 (default: no affinity)")
+    ap.add_argument("--seconds", type=float, default=3.0, help="run time per line count (default 3)")
+    ap.add_argument("--tags", type=int, default=4, help="tags per line, polled back to back (default 4)")
+    ap.add_argument("--qty", type=int, default=10, help="holding registers per tag (default 10)")
+    ap.add_argument("--baud", type=int, default=115200, help="line speed, sets the master's t3.5 (default 115200)")
+    ap.add_argument("--gap-us", type=int, default=1750, help="slave frame gap in us (default 1750)")
+    ap.add_argument("--readers", type=int, default=2, help="lock-free tag reader threads (default 2)")
+    ap.add_argument("--cc", default=os.environ.get("CC", "cc"), help="compiler (default: $CC or cc)")
+    ap.add_argument("--cflags", default="-O2", help="compiler flags (default: -O2)")
+    ap.add_argument("--define", action="append", default=[], help="NAME=VALUE for the build")
+    args = ap.parse_args()
+
+    try:
+        counts = [int(n) for n in args.lines.split(",")]
+        cpus = parse_cpus(args.cpus)
+        if min(counts) < 1 or not 1 <= args.qty <= 100 or args.tags < 1 or not 0 <= args.readers <= 64:
+            raise ValueError("--lines >= 1, --qty 1..100, --tags >= 1, --readers 0..64")
+    except ValueError as e:
+        sys.exit("rtu_scalebench: %s" % e)
+
+    if shutil.which(args.cc) is None:
+        sys.exit("rtu_scalebench: '%s' not found" % args.cc)
+
+    tmp = tempfile.mkdtemp(prefix="rtu_scalebench_")
+    rows = []
+    try:
+        exe = build(args, tmp)
+        for n in counts:
+            cmd = [exe, str(n), args.model, str(args.shards), cpus, str(args.seconds), str(args.tags),
+                   str(args.qty), str(args.gap_us), str(args.baud), str(args.readers)]
+            res = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True,
+                                 timeout=args.seconds + 30)
+            if res.returncode != 0:
+                raise RuntimeError("bench exited with %d for %d lines %s" % (res.returncode, n, res.stderr.strip()))
+            ok, to, err, reads, bad, el = res.stdout.split()
+            rows.append((n, int(ok), int(to), int(err), int(reads), int(bad), float(el)))
+    except (RuntimeError, OSError, ValueError, subprocess.TimeoutExpired) as e:
+        sys.exit("rtu_scalebench: %s" % e)
+    finally:
+        shutil.rmtree(tmp, ignore_errors=True)
+
+    print("%s model, %d tags x %d regs per line, %d cpus online, %s" %
+          (args.model, args.tags, args.qty, os.cpu_count() or 0, " ".join([args.cflags] + args.define)))
+    print("%6s %10s %10s %7s %8s %6s %12s %6s" % ("lines", "tx/s", "tx/s/line", "scale", "t/o", "err",
+                                                  "reads/s", "bad"))
+    base = None
+    for n, ok, to, err, reads, bad, el in rows:
+        tps = ok / el if el > 0 else 0.0
+        if base is None:
+            base = tps / n if n else 0.0
+        scale = 100.0 * tps / (base * n) if base else 0.0
+        print("%6d %10.1f %10.1f %6.1f%% %8d %6d %12.0f %6d" % (n, tps, tps / n, scale, to, err, reads / el, bad))
+
+
+if __name__ == "__main__":
+    main()